@@ -0,0 +1,94 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSet>
+#include <QString>
+
+/**
+ * @brief 进程内的字符串驻留池：内容相同的字符串共用同一块缓冲区
+ *
+ * 大量重复的短字符串（发送者昵称、头像路径、时间文本等）在解码或生成后经 intern() 换成池中的同一份，
+ * 多余的副本随即释放。池本身只持有一份引用：不再有消息引用的字符串在池增长到阈值时被清理。
+ * 可在数据库线程与界面线程同时使用。
+ */
+class StringPool
+{
+public:
+    struct Stats {
+        qsizetype entries = 0;    // 池中字符串数
+        qint64 lookups = 0;       // intern 调用次数（不含空串与超长串）
+        qint64 hits = 0;          // 命中已有字符串的次数
+        qint64 bytesShared = 0;   // 命中后释放的重复缓冲区字节数（累计）
+    };
+
+    static StringPool &instance() {
+        static StringPool pool;
+        return pool;
+    }
+
+    // 返回与 value 内容相同的池中字符串；空串与超过 kMaxLength 的字符串原样返回
+    QString intern(const QString &value) {
+        if (value.isEmpty() || value.size() > kMaxLength) return value;
+
+        QMutexLocker locker(&m_mutex);
+        ++m_stats.lookups;
+        const auto it = m_strings.constFind(value);
+        if (it != m_strings.constEnd()) {
+            ++m_stats.hits;
+            if (!value.isSharedWith(*it)) m_stats.bytesShared += bufferBytes(value);
+            return *it;
+        }
+        if (m_strings.size() >= m_purgeThreshold) purgeUnusedLocked();
+        m_strings.insert(value);
+        return value;
+    }
+
+    // 移除只被池自身引用的字符串
+    void purgeUnused() {
+        QMutexLocker locker(&m_mutex);
+        purgeUnusedLocked();
+    }
+
+    Stats stats() const {
+        QMutexLocker locker(&m_mutex);
+        Stats stats = m_stats;
+        stats.entries = m_strings.size();
+        return stats;
+    }
+
+    static constexpr qsizetype kMaxLength = 512;        // 超长字符串不驻留（正文等很少重复）
+    static constexpr qsizetype kInitialPurgeThreshold = 4096;
+
+private:
+    StringPool() = default;
+    StringPool(const StringPool &) = delete;
+    StringPool &operator=(const StringPool &) = delete;
+
+    // QString 堆缓冲区的大致字节数（头部 + UTF-16 内容 + 结尾 0）
+    static qint64 bufferBytes(const QString &value) {
+        return 16 + (value.size() + 1) * qint64(sizeof(char16_t));
+    }
+
+    void purgeUnusedLocked() {
+        for (auto it = m_strings.begin(); it != m_strings.end();) {
+            if (it->isDetached()) it = m_strings.erase(it);
+            else ++it;
+        }
+        // 清理后仍然很满时放宽阈值，避免每次插入都全表扫描
+        m_purgeThreshold = qMax(kInitialPurgeThreshold, m_strings.size() * 2);
+    }
+
+    mutable QMutex m_mutex;
+    QSet<QString> m_strings;
+    qsizetype m_purgeThreshold = kInitialPurgeThreshold;
+    Stats m_stats;
+};
+
+// 便捷函数
+inline QString internString(const QString &value) {
+    return StringPool::instance().intern(value);
+}
+
+#endif // STRINGPOOL_H
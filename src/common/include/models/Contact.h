@@ -123,6 +123,8 @@ struct Contact {
     }
 };
 
+// 成员都是隐式共享的 Qt 类型或标量：容器扩容、头部插入时按内存整体搬移，不逐个移动构造
+Q_DECLARE_TYPEINFO(Contact, Q_RELOCATABLE_TYPE);
 Q_DECLARE_METATYPE(Contact)
 
 
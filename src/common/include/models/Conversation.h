@@ -21,6 +21,10 @@ struct Conversation {
     int unreadCount = 0;
     bool isTop = false;
 
+    // 未读 @ 提及（来自 message_mentions，不随会话表持久化）
+    int unreadMentionCount = 0;
+    qint64 firstUnreadMentionId = 0;
+
     Conversation() = default;
     
     explicit Conversation(const QSqlQuery& query) {
@@ -93,6 +97,10 @@ struct Conversation {
     bool hasUnread() const {
         return unreadCount > 0;
     }
+
+    bool hasUnreadMention() const {
+        return unreadMentionCount > 0;
+    }
 };
 
 
@@ -110,9 +118,13 @@ enum ConversationRole {
     UnreadCountRole,
     IsTopRole,
     IsGroupRole,
-    TargetIdRole
+    TargetIdRole,
+    UnreadMentionCountRole,
+    FirstUnreadMentionIdRole
 };
 
+// 成员都是隐式共享的 Qt 类型或标量：容器扩容、头部插入时按内存整体搬移，不逐个移动构造
+Q_DECLARE_TYPEINFO(Conversation, Q_RELOCATABLE_TYPE);
 Q_DECLARE_METATYPE(Conversation)
 
 
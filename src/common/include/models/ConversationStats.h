@@ -0,0 +1,60 @@
+#ifndef CONVERSATIONSTATS_H
+#define CONVERSATIONSTATS_H
+
+#include <QtSql/QSqlQuery>
+#include "FormatFileSize.h"
+
+// 会话统计（conversation_stats 表），随消息写入增量维护，读取无需扫描消息表
+struct ConversationStats {
+    qint64 conversationId = 0;
+    int messageCount = 0;     // 消息总数
+    int textCount = 0;        // 文本消息数
+    int imageCount = 0;       // 图片消息数
+    int videoCount = 0;       // 视频消息数
+    int fileCount = 0;        // 文件消息数
+    int voiceCount = 0;       // 语音消息数
+    qint64 mediaBytes = 0;    // 媒体/文件总字节数
+    qint64 firstMsgTime = 0;  // 第一条消息时间
+    qint64 lastMsgTime = 0;   // 最后一条消息时间
+
+    ConversationStats() = default;
+
+    explicit ConversationStats(const QSqlQuery& query) {
+        conversationId = query.value("conversation_id").toLongLong();
+        messageCount = query.value("message_count").toInt();
+        textCount = query.value("text_count").toInt();
+        imageCount = query.value("image_count").toInt();
+        videoCount = query.value("video_count").toInt();
+        fileCount = query.value("file_count").toInt();
+        voiceCount = query.value("voice_count").toInt();
+        mediaBytes = query.value("media_bytes").toLongLong();
+        firstMsgTime = query.value("first_msg_time").toLongLong();
+        lastMsgTime = query.value("last_msg_time").toLongLong();
+    }
+
+    // 合并另一个分片中同一会话的统计
+    void merge(const ConversationStats& other) {
+        if (other.messageCount <= 0) return;
+        messageCount += other.messageCount;
+        textCount += other.textCount;
+        imageCount += other.imageCount;
+        videoCount += other.videoCount;
+        fileCount += other.fileCount;
+        voiceCount += other.voiceCount;
+        mediaBytes += other.mediaBytes;
+        if (firstMsgTime == 0 || (other.firstMsgTime > 0 && other.firstMsgTime < firstMsgTime))
+            firstMsgTime = other.firstMsgTime;
+        lastMsgTime = qMax(lastMsgTime, other.lastMsgTime);
+    }
+
+    int mediaCount() const { return imageCount + videoCount; }
+
+    QString formattedMediaBytes() const {
+        return formatFileSize(mediaBytes);
+    }
+};
+
+Q_DECLARE_METATYPE(ConversationStats)
+
+
+#endif // CONVERSATIONSTATS_H
@@ -0,0 +1,30 @@
+#ifndef MENTIONSUMMARY_H
+#define MENTIONSUMMARY_H
+
+#include <QtSql/QSqlQuery>
+
+// 某个会话中当前用户的未读 @ 提及（message_mentions 表按会话汇总）
+struct MentionSummary {
+    qint64 conversationId = 0;
+    int unreadCount = 0;          // 未读提及数
+    qint64 firstMessageId = 0;    // 最早一条未读提及的消息ID（跳转定位用）
+    qint64 firstMsgTime = 0;      // 最早一条未读提及的时间
+
+    MentionSummary() = default;
+
+    explicit MentionSummary(const QSqlQuery& query) {
+        conversationId = query.value("conversation_id").toLongLong();
+        unreadCount = query.value("unread_count").toInt();
+        firstMessageId = query.value("message_id").toLongLong();
+        firstMsgTime = query.value("first_msg_time").toLongLong();
+    }
+
+    bool isValid() const {
+        return conversationId > 0 && unreadCount > 0;
+    }
+};
+
+Q_DECLARE_METATYPE(MentionSummary)
+
+
+#endif // MENTIONSUMMARY_H
@@ -0,0 +1,49 @@
+#ifndef MESSAGEDAYSUMMARY_H
+#define MESSAGEDAYSUMMARY_H
+
+#include <QtSql/QSqlQuery>
+#include <QDate>
+
+// 会话按天的消息汇总（message_day_summary 表），用于跳转到日期和时间轴密度显示
+struct MessageDaySummary {
+    qint64 conversationId = 0;
+    int day = 0;                // 本地日期，格式 yyyyMMdd
+    int messageCount = 0;       // 当天消息数
+    qint64 firstMessageId = 0;  // 当天第一条消息ID
+    qint64 firstMsgTime = 0;    // 当天第一条消息时间戳
+    qint64 lastMessageId = 0;   // 当天最后一条消息ID
+    qint64 lastMsgTime = 0;     // 当天最后一条消息时间戳
+
+    MessageDaySummary() = default;
+
+    explicit MessageDaySummary(const QSqlQuery& query) {
+        conversationId = query.value("conversation_id").toLongLong();
+        day = query.value("day").toInt();
+        messageCount = query.value("message_count").toInt();
+        firstMessageId = query.value("first_message_id").toLongLong();
+        firstMsgTime = query.value("first_msg_time").toLongLong();
+        lastMessageId = query.value("last_message_id").toLongLong();
+        lastMsgTime = query.value("last_msg_time").toLongLong();
+    }
+
+    QDate date() const {
+        return dateForKey(day);
+    }
+
+    static QDate dateForKey(int dayKey) {
+        return QDate(dayKey / 10000, dayKey / 100 % 100, dayKey % 100);
+    }
+
+    static int dayKey(const QDate& date) {
+        return date.year() * 10000 + date.month() * 100 + date.day();
+    }
+
+    bool isValid() const {
+        return conversationId > 0 && day > 0;
+    }
+};
+
+Q_DECLARE_METATYPE(MessageDaySummary)
+
+
+#endif // MESSAGEDAYSUMMARY_H
@@ -0,0 +1,57 @@
+#ifndef MODELUPDATESCHEDULER_H
+#define MODELUPDATESCHEDULER_H
+
+#include <QAbstractItemModel>
+#include <QList>
+#include <QPointer>
+#include <QTimer>
+#include <QVector>
+
+/**
+ * @class ModelUpdateScheduler
+ * @brief 按显示帧合并模型的 dataChanged
+ *
+ * 模型（或委托）把变化的行与角色记为脏，每帧最多发出一次：相邻的脏行合并为一个区间，
+ * 角色取并集。消息洪峰时同一行的多次更新只触发一次重绘。
+ * 模型的行结构变化（插入、删除、移动）前先发出积压的更新，保证行号有效；整体重置时直接丢弃。
+ */
+class ModelUpdateScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats {
+        qint64 received = 0; // markDirty/markAllDirty 调用次数
+        qint64 emitted = 0;  // 实际发出的 dataChanged 次数
+    };
+
+    static constexpr int kFrameIntervalMs = 16;
+
+    explicit ModelUpdateScheduler(QAbstractItemModel *model = nullptr, QObject *parent = nullptr);
+
+    // 更换目标模型，积压的更新随之丢弃
+    void setModel(QAbstractItemModel *model);
+    QAbstractItemModel *model() const { return m_model; }
+
+    // roles 为空表示所有角色
+    void markDirty(int row, const QList<int> &roles = QList<int>());
+    void markAllDirty();
+
+    void flush();   // 立即发出积压的更新
+    void discard(); // 丢弃积压的更新
+
+    Stats stats() const { return m_stats; }
+
+private:
+    void schedule();
+
+    QPointer<QAbstractItemModel> m_model;
+    QTimer m_timer;
+    QVector<int> m_rows;       // 脏行（可重复，发出时排序去重）
+    QList<int> m_roles;        // 脏角色并集
+    bool m_allRoles = false;   // 有更新未指定角色
+    bool m_allRows = false;    // 整个模型需要刷新
+    Stats m_stats;
+};
+
+#endif // MODELUPDATESCHEDULER_H
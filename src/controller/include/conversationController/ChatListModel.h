@@ -3,8 +3,19 @@
 
 #include <QAbstractListModel>
 #include <QVector>
+#include <QHash>
 #include "Conversation.h"
+#include "MentionSummary.h"
+#include "ModelUpdateScheduler.h"
 
+/**
+ * 会话列表模型
+ * 会话按 (is_top, last_message_time) 分页加载：滚动到底部时视图通过 canFetchMore/fetchMore
+ * 请求下一页（fetchMoreRequested 由控制器转发到数据库）；会话ID到行号的哈希索引让单个会话的更新为 O(1)。
+ * 已加载部分始终保持与分页查询相同的顺序：新消息、置顶切换只把该行移到新位置（beginMoveRows），
+ * 不整体重置；排到已加载部分之后的行被移除，由后续分页重新取回。
+ * 摘要、未读数等字段的变化经 ModelUpdateScheduler 每帧合并发出一次 dataChanged。
+ */
 class ChatListModel : public QAbstractListModel
 {
     Q_OBJECT
@@ -17,15 +28,28 @@ public:
     QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
     bool setData(const QModelIndex &index, const QVariant &value, int role) override;
     QHash<int, QByteArray> roleNames() const override;
+    bool canFetchMore(const QModelIndex &parent) const override;
+    void fetchMore(const QModelIndex &parent) override;
 
-    // 会话管理
+    // 分页加载：首页整体替换，后续页追加（已在列表中的会话就地更新）
+    void resetConversations(const QList<Conversation> &conversations, bool hasMore);
+    void appendConversations(const QList<Conversation> &conversations, bool hasMore);
+    // 下一页的游标：最后一行会话（列表为空时返回无效会话）
+    Conversation lastConversation() const;
+
+    // 会话管理（新增与更新都按排序位置放置）
     void addConversation(const Conversation &conversation);
     void updateConversation(const Conversation &conversation);
-    void updateLastMessage(qint64 conversationId, const QString &message, qint64 time);
+    // 更新最后一条消息并累加未读数；会话不在已加载部分时返回 false
+    bool updateLastMessage(qint64 conversationId, const QString &message, qint64 time, int unreadIncrement = 0);
     void updateUnreadCount(qint64 conversationId, int count);
-    void updateTopStatus(qint64 conversationId, bool isTop);
+    // 会话不在已加载部分，或取消置顶后排到已加载部分之后时返回 false
+    bool updateTopStatus(qint64 conversationId, bool isTop);
+    // 以查询结果整体替换未读 @ 提及，不在结果中的会话清零
+    void setUnreadMentions(const QList<MentionSummary> &mentions);
+    void clearUnreadMentions(qint64 conversationId);
     void removeConversation(qint64 conversationId);
-    void clearAll();
+    void clearAll();    // 清空并停止分页
 
     // 查询方法
     Conversation getConversation(qint64 conversationId) const;
@@ -35,9 +59,28 @@ public:
     QModelIndex getConversationIndex(qint64 conversationId) const;
     QModelIndex getConversationIndexByContactId(qint64 contactId) const;
 
+    // 字段更新的收发计数（收到的更新次数 / 实际发出的 dataChanged 次数）
+    ModelUpdateScheduler::Stats updateStats() const { return m_updates.stats(); }
+
+
+signals:
+    void fetchMoreRequested(); // 视图滚动到已加载部分的末尾
 
 private:
+    void rebuildRowIndex(int fromRow = 0);
+    // 与分页查询一致的顺序：is_top DESC, last_message_time DESC, conversation_id DESC
+    static bool sortsBefore(const Conversation &a, const Conversation &b);
+    // 新会话应插入的行；排在已加载部分之后（且还有未加载的会话）时返回 -1
+    int insertionRow(const Conversation &conversation) const;
+    // 把排序键已更新的 row 行（previous 为更新前的值）移到排序位置，返回新行号；
+    // 排到已加载部分之后时移除该行并返回 -1
+    int moveToSortedRow(int row, const Conversation &previous);
+
     QVector<Conversation> m_conversations;
+    QHash<qint64, int> m_rowOfConversation; // 会话ID -> 行号
+    bool m_hasMore = false;  // 数据库中还有未加载的会话
+    bool m_fetching = false; // 下一页请求进行中
+    ModelUpdateScheduler m_updates; // 按帧合并 dataChanged
 };
 
 #endif // CHATLISTMODEL_H
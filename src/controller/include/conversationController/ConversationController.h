@@ -26,11 +26,15 @@ public:
     ChatListModel* chatListModel() const { return m_chatListModel; }
 
     // 异步操作：会话管理相关
-    void loadConversations(int reqId);    // 加载所有会话
-    void createSingleChat(Contact contact); // 创建单聊会话
+    // 重新加载会话列表首页：至少覆盖当前已加载的行数与 minCount，滚动位置与选中项不会落到未加载部分
+    void loadConversations(int reqId, int minCount = 0);
+    void loadMoreConversations();         // 加载下一页（模型 fetchMore 时触发）
+    void createSingleChat(const Contact &contact); // 创建单聊会话
     void createGroupChat(qint64 groupId); // 创建群聊会话
 
     void clearUnreadCount(qint64 conversationId);      // 清空未读消息数
+    // 新消息写入后就地更新会话摘要（最后一条消息、时间、未读数）并移动该行，不重新加载列表
+    void handleMessageInserted(qint64 conversationId, const QString &content, qint64 timestamp);
 
     void deleteConversation(qint64 conversationId);    // 删除会话
     void handleToggleTop(qint64 conversationId);       // 处理置顶切换
@@ -54,7 +58,9 @@ signals:
 
 private slots:
     // 数据库操作结果处理
-    void onAllConversationsLoaded(int reqId, const QList<Conversation>& conversations); // 所有会话加载完成
+    void onConversationsPageLoaded(int reqId, bool firstPage, const QList<Conversation>& conversations,
+                                   bool hasMore);                              // 一页会话加载完成
+    void onConversationLocated(int reqId, const Conversation& conversation, int row); // 会话定位结果
     void onConversationSaved(int reqId, bool success, const QString& error);   // 会话保存结果
     void onConversationUpdated(int reqId, bool success, const QString& error); // 会话更新结果
     void onConversationDeleted(int reqId, bool success, const qint64& conversationId); // 会话删除结果
@@ -75,6 +81,8 @@ private:
     qint64 m_currentConversationId = -1;    // 当前选中会话ID
     QAtomicInteger<int> m_reqIdCounter;     // 请求ID计数器（线程安全）
     QHash<int, QString> m_pendingOperations;// 待处理操作（reqId->操作类型）
+    QHash<int, Conversation> m_pendingChats;// 定位后不存在需新建的单聊（reqId->会话）
+    int m_fetchReqId = -1;                  // 进行中的下一页请求，-1 表示无
 };
 
 #endif // CONVERSATIONCONTROLLER_H
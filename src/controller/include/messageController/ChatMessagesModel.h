@@ -2,8 +2,10 @@
 #define CHATMESSAGESMODEL_H
 
 #include <QAbstractListModel>
+#include <QTimer>
 #include <QVector>
 #include "Message.h"
+#include "MessageRenderRecord.h"
 
 class ChatMessagesModel : public QAbstractListModel
 {
@@ -35,7 +37,8 @@ public:
         HasThumbnailRole,
         FormattedFileSizeRole,
         FormattedDurationRole,
-        FullMessageRole
+        FullMessageRole,
+        RenderRecordRole // const MessageRenderRecord*，指向模型内的记录，绘制时不复制消息
     };
 
     explicit ChatMessagesModel(QObject *parent = nullptr);
@@ -53,13 +56,28 @@ public:
     void removeMessage(int row);
     void removeMessageById(qint64 messageId);
     void updateMessage(const Message &message);
+    // 用 message 替换 ID 为 messageId 的行（本地消息保存后换成数据库分配的ID）
+    void replaceMessage(qint64 messageId, const Message &message);
     Message getMessage(int row) const;
     Message getMessageById(qint64 messageId) const;
 
     // 批量操作
     void addMessages(const QVector<Message> &messages);
+    // 整页历史消息插到窗口头部（按时间升序），只发一次插入通知，视图一次重新布局
+    void prependMessages(const QVector<Message> &messages);
     void clearAll();
 
+    // 消息窗口：模型只保存会话中连续的一段，不要求以最新消息结尾。
+    // 窗口最多保留 kMaxWindowMessages 条：超出上限时按块淘汰离视口较远（视口外行数较多）的一端，
+    // 视口所在的块不淘汰；被淘汰的一端标记为还有消息，滚动回去时由 loadMoreMessages / loadNewerMessages 按游标重新加载
+    void resetWindow(const QVector<Message> &messages, bool hasOlder, bool hasNewer);
+    // 视图当前可见的行范围，first 为 -1 表示未知（此时向尾部追加淘汰头部，向头部插入淘汰尾部）
+    void setVisibleRange(int first, int last);
+    void setHasOlder(bool hasOlder) { m_hasOlder = hasOlder; }
+    void setHasNewer(bool hasNewer) { m_hasNewer = hasNewer; }
+    bool hasOlder() const { return m_hasOlder; }   // 窗口之前是否还有更早的消息
+    bool hasNewer() const { return m_hasNewer; }   // 窗口之后是否还有更新的消息（false 表示窗口包含最新消息）
+
     // 查询方法
     int findMessageIndexById(qint64 messageId) const;
     bool containsMessage(qint64 messageId) const;
@@ -72,12 +90,57 @@ public:
     void setConversationId(qint64 conversationId);
     qint64 conversationId() const;
 
-    QVector<Message> m_messages; // 暂时放在public
+    // 窗口内全部消息（按时间升序）
+    QVector<Message> messages() const;
+    // 窗口末尾最多 count 条消息（按时间升序）
+    QVector<Message> tailMessages(int count) const;
+
+    static constexpr int kChunkSize = 64;           // 每块消息数
+    static constexpr int kMaxWindowMessages = 1024; // 窗口消息上限
 
 private:
-    // QVector<Message> m_messages;
+    // 一行：原始消息与由它生成的绘制记录
+    struct Row {
+        Message message;
+        MessageRenderRecord render;
+    };
+
+    Row makeRow(const Message &message) const;
+    QVector<Row> makeRows(const QVector<Message> &messages) const;
+    void refreshRenderRecord(Row &row) const;
+
+    const Row &rowAt(int row) const;
+    Row &rowAt(int row);
+    // 行号所在的块与块内偏移
+    void locate(int row, int *chunk, int *offset) const;
+    void rebuildChunkStarts();
+
+    void appendToChunks(const QVector<Row> &rows);
+    void prependToChunks(const QVector<Row> &rows);
+    // 超出上限时淘汰离视口较远的一端，一端不够时再淘汰另一端；appended 表示刚向尾部追加
+    void evictAwayFromViewport(bool appended);
+    // 从窗口头部/尾部整块淘汰，最多淘汰 maxRows 行
+    void evictFront(int maxRows);
+    void evictBack(int maxRows);
+    // row 及之后的行移动 delta 行时同步可见范围
+    void shiftVisibleRange(int row, int delta);
+
+    // 跨天后重新格式化全部时间文本（“HH:mm”变为“周X”等）
+    void refreshTimeTexts();
+    void scheduleMidnightRefresh();
+
+    // 分块存储：块按时间顺序排列，两端增删为均摊 O(1)；块内行数不固定（插入/删除后会有不满的块）
+    QList<QVector<Row>> m_chunks;
+    QVector<int> m_chunkStarts; // 每块第一条消息的行号
+    int m_count = 0;
+
     qint64 m_currentUserId = 0;
     qint64 m_currentConversationId = 0;
+    bool m_hasOlder = false;
+    bool m_hasNewer = false;
+    int m_visibleFirst = -1;
+    int m_visibleLast = -1;
+    QTimer m_midnightTimer;
 };
 
 #endif // CHATMESSAGESMODEL_H
@@ -9,13 +9,18 @@
 #include "Conversation.h"
 #include "DatabaseManager.h"
 #include "ChatMessagesModel.h"
+#include "MessageWindowCache.h"
 #include "Message.h"
 #include "MediaItem.h"
+#include "MessageDaySummary.h"
+#include "ConversationStats.h"
+#include "MentionSummary.h"
 #include "User.h"
 
 class ImageProcessor;
 class FileCopyProcessor;
 class VideoProcessor;
+class ConversationExporter;
 
 /**
  * @class MessageController
@@ -31,13 +36,13 @@ public:
     ~MessageController(); // 析构函数
 
     // 保存好友发来的消息----------------------
-    void saveMessage(Message msg);
+    void saveMessage(const Message &msg);
     // 获取属性值
     ChatMessagesModel* messagesModel() const { return m_messagesModel; }
     qint64 currentConversationId() const { return m_currentConversation.conversationId; }
 
     // 异步操作：会话管理、消息发送/处理等
-    void setCurrentConversation(Conversation conversation); // 设置当前会话
+    void setCurrentConversation(const Conversation &conversation); // 设置当前会话
     void setCurrentUser(int reqId, User user);            // 设置当前用户
 
     void sendTextMessage(const QString& content);         // 发送文本消息
@@ -64,8 +69,23 @@ public:
     void preprocessVideoBeforeSend(QStringList fileList);
 
     void loadRecentMessages(int limit = 30);      // 加载最近消息
-    void loadMoreMessages(int limit = 20);        // 加载更多历史消息
+    void loadMoreMessages(int limit = 20);        // 加载更多历史消息（窗口向前扩展）
+    void loadNewerMessages(int limit = 20);       // 窗口向后扩展（窗口不含最新消息时）
+    void loadMessagesAround(qint64 messageId, int before = 20, int after = 20); // 加载以某条消息为中心的窗口
+    void prefetchConversation(qint64 conversationId, int limit = 30); // 预取会话最近消息到窗口缓存（悬停/键盘选择时）
     void getMediaItems(qint64 conversationId);    // 获取会话中所有媒体项
+    void loadMediaWindow(qint64 conversationId, qint64 anchorMessageId, int radius = 40); // 以消息为中心加载媒体窗口
+    void loadMoreMedia(qint64 conversationId, const MediaItem &edge, bool older, int limit = 40); // 从窗口边缘向一侧扩展
+    void loadTimeline();                          // 加载当前会话按天的消息分布
+    void jumpToDate(const QDate &date, int limit = 30); // 跳转到指定日期（或其后最近有消息的一天）
+    void loadConversationStats(qint64 conversationId); // 加载会话统计（消息数、各类型数量、媒体占用）
+    void exportConversation(qint64 conversationId, const QString &outputPath, bool copyMedia = false); // 导出会话为 JSON Lines（后台流式写出）
+    void cancelExport();                          // 取消进行中的导出
+    void importHistory(const QString &archivePath); // 导入 JSON Lines 聊天记录（同一文件中断后再次导入会从检查点继续）
+    void cancelImport();                          // 取消（暂停）进行中的导入
+    void checkPendingImports();                   // 查询上次未完成的导入
+    void loadUnreadMentions();                    // 加载当前用户在各会话中的未读 @ 提及
+    void markMentionsRead(qint64 conversationId); // 会话中的 @ 提及标为已读
 
 public slots:
     // 处理UI操作
@@ -83,25 +103,56 @@ public slots:
 signals:
     // 操作结果信号
     void messageSaved();
+    void messageInserted(const Message& message); // 新消息已写入（会话列表据此就地更新摘要）
     void messageDeleted(bool success, const QString& error = QString()); // 消息删除结果
     void messagesLoaded(const QList<Message>& messages, bool hasMore);   // 消息列表加载结果
     void mediaItemsLoaded(const QList<MediaItem>& items);                // 媒体项加载结果
+    void mediaWindowLoaded(qint64 anchorMessageId, const QList<MediaItem>& items,
+                           bool hasOlder, bool hasNewer);                // 媒体窗口加载结果
+    void mediaPageLoaded(bool older, const QList<MediaItem>& items, bool hasMore); // 媒体窗口扩展结果
+    void timelineLoaded(const QList<MessageDaySummary>& summaries);      // 按天消息分布加载结果
+    void jumpedToMessage(qint64 messageId);                              // 跳转日期完成，messageId 为锚点消息
+    void conversationStatsLoaded(const ConversationStats& stats);        // 会话统计加载结果
+    void exportProgress(qint64 exportedCount, qint64 totalCount);         // 导出进度
+    void exportFinished(bool ok, const QString& reason, qint64 exportedCount); // 导出结束（成功、失败或取消）
+    void importProgress(qint64 importedCount, qint64 bytesRead, qint64 bytesTotal); // 导入进度
+    void importFinished(bool ok, const QString& reason, qint64 importedCount, qint64 skippedCount); // 导入结束
+    void pendingImportsFound(const QStringList& archivePaths);           // 存在未完成的导入
+    void unreadMentionsLoaded(const QList<MentionSummary>& mentions);     // 未读 @ 提及（按会话汇总）
 
     // -测试模拟发消息------------------------
-    void send(QVector<Message> messages);
+    void send(const QVector<Message> &messages);
 
 
 private slots:
     // 数据库操作结果处理
     void onMessageSaved(int reqId, bool ok, QString reason);
+    void onMessageInserted(int reqId, const Message& message);            // 新消息写入（更新窗口缓存并转发）
     void onMessageDeleted(int reqId, bool success, const QString& error); // 消息删除结果
-    void onMessagesLoaded(int reqId, const QList<Message>& messages);     // 消息列表加载结果
+    void onMessagesPageLoaded(int reqId, bool older, const QVector<Message>& messages, bool hasMore); // 消息分页加载结果
+    void onMessagesAroundLoaded(int reqId, qint64 anchorMessageId, const QVector<Message>& messages,
+                                bool hasOlder, bool hasNewer);            // 锚点窗口加载结果
     void onMediaItemsLoaded(int reqId, const QList<MediaItem>& items);    // 媒体项加载结果
+    void onMediaWindowLoaded(int reqId, qint64 anchorMessageId, const QList<MediaItem>& items,
+                             bool hasOlder, bool hasNewer);               // 媒体窗口加载结果
+    void onMediaPageLoaded(int reqId, bool older, const QList<MediaItem>& items, bool hasMore); // 媒体窗口扩展结果
+    void onDaySummariesLoaded(int reqId, const QList<MessageDaySummary>& summaries); // 按天汇总加载结果
+    void onMessagesAtDateLoaded(int reqId, qint64 anchorMessageId,
+                                const QVector<Message>& messages, bool hasNewer); // 跳转日期结果
+    void onConversationStatsLoaded(int reqId, const ConversationStats& stats); // 会话统计加载结果
+    void onExportProgress(int reqId, qint64 exportedCount, qint64 totalCount);  // 导出进度
+    void onExportFinished(int reqId, bool ok, const QString& reason, qint64 exportedCount); // 导出结束
+    void onImportProgress(int reqId, qint64 importedCount, qint64 bytesRead, qint64 bytesTotal); // 导入进度
+    void onImportFinished(int reqId, bool ok, const QString& reason,
+                          qint64 importedCount, qint64 skippedCount);   // 导入结束
+    void onPendingImportsLoaded(int reqId, const QStringList& archivePaths); // 未完成的导入
+    void onUnreadMentionsLoaded(int reqId, const QList<MentionSummary>& mentions); // 未读 @ 提及加载结果
     void onDbError(int reqId, const QString& error);                      // 数据库错误处理
 
 private:
     int generateReqId();   // 生成唯一请求ID
     void connectSignals(); // 连接信号槽
+    void submitMessage(const Message &message); // 本地发送：加入当前窗口并异步保存
     Message createMessage(const Conversation &conversation,
                           MessageType type,
                           const QString& content = QString(),
@@ -122,14 +173,20 @@ private:
     Conversation m_currentConversation; // 当前会话
     User currentUser;  // 当前登录用户
     bool loading;      // 加载状态标记
-    int currentOffset; // 消息加载偏移量（分页用）
     bool isSearchMode; // 是否搜索模式
 
     QHash<int, QString> pendingOperations;
 
+    MessageWindowCache m_windowCache;          // 各会话最近消息窗口，切换会话时直接换入
+    QHash<int, qint64> m_prefetchRequests;     // 预取请求 reqId -> 会话ID
+    QHash<int, qint64> m_pendingSends;         // 已显示、待保存的本地消息 reqId -> 临时消息ID
+
     ImageProcessor *imageProcessor;
     FileCopyProcessor *fileCopyProcessor;
     VideoProcessor *videoProcessor;
+    ConversationExporter *exporter;
+    int m_exportReqId = -1; // 进行中的导出请求，-1 表示无
+    int m_importReqId = -1; // 进行中的导入请求，-1 表示无
 };
 
 #endif // MESSAGECONTROLLER_H
@@ -0,0 +1,84 @@
+#ifndef MESSAGERENDERRECORD_H
+#define MESSAGERENDERRECORD_H
+
+#include <QFileInfo>
+#include <QMetaType>
+#include <QString>
+#include "Message.h"
+#include "formatTime.h"
+#include "StringPool.h"
+
+/**
+ * @brief 消息气泡的绘制记录（每行一份，消息进入模型时生成）
+ *
+ * 委托绘制、计算尺寸与点击判定所需的字段都在这里：类型、标志位和预先格式化好的文本。
+ * 时间文本依赖当天日期，由模型在跨天时统一刷新；文件/头像是否存在在生成时检查一次。
+ * 首字母、时间、扩展名、时长等重复率高的短文本经 StringPool 驻留，各行共用。
+ * 文本消息的排版按消息ID缓存在委托的 TextLayoutCache 中，不放在记录里。
+ */
+struct MessageRenderRecord {
+    qint64 messageId = 0;
+    qint64 conversationId = 0;
+    qint64 timestamp = 0;
+    MessageType type = MessageType::TEXT;
+    bool isOwn = false;
+    bool fileExists = false;   // filePath 指向的文件是否存在（文件消息的“已过期”遮罩）
+    bool avatarExists = false; // avatar 指向的头像文件是否存在
+    int duration = 0;          // 秒数，决定语音气泡宽度
+
+    QString content;
+    QString filePath;
+    QString thumbnailPath;
+    QString avatar;
+
+    QString senderInitial; // 默认头像上的首字母
+    QString timeText;      // FormatTime(timestamp)
+    QString fileName;      // 文件消息：文件名（路径为空时取 content）
+    QString fileExtension; // 文件消息：小写扩展名
+    QString fileSizeText;  // 文件消息：格式化后的大小
+    QString durationText;  // 视频 "H:MM:SS"，语音 "N\""
+
+    static MessageRenderRecord fromMessage(const Message &message, qint64 currentUserId) {
+        MessageRenderRecord record;
+        record.messageId = message.messageId;
+        record.conversationId = message.conversationId;
+        record.timestamp = message.timestamp;
+        record.type = message.type;
+        record.isOwn = message.isOwn(currentUserId);
+        record.duration = message.duration;
+        record.content = message.content;
+        record.filePath = message.filePath;
+        record.thumbnailPath = message.thumbnailPath;
+        record.avatar = message.avatar;
+        record.avatarExists = !message.avatar.isEmpty() && QFileInfo::exists(message.avatar);
+        record.senderInitial = message.senderName.isEmpty() ? QStringLiteral("U")
+                                                            : internString(message.senderName.left(1).toUpper());
+        record.timeText = internString(FormatTime(message.timestamp));
+
+        switch (message.type) {
+        case MessageType::FILE: {
+            const QFileInfo fileInfo(message.filePath);
+            record.fileExists = !message.filePath.isEmpty() && fileInfo.exists();
+            record.fileName = fileInfo.fileName();
+            if (record.fileName.isEmpty()) record.fileName = message.content;
+            record.fileExtension = internString(fileInfo.suffix().toLower());
+            record.fileSizeText = message.formattedFileSize();
+            break;
+        }
+        case MessageType::VIDEO:
+            record.durationText = internString(message.formattedDuration());
+            break;
+        case MessageType::VOICE:
+            record.durationText = internString(QString("%1\"").arg(message.duration));
+            break;
+        default:
+            break;
+        }
+        return record;
+    }
+};
+
+// 委托通过 ChatMessagesModel::RenderRecordRole 取到指向模型内记录的指针，只在当次调用内有效
+Q_DECLARE_METATYPE(const MessageRenderRecord *)
+
+#endif // MESSAGERENDERRECORD_H
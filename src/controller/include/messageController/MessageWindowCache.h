@@ -0,0 +1,44 @@
+#ifndef MESSAGEWINDOWCACHE_H
+#define MESSAGEWINDOWCACHE_H
+
+#include <QCache>
+#include <QVector>
+#include "Message.h"
+
+/**
+ * @class MessageWindowCache
+ * @brief 按会话缓存最近的消息窗口（LRU，按估算内存占用限额）
+ *
+ * 只缓存以最新消息结尾的窗口，且只保留末尾 kMaxCachedMessages 条，切回会话时直接换入模型。
+ * 新消息写入后通过 appendMessage 追加，使缓存与数据库保持一致。
+ */
+class MessageWindowCache
+{
+public:
+    struct Window {
+        QVector<Message> messages;  // 按时间升序
+        bool hasOlder = false;      // 窗口之前是否还有更早的消息
+    };
+
+    static constexpr int kMaxCachedMessages = 200;
+
+    explicit MessageWindowCache(int maxCostKiB = 16 * 1024);
+
+    // 放入窗口（超出条数上限时截取末尾），已存在时替换
+    void insert(qint64 conversationId, const QVector<Message> &messages, bool hasOlder);
+    // 取出窗口副本（QVector 隐式共享，无深拷贝），命中时刷新 LRU 顺序
+    bool lookup(qint64 conversationId, Window *window);
+    bool contains(qint64 conversationId) const;
+
+    // 新消息写入：追加到已缓存窗口末尾
+    void appendMessage(const Message &message);
+    void remove(qint64 conversationId);
+    void clear();
+
+private:
+    static int estimateCostKiB(const QVector<Message> &messages);
+
+    QCache<qint64, Window> m_cache;
+};
+
+#endif // MESSAGEWINDOWCACHE_H
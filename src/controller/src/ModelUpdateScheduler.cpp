@@ -0,0 +1,109 @@
+#include "ModelUpdateScheduler.h"
+#include <algorithm>
+
+ModelUpdateScheduler::ModelUpdateScheduler(QAbstractItemModel *model, QObject *parent)
+    : QObject(parent)
+{
+    m_timer.setSingleShot(true);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    m_timer.setInterval(kFrameIntervalMs);
+    connect(&m_timer, &QTimer::timeout, this, &ModelUpdateScheduler::flush);
+    setModel(model);
+}
+
+void ModelUpdateScheduler::setModel(QAbstractItemModel *model)
+{
+    if (m_model == model) return;
+    if (m_model) disconnect(m_model, nullptr, this, nullptr);
+    discard();
+    m_model = model;
+    if (!m_model) return;
+
+    // 行号即将失效：先按当前结构发出
+    connect(m_model, &QAbstractItemModel::rowsAboutToBeInserted, this, &ModelUpdateScheduler::flush);
+    connect(m_model, &QAbstractItemModel::rowsAboutToBeRemoved, this, &ModelUpdateScheduler::flush);
+    connect(m_model, &QAbstractItemModel::rowsAboutToBeMoved, this, &ModelUpdateScheduler::flush);
+    connect(m_model, &QAbstractItemModel::layoutAboutToBeChanged, this, &ModelUpdateScheduler::flush);
+    // 重置后视图整体重绘
+    connect(m_model, &QAbstractItemModel::modelAboutToBeReset, this, &ModelUpdateScheduler::discard);
+}
+
+void ModelUpdateScheduler::markDirty(int row, const QList<int> &roles)
+{
+    ++m_stats.received;
+    if (row < 0) return;
+
+    if (!m_allRows && (m_rows.isEmpty() || m_rows.constLast() != row))
+        m_rows.append(row);
+    if (roles.isEmpty()) {
+        m_allRoles = true;
+    } else if (!m_allRoles) {
+        for (int role : roles) {
+            if (!m_roles.contains(role)) m_roles.append(role);
+        }
+    }
+    schedule();
+}
+
+void ModelUpdateScheduler::markAllDirty()
+{
+    ++m_stats.received;
+    m_allRows = true;
+    m_allRoles = true;
+    m_rows.clear();
+    schedule();
+}
+
+void ModelUpdateScheduler::flush()
+{
+    m_timer.stop();
+    if (!m_model || (!m_allRows && m_rows.isEmpty())) {
+        discard();
+        return;
+    }
+
+    const int rowCount = m_model->rowCount();
+    const QList<int> roles = m_allRoles ? QList<int>() : m_roles;
+    QVector<int> rows;
+    if (!m_allRows) {
+        rows.swap(m_rows);
+        std::sort(rows.begin(), rows.end());
+        rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    }
+    const bool allRows = m_allRows;
+    discard();
+    if (rowCount == 0) return;
+
+    if (allRows) {
+        ++m_stats.emitted;
+        emit m_model->dataChanged(m_model->index(0, 0), m_model->index(rowCount - 1, 0), roles);
+        return;
+    }
+
+    // 相邻行合并为一个区间
+    for (int i = 0; i < rows.size();) {
+        const int first = rows.at(i);
+        if (first >= rowCount) break;
+        int last = first;
+        while (++i < rows.size() && rows.at(i) == last + 1 && rows.at(i) < rowCount) {
+            last = rows.at(i);
+        }
+        ++m_stats.emitted;
+        emit m_model->dataChanged(m_model->index(first, 0), m_model->index(last, 0), roles);
+    }
+}
+
+void ModelUpdateScheduler::discard()
+{
+    m_timer.stop();
+    m_rows.clear();
+    m_roles.clear();
+    m_allRoles = false;
+    m_allRows = false;
+}
+
+void ModelUpdateScheduler::schedule()
+{
+    // 不重新计时：第一次标脏后一帧内必定发出
+    if (!m_timer.isActive()) m_timer.start();
+}
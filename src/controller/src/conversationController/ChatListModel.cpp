@@ -1,9 +1,11 @@
 #include "ChatListModel.h"
 #include <QDebug>
 #include <QVector>
+#include <algorithm>
 
 ChatListModel::ChatListModel(QObject *parent)
     : QAbstractListModel(parent)
+    , m_updates(this)
 {
 }
 
@@ -47,6 +49,10 @@ QVariant ChatListModel::data(const QModelIndex &index, int role) const
         return conversation.isGroup();
     case TargetIdRole:
         return conversation.targetId();
+    case UnreadMentionCountRole:
+        return conversation.unreadMentionCount;
+    case FirstUnreadMentionIdRole:
+        return conversation.firstUnreadMentionId;
     default:
         return QVariant();
     }
@@ -131,6 +137,8 @@ QHash<int, QByteArray> ChatListModel::roleNames() const
     roles[IsTopRole] = "isTop";
     roles[IsGroupRole] = "isGroup";
     roles[TargetIdRole] = "targetId";
+    roles[UnreadMentionCountRole] = "unreadMentionCount";
+    roles[FirstUnreadMentionIdRole] = "firstUnreadMentionId";
     return roles;
 }
 
@@ -140,39 +148,122 @@ void ChatListModel::addConversation(const Conversation &conversation)
     int existingIndex = findConversationIndex(conversation.conversationId);
     if (existingIndex != -1) {
         // 更新现有会话
-        m_conversations[existingIndex] = conversation;
-        QModelIndex index = createIndex(existingIndex, 0);
-        emit dataChanged(index, index);
+        updateConversation(conversation);
         return;
     }
 
-    // 插入新会话
-    beginInsertRows(QModelIndex(), m_conversations.size(), m_conversations.size());
-    m_conversations.append(conversation);
+    // 插入到排序位置；排在已加载部分之后的由分页取回
+    const int row = insertionRow(conversation);
+    if (row < 0) return;
+    beginInsertRows(QModelIndex(), row, row);
+    m_conversations.insert(row, conversation);
+    rebuildRowIndex(row);
     endInsertRows();
 }
 
+bool ChatListModel::canFetchMore(const QModelIndex &parent) const
+{
+    if (parent.isValid()) return false;
+    return m_hasMore && !m_fetching;
+}
+
+void ChatListModel::fetchMore(const QModelIndex &parent)
+{
+    if (!canFetchMore(parent)) return;
+    m_fetching = true;
+    emit fetchMoreRequested();
+}
+
+void ChatListModel::resetConversations(const QList<Conversation> &conversations, bool hasMore)
+{
+    // 未读提及不来自会话表，按会话保留
+    QHash<qint64, QPair<int, qint64>> mentions;
+    for (const Conversation &conversation : std::as_const(m_conversations)) {
+        if (conversation.unreadMentionCount > 0)
+            mentions.insert(conversation.conversationId,
+                            {conversation.unreadMentionCount, conversation.firstUnreadMentionId});
+    }
+
+    beginResetModel();
+    m_conversations = conversations; // Qt 6 中 QVector 即 QList，直接共享数据
+    for (Conversation &conversation : m_conversations) {
+        auto it = mentions.constFind(conversation.conversationId);
+        if (it == mentions.constEnd()) continue;
+        conversation.unreadMentionCount = it->first;
+        conversation.firstUnreadMentionId = it->second;
+    }
+    rebuildRowIndex();
+    m_hasMore = hasMore;
+    m_fetching = false;
+    endResetModel();
+}
+
+void ChatListModel::appendConversations(const QList<Conversation> &conversations, bool hasMore)
+{
+    m_fetching = false;
+    m_hasMore = hasMore;
+
+    // 分页期间新建的会话可能已在列表中，就地更新，其余追加
+    QList<Conversation> fresh;
+    fresh.reserve(conversations.size());
+    for (const Conversation &conversation : conversations) {
+        if (m_rowOfConversation.contains(conversation.conversationId)) {
+            addConversation(conversation);
+        } else {
+            fresh.append(conversation);
+        }
+    }
+    if (fresh.isEmpty()) return;
+
+    const int first = m_conversations.size();
+    beginInsertRows(QModelIndex(), first, first + fresh.size() - 1);
+    m_conversations.append(std::move(fresh));
+    rebuildRowIndex(first);
+    endInsertRows();
+}
+
+Conversation ChatListModel::lastConversation() const
+{
+    return m_conversations.isEmpty() ? Conversation() : m_conversations.constLast();
+}
+
 void ChatListModel::updateConversation(const Conversation &conversation)
 {
     int index = findConversationIndex(conversation.conversationId);
     if (index != -1) {
-        m_conversations[index] = conversation;
-        QModelIndex modelIndex = createIndex(index, 0);
-        emit dataChanged(modelIndex, modelIndex);
+        // 未读提及不来自会话表，保留原值
+        Conversation &existing = m_conversations[index];
+        const Conversation previous = existing;
+        existing = conversation;
+        existing.unreadMentionCount = previous.unreadMentionCount;
+        existing.firstUnreadMentionId = previous.firstUnreadMentionId;
+
+        index = moveToSortedRow(index, previous);
+        if (index < 0) return;
+        m_updates.markDirty(index);
     }
 }
 
-void ChatListModel::updateLastMessage(qint64 conversationId, const QString &message, qint64 time)
+bool ChatListModel::updateLastMessage(qint64 conversationId, const QString &message, qint64 time,
+                                      int unreadIncrement)
 {
     int index = findConversationIndex(conversationId);
-    if (index != -1) {
-        Conversation &conversation = m_conversations[index];
-        conversation.lastMessageContent = message;
-        conversation.lastMessageTime = time;
+    if (index == -1) return false;
 
-        QModelIndex modelIndex = createIndex(index, 0);
-        emit dataChanged(modelIndex, modelIndex, {LastMessageContentRole, LastMessageTimeRole});
-    }
+    Conversation &conversation = m_conversations[index];
+    const Conversation previous = conversation;
+    conversation.lastMessageContent = message;
+    conversation.lastMessageTime = time;
+    conversation.unreadCount += unreadIncrement;
+
+    // 一次行移动加该行的 dataChanged（同一帧内的多条消息合并为一次），其余行不受影响
+    index = moveToSortedRow(index, previous);
+    if (index < 0) return false;
+    if (unreadIncrement != 0)
+        m_updates.markDirty(index, {LastMessageContentRole, LastMessageTimeRole, UnreadCountRole});
+    else
+        m_updates.markDirty(index, {LastMessageContentRole, LastMessageTimeRole});
+    return true;
 }
 
 void ChatListModel::updateUnreadCount(qint64 conversationId, int count)
@@ -181,21 +272,55 @@ void ChatListModel::updateUnreadCount(qint64 conversationId, int count)
     if (index != -1) {
         Conversation &conversation = m_conversations[index];
         conversation.unreadCount = count;
+        m_updates.markDirty(index, {UnreadCountRole});
+    }
+}
+
+bool ChatListModel::updateTopStatus(qint64 conversationId, bool isTop)
+{
+    int index = findConversationIndex(conversationId);
+    if (index == -1) return false;
 
-        QModelIndex modelIndex = createIndex(index, 0);
-        emit dataChanged(modelIndex, modelIndex, {UnreadCountRole});
+    Conversation &conversation = m_conversations[index];
+    const Conversation previous = conversation;
+    conversation.isTop = isTop;
+
+    index = moveToSortedRow(index, previous);
+    if (index < 0) return false;
+    m_updates.markDirty(index, {IsTopRole});
+    return true;
+}
+
+void ChatListModel::setUnreadMentions(const QList<MentionSummary> &mentions)
+{
+    QHash<qint64, MentionSummary> byConversation;
+    byConversation.reserve(mentions.size());
+    for (const MentionSummary &mention : mentions) {
+        byConversation.insert(mention.conversationId, mention);
+    }
+
+    for (int i = 0; i < m_conversations.size(); ++i) {
+        Conversation &conversation = m_conversations[i];
+        const MentionSummary mention = byConversation.value(conversation.conversationId);
+        if (conversation.unreadMentionCount == mention.unreadCount
+            && conversation.firstUnreadMentionId == mention.firstMessageId) {
+            continue;
+        }
+        conversation.unreadMentionCount = mention.unreadCount;
+        conversation.firstUnreadMentionId = mention.firstMessageId;
+        m_updates.markDirty(i, {UnreadMentionCountRole, FirstUnreadMentionIdRole});
     }
 }
 
-void ChatListModel::updateTopStatus(qint64 conversationId, bool isTop)
+void ChatListModel::clearUnreadMentions(qint64 conversationId)
 {
     int index = findConversationIndex(conversationId);
     if (index != -1) {
         Conversation &conversation = m_conversations[index];
-        conversation.isTop = isTop;
-
-        QModelIndex modelIndex = createIndex(index, 0);
-        emit dataChanged(modelIndex, modelIndex, {IsTopRole});
+        if (conversation.unreadMentionCount == 0 && conversation.firstUnreadMentionId == 0) return;
+        conversation.unreadMentionCount = 0;
+        conversation.firstUnreadMentionId = 0;
+        m_updates.markDirty(index, {UnreadMentionCountRole, FirstUnreadMentionIdRole});
     }
 }
 
@@ -222,50 +347,107 @@ void ChatListModel::removeConversation(qint64 conversationId)
     if (index != -1) {
         beginRemoveRows(QModelIndex(), index, index);
         m_conversations.removeAt(index);
+        m_rowOfConversation.remove(conversationId);
+        rebuildRowIndex(index);
         endRemoveRows();
     }
 }
 
 void ChatListModel::clearAll()
 {
+    m_hasMore = false;
+    m_fetching = false;
     if (!m_conversations.isEmpty()) {
         beginRemoveRows(QModelIndex(), 0, m_conversations.size() - 1);
         m_conversations.clear();
+        m_rowOfConversation.clear();
         endRemoveRows();
     }
 }
 
 int ChatListModel::findConversationIndex(qint64 conversationId) const
 {
-    for (int i = 0; i < m_conversations.size(); ++i) {
-        if (m_conversations.at(i).conversationId == conversationId) {
-            return i;
-        }
-    }
-    return -1;
+    return m_rowOfConversation.value(conversationId, -1);
 }
 
 QModelIndex ChatListModel::getConversationIndex(qint64 conversationId) const
 {
-    for (int row = 0; row < rowCount(); ++row) {
-        QModelIndex index = createIndex(row, 0);
-        qint64 convId = data(index, ConversationIdRole).toLongLong();
-        if (convId == conversationId) {
-            return index;
+    int row = findConversationIndex(conversationId);
+    return row != -1 ? createIndex(row, 0) : QModelIndex();
+}
+
+QModelIndex ChatListModel::getConversationIndexByContactId(qint64 contactId) const
+{
+    // 只在切换到聊天时调用，线性查找已加载部分即可；未加载的会话由控制器定位后加载
+    for (int row = 0; row < m_conversations.size(); ++row) {
+        const Conversation &conversation = m_conversations.at(row);
+        if (!conversation.isGroup() && conversation.userId == contactId) {
+            return createIndex(row, 0);
         }
     }
     return QModelIndex();
+}
+
+void ChatListModel::rebuildRowIndex(int fromRow)
+{
+    if (fromRow == 0) {
+        m_rowOfConversation.clear();
+        m_rowOfConversation.reserve(m_conversations.size());
+    }
+    for (int row = fromRow; row < m_conversations.size(); ++row) {
+        m_rowOfConversation.insert(m_conversations.at(row).conversationId, row);
+    }
+}
 
+bool ChatListModel::sortsBefore(const Conversation &a, const Conversation &b)
+{
+    if (a.isTop != b.isTop) return a.isTop;
+    if (a.lastMessageTime != b.lastMessageTime) return a.lastMessageTime > b.lastMessageTime;
+    return a.conversationId > b.conversationId;
 }
 
-QModelIndex ChatListModel::getConversationIndexByContactId(qint64 contactId) const
+int ChatListModel::insertionRow(const Conversation &conversation) const
 {
-    for (int row = 0; row < rowCount(); ++row) {
-        QModelIndex index = createIndex(row, 0);
-        qint64 convId = data(index, UserIdRole).toLongLong();
-        if (convId == contactId) {
-            return index;
+    const auto it = std::upper_bound(m_conversations.cbegin(), m_conversations.cend(),
+                                     conversation, sortsBefore);
+    // 排在最后一行之后时，中间可能还有未加载的会话
+    if (it == m_conversations.cend() && m_hasMore) return -1;
+    return int(it - m_conversations.cbegin());
+}
+
+int ChatListModel::moveToSortedRow(int row, const Conversation &previous)
+{
+    const Conversation &conversation = m_conversations.at(row);
+    const auto begin = m_conversations.cbegin();
+    int target = row;
+
+    if (sortsBefore(previous, conversation)) {
+        // 排序键变小，向后移：在 row 之后查找，移除本行后行号减一
+        const auto it = std::upper_bound(begin + row + 1, m_conversations.cend(), conversation, sortsBefore);
+        if (it == m_conversations.cend() && m_hasMore) {
+            // 落到已加载部分末尾之后：未加载的会话可能排在它前面，移除并交给分页取回，
+            // 同时保证最后一行（下一页游标）之前的顺序与数据库一致
+            beginRemoveRows(QModelIndex(), row, row);
+            m_rowOfConversation.remove(conversation.conversationId);
+            m_conversations.removeAt(row);
+            rebuildRowIndex(row);
+            endRemoveRows();
+            return -1;
         }
+        target = int(it - begin) - 1;
+    } else {
+        // 排序键变大（新消息、置顶），向前移：在 row 之前查找
+        target = int(std::upper_bound(begin, begin + row, conversation, sortsBefore) - begin);
     }
-    return QModelIndex();
+
+    if (target == row) return row;
+
+    // 下移时目标位置按移动前的行号计，需要加一
+    beginMoveRows(QModelIndex(), row, row, QModelIndex(), target > row ? target + 1 : target);
+    m_conversations.move(row, target);
+    for (int i = qMin(row, target); i <= qMax(row, target); ++i) {
+        m_rowOfConversation.insert(m_conversations.at(i).conversationId, i);
+    }
+    endMoveRows();
+    return target;
 }
@@ -2,8 +2,14 @@
 #include <QDebug>
 #include <QJsonArray>
 #include <QJsonObject>
+#include <QDateTime>
 #include "ConversationTable.h"
 
+namespace {
+// 会话列表每页条数（约为两屏）
+constexpr int kConversationPageSize = 50;
+}
+
 ConversationController::ConversationController(DatabaseManager* dbManager, QObject* parent)
     : QObject(parent)
     , m_dbManager(dbManager)
@@ -35,8 +41,10 @@ void ConversationController::connectSignals()
     }
 
     // 连接ConversationTable信号
-    connect(m_conversationTable, &ConversationTable::allConversationsLoaded,
-            this, &ConversationController::onAllConversationsLoaded);
+    connect(m_conversationTable, &ConversationTable::conversationsPageLoaded,
+            this, &ConversationController::onConversationsPageLoaded);
+    connect(m_conversationTable, &ConversationTable::conversationLocated,
+            this, &ConversationController::onConversationLocated);
     connect(m_conversationTable, &ConversationTable::conversationSaved,
             this, &ConversationController::onConversationSaved);
     connect(m_conversationTable, &ConversationTable::conversationUpdated,
@@ -47,21 +55,49 @@ void ConversationController::connectSignals()
             this, &ConversationController::onDbError);
     connect(m_conversationTable, &ConversationTable::topStatusToggled,
             this, &ConversationController::onTopStatusToggled);
+
+    connect(m_chatListModel, &ChatListModel::fetchMoreRequested,
+            this, &ConversationController::loadMoreConversations);
 }
 
-void ConversationController::loadConversations(int reqId)
+void ConversationController::loadConversations(int reqId, int minCount)
 {
     if (!m_conversationTable) {
         emit errorOccurred("Conversation table not available");
         return;
     }
 
-    QMetaObject::invokeMethod(m_conversationTable, "getAllConversations",
+    // 首页会整体替换列表，进行中的下一页结果作废
+    m_fetchReqId = -1;
+    const int limit = qMax(qMax(kConversationPageSize, m_chatListModel->rowCount()), minCount);
+    QMetaObject::invokeMethod(m_conversationTable, "getConversationsPage",
                               Qt::QueuedConnection,
-                              Q_ARG(int, reqId));
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, 0),
+                              Q_ARG(bool, false),
+                              Q_ARG(qint64, 0),
+                              Q_ARG(int, limit));
 }
 
-void ConversationController::createSingleChat(Contact contact)
+void ConversationController::loadMoreConversations()
+{
+    const Conversation last = m_chatListModel->lastConversation();
+    if (!m_conversationTable || last.conversationId <= 0) {
+        m_chatListModel->appendConversations({}, false);
+        return;
+    }
+
+    m_fetchReqId = generateReqId();
+    QMetaObject::invokeMethod(m_conversationTable, "getConversationsPage",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, m_fetchReqId),
+                              Q_ARG(qint64, last.conversationId),
+                              Q_ARG(bool, last.isTop),
+                              Q_ARG(qint64, last.lastMessageTime),
+                              Q_ARG(int, kConversationPageSize));
+}
+
+void ConversationController::createSingleChat(const Contact &contact)
 {
     Conversation conversation;
     conversation.userId = contact.userId;
@@ -69,14 +105,19 @@ void ConversationController::createSingleChat(Contact contact)
     conversation.title = contact.remarkName;
     conversation.avatar = contact.user.avatar;
     conversation.avatarLocalPath = contact.user.avatarLocalPath;
+    // 新建的会话排在非置顶会话最前，重新加载首页即可包含
+    conversation.lastMessageTime = QDateTime::currentSecsSinceEpoch();
 
     int reqId = generateReqId();
     m_pendingOperations[reqId] = "createSingleChat";
+    m_pendingChats.insert(reqId, conversation);
 
-    QMetaObject::invokeMethod(m_conversationTable, "saveConversation",
+    // 会话可能已存在但尚未分页加载，先定位，不存在时再新建
+    QMetaObject::invokeMethod(m_conversationTable, "locateConversation",
                               Qt::QueuedConnection,
                               Q_ARG(int, reqId),
-                              Q_ARG(Conversation,conversation));
+                              Q_ARG(qint64, -1),
+                              Q_ARG(qint64, contact.userId));
 
 }
 
@@ -99,6 +140,23 @@ void ConversationController::clearUnreadCount(qint64 conversationId)
                               Q_ARG(int, 0));
 }
 
+void ConversationController::handleMessageInserted(qint64 conversationId, const QString &content, qint64 timestamp)
+{
+    // 与 ConversationSummarizer 写入数据库的摘要保持一致：未读数加一
+    if (!m_chatListModel->updateLastMessage(conversationId, content, timestamp, 1)) {
+        // 会话尚未分页加载：定位后插入列表（排在已加载部分之后时加载到包含它的页）
+        QMetaObject::invokeMethod(m_conversationTable, "locateConversation",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(int, generateReqId()),
+                                  Q_ARG(qint64, conversationId),
+                                  Q_ARG(qint64, -1));
+        return;
+    }
+    // 正在查看的会话立即标记已读
+    if (conversationId == m_currentConversationId)
+        clearUnreadCount(conversationId);
+}
+
 void ConversationController::handltoggleReadStatus(qint64 conversationId)
 {
     if (!m_conversationTable) {
@@ -165,18 +223,51 @@ void ConversationController::handleDelete(qint64 conversationId)
 }
 
 // 数据库操作结果处理槽函数
-void ConversationController::onAllConversationsLoaded(int reqId, const QList<Conversation>& conversations)
+void ConversationController::onConversationsPageLoaded(int reqId, bool firstPage,
+                                                       const QList<Conversation>& conversations, bool hasMore)
 {
-    m_chatListModel->clearAll();
-    for (const Conversation& conv : std::as_const(conversations)) {
-        m_chatListModel->addConversation(conv);
+    if (!firstPage) {
+        if (reqId != m_fetchReqId) return;
+        m_fetchReqId = -1;
+        m_chatListModel->appendConversations(conversations, hasMore);
+        return;
     }
+
+    m_chatListModel->resetConversations(conversations, hasMore);
     QString functionCaller = m_pendingOperations[reqId];
     m_pendingOperations.remove(reqId);
 
     emit conversationLoaded(functionCaller);
 }
 
+void ConversationController::onConversationLocated(int reqId, const Conversation& conversation, int row)
+{
+    const Conversation pending = m_pendingChats.take(reqId);
+    if (row < 0 && pending.userId > 0) {
+        QMetaObject::invokeMethod(m_conversationTable, "saveConversation",
+                                  Qt::QueuedConnection,
+                                  Q_ARG(int, reqId),
+                                  Q_ARG(Conversation, pending));
+        return;
+    }
+    if (!conversation.isValid()) {
+        loadConversations(reqId);
+        return;
+    }
+
+    // 排在已加载部分之内的直接插入排序位置，列表的滚动位置和选中项不变；
+    // 排在已加载部分之后的才加载到包含它的页
+    m_chatListModel->addConversation(conversation);
+    if (m_chatListModel->findConversationIndex(conversation.conversationId) < 0) {
+        loadConversations(reqId, row + 1);
+        return;
+    }
+
+    const QString functionCaller = m_pendingOperations.take(reqId);
+    if (!functionCaller.isEmpty())
+        emit conversationLoaded(functionCaller);
+}
+
 void ConversationController::onConversationSaved(int reqId, bool success, const QString& error)
 {
     if(!success)qDebug()<<"创建会话失败"<<error;
@@ -198,7 +289,16 @@ void ConversationController::onConversationDeleted(int reqId, bool success, cons
 
 void ConversationController::onTopStatusToggled(int reqId, qint64 conversationId)
 {
-    loadConversations(0);
+    // 已加载的会话直接移到新位置；取消置顶后排到已加载部分之后的，定位后加载到包含它的页
+    const Conversation conversation = m_chatListModel->getConversation(conversationId);
+    if (conversation.isValid() && m_chatListModel->updateTopStatus(conversationId, !conversation.isTop))
+        return;
+
+    QMetaObject::invokeMethod(m_conversationTable, "locateConversation",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, conversationId),
+                              Q_ARG(qint64, -1));
 }
 
 void ConversationController::onDbError(int reqId, const QString& error)
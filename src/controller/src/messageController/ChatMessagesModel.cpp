@@ -1,9 +1,12 @@
 #include "ChatMessagesModel.h"
+#include <QDateTime>
 #include <QDebug>
+#include <algorithm>
 #include "formatTime.h"
+#include "StringPool.h"
 
 ChatMessagesModel::ChatMessagesModel(QObject *parent)
-    : QAbstractListModel(parent)
+    : ChatMessagesModel(0, parent)
 {
 }
 
@@ -11,21 +14,28 @@ ChatMessagesModel::ChatMessagesModel(int currentUserId, QObject *parent)
     : QAbstractListModel(parent)
     , m_currentUserId(currentUserId)
 {
+    m_midnightTimer.setSingleShot(true);
+    connect(&m_midnightTimer, &QTimer::timeout, this, [this]() {
+        refreshTimeTexts();
+        scheduleMidnightRefresh();
+    });
+    scheduleMidnightRefresh();
 }
 
 int ChatMessagesModel::rowCount(const QModelIndex &parent) const
 {
     if (parent.isValid())
         return 0;
-    return m_messages.size();
+    return m_count;
 }
 
 QVariant ChatMessagesModel::data(const QModelIndex &index, int role) const
 {
-    if (!index.isValid() || index.row() >= m_messages.size())
+    if (!index.isValid() || index.row() >= m_count)
         return QVariant();
 
-    const Message &message = m_messages.at(index.row());
+    const Row &row = rowAt(index.row());
+    const Message &message = row.message;
 
     switch (role) {
     case MessageIdRole:
@@ -55,7 +65,7 @@ QVariant ChatMessagesModel::data(const QModelIndex &index, int role) const
     case AvatarRole:
         return message.avatar;
     case IsOwnRole:
-        return message.isOwn(m_currentUserId);
+        return row.render.isOwn;
     case IsTextRole:
         return message.isText();
     case IsImageRole:
@@ -78,6 +88,8 @@ QVariant ChatMessagesModel::data(const QModelIndex &index, int role) const
         return message.formattedDuration();
     case FullMessageRole:
         return QVariant::fromValue(message);
+    case RenderRecordRole:
+        return QVariant::fromValue(&row.render);
     case Qt::DisplayRole:
         // 显示用文本预览
         QString preview;
@@ -99,7 +111,7 @@ QVariant ChatMessagesModel::data(const QModelIndex &index, int role) const
             break;
         }
         return QString("[%1] %2: %3").arg(
-            FormatTime(message.timestamp),
+            row.render.timeText,
             message.senderName,
             preview.left(50)
             );
@@ -110,10 +122,11 @@ QVariant ChatMessagesModel::data(const QModelIndex &index, int role) const
 
 bool ChatMessagesModel::setData(const QModelIndex &index, const QVariant &value, int role)
 {
-    if (!index.isValid() || index.row() >= m_messages.size())
+    if (!index.isValid() || index.row() >= m_count)
         return false;
 
-    Message &message = m_messages[index.row()];
+    Row &row = rowAt(index.row());
+    Message &message = row.message;
 
     switch (role) {
     case ContentRole:
@@ -144,7 +157,8 @@ bool ChatMessagesModel::setData(const QModelIndex &index, const QVariant &value,
         return false;
     }
 
-    emit dataChanged(index, index, {role});
+    refreshRenderRecord(row);
+    emit dataChanged(index, index, {role, RenderRecordRole});
     return true;
 }
 
@@ -176,31 +190,57 @@ QHash<int, QByteArray> ChatMessagesModel::roleNames() const
     roles[FormattedFileSizeRole] = "formattedFileSize";
     roles[FormattedDurationRole] = "formattedDuration";
     roles[FullMessageRole] = "fullMessage";
+    roles[RenderRecordRole] = "renderRecord";
     return roles;
 }
 
 void ChatMessagesModel::addMessage(const Message &message)
 {
-    beginInsertRows(QModelIndex(), m_messages.size(), m_messages.size());
-    m_messages.append(message);
+    beginInsertRows(QModelIndex(), m_count, m_count);
+    appendToChunks({makeRow(message)});
     endInsertRows();
+    evictAwayFromViewport(true);
 }
 
 void ChatMessagesModel::insertMessage(int row, const Message &message)
 {
-    if (row < 0 || row > m_messages.size()) return;
+    if (row < 0 || row > m_count) return;
+    if (row == m_count) {
+        addMessage(message);
+        return;
+    }
 
     beginInsertRows(QModelIndex(), row, row);
-    m_messages.insert(row, message);
+    int chunk = 0;
+    int offset = 0;
+    locate(row, &chunk, &offset);
+    QVector<Row> &target = m_chunks[chunk];
+    target.insert(offset, makeRow(message));
+    // 块过大时对半拆分，保持块内插入/删除的开销有界
+    if (target.size() >= kChunkSize * 2) {
+        QVector<Row> tail = target.mid(kChunkSize);
+        target.resize(kChunkSize);
+        m_chunks.insert(chunk + 1, tail);
+    }
+    ++m_count;
+    rebuildChunkStarts();
+    shiftVisibleRange(row, 1);
     endInsertRows();
 }
 
 void ChatMessagesModel::removeMessage(int row)
 {
-    if (row < 0 || row >= m_messages.size()) return;
+    if (row < 0 || row >= m_count) return;
 
     beginRemoveRows(QModelIndex(), row, row);
-    m_messages.removeAt(row);
+    int chunk = 0;
+    int offset = 0;
+    locate(row, &chunk, &offset);
+    m_chunks[chunk].removeAt(offset);
+    if (m_chunks.at(chunk).isEmpty()) m_chunks.removeAt(chunk);
+    --m_count;
+    rebuildChunkStarts();
+    shiftVisibleRange(row + 1, -1);
     endRemoveRows();
 }
 
@@ -216,7 +256,17 @@ void ChatMessagesModel::updateMessage(const Message &message)
 {
     int index = findMessageIndexById(message.messageId);
     if (index != -1) {
-        m_messages[index] = message;
+        rowAt(index) = makeRow(message);
+        QModelIndex modelIndex = createIndex(index, 0);
+        emit dataChanged(modelIndex, modelIndex);
+    }
+}
+
+void ChatMessagesModel::replaceMessage(qint64 messageId, const Message &message)
+{
+    int index = findMessageIndexById(messageId);
+    if (index != -1) {
+        rowAt(index) = makeRow(message);
         QModelIndex modelIndex = createIndex(index, 0);
         emit dataChanged(modelIndex, modelIndex);
     }
@@ -224,8 +274,8 @@ void ChatMessagesModel::updateMessage(const Message &message)
 
 Message ChatMessagesModel::getMessage(int row) const
 {
-    if (row >= 0 && row < m_messages.size())
-        return m_messages.at(row);
+    if (row >= 0 && row < m_count)
+        return rowAt(row).message;
     return Message();
 }
 
@@ -233,7 +283,7 @@ Message ChatMessagesModel::getMessageById(qint64 messageId) const
 {
     int index = findMessageIndexById(messageId);
     if (index != -1) {
-        return m_messages.at(index);
+        return rowAt(index).message;
     }
     return Message();
 }
@@ -242,23 +292,57 @@ void ChatMessagesModel::addMessages(const QVector<Message> &messages)
 {
     if (messages.isEmpty()) return;
 
-    beginInsertRows(QModelIndex(), m_messages.size(), m_messages.size() + messages.size() - 1);
-    m_messages.append(messages);
+    beginInsertRows(QModelIndex(), m_count, m_count + messages.size() - 1);
+    appendToChunks(makeRows(messages));
+    endInsertRows();
+    evictAwayFromViewport(true);
+}
+
+void ChatMessagesModel::prependMessages(const QVector<Message> &messages)
+{
+    if (messages.isEmpty()) return;
+
+    beginInsertRows(QModelIndex(), 0, messages.size() - 1);
+    prependToChunks(makeRows(messages));
+    shiftVisibleRange(0, messages.size());
     endInsertRows();
+    evictAwayFromViewport(false);
 }
 
 void ChatMessagesModel::clearAll()
 {
     beginResetModel();
-    m_messages.clear();
+    m_chunks.clear();
+    m_chunkStarts.clear();
+    m_count = 0;
+    m_hasOlder = false;
+    m_hasNewer = false;
+    m_visibleFirst = m_visibleLast = -1;
+    endResetModel();
+}
+
+void ChatMessagesModel::resetWindow(const QVector<Message> &messages, bool hasOlder, bool hasNewer)
+{
+    beginResetModel();
+    m_chunks.clear();
+    m_count = 0;
+    // 超出上限时只保留末尾（跳转窗口本身远小于上限）
+    const int skip = qMax(0, int(messages.size()) - kMaxWindowMessages);
+    appendToChunks(makeRows(skip > 0 ? messages.mid(skip) : messages));
+    m_hasOlder = hasOlder || skip > 0;
+    m_hasNewer = hasNewer;
+    m_visibleFirst = m_visibleLast = -1;
     endResetModel();
 }
 
 int ChatMessagesModel::findMessageIndexById(qint64 messageId) const
 {
-    for (int i = 0; i < m_messages.size(); ++i) {
-        if (m_messages.at(i).messageId == messageId) {
-            return i;
+    for (int chunk = 0; chunk < m_chunks.size(); ++chunk) {
+        const QVector<Row> &rows = m_chunks.at(chunk);
+        for (int i = 0; i < rows.size(); ++i) {
+            if (rows.at(i).message.messageId == messageId) {
+                return m_chunkStarts.at(chunk) + i;
+            }
         }
     }
     return -1;
@@ -274,8 +358,11 @@ void ChatMessagesModel::setCurrentUserId(qint64 userId)
     if (m_currentUserId != userId) {
         m_currentUserId = userId;
         // 刷新所有消息的isOwn状态
-        if (!m_messages.isEmpty()) {
-            emit dataChanged(createIndex(0, 0), createIndex(m_messages.size() - 1, 0), {IsOwnRole});
+        for (QVector<Row> &chunk : m_chunks) {
+            for (Row &row : chunk) row.render.isOwn = row.message.isOwn(m_currentUserId);
+        }
+        if (m_count > 0) {
+            emit dataChanged(createIndex(0, 0), createIndex(m_count - 1, 0), {IsOwnRole, RenderRecordRole});
         }
     }
 }
@@ -294,3 +381,209 @@ qint64 ChatMessagesModel::conversationId() const
 {
     return m_currentConversationId;
 }
+
+QVector<Message> ChatMessagesModel::messages() const
+{
+    QVector<Message> result;
+    result.reserve(m_count);
+    for (const QVector<Row> &chunk : m_chunks) {
+        for (const Row &row : chunk) result.append(row.message);
+    }
+    return result;
+}
+
+QVector<Message> ChatMessagesModel::tailMessages(int count) const
+{
+    QVector<Message> result;
+    const int first = qMax(0, m_count - count);
+    result.reserve(m_count - first);
+    for (int row = first; row < m_count; ++row) result.append(rowAt(row).message);
+    return result;
+}
+
+ChatMessagesModel::Row ChatMessagesModel::makeRow(const Message &message) const
+{
+    Row row;
+    row.message = message;
+    // 未经存储层解码的消息（本地发送、导入）也换成池中的共用副本
+    row.message.senderName = internString(message.senderName);
+    row.message.avatar = internString(message.avatar);
+    refreshRenderRecord(row);
+    return row;
+}
+
+QVector<ChatMessagesModel::Row> ChatMessagesModel::makeRows(const QVector<Message> &messages) const
+{
+    QVector<Row> rows;
+    rows.reserve(messages.size());
+    for (const Message &message : messages) rows.append(makeRow(message));
+    return rows;
+}
+
+void ChatMessagesModel::refreshRenderRecord(Row &row) const
+{
+    row.render = MessageRenderRecord::fromMessage(row.message, m_currentUserId);
+}
+
+const ChatMessagesModel::Row &ChatMessagesModel::rowAt(int row) const
+{
+    int chunk = 0;
+    int offset = 0;
+    locate(row, &chunk, &offset);
+    return m_chunks.at(chunk).at(offset);
+}
+
+ChatMessagesModel::Row &ChatMessagesModel::rowAt(int row)
+{
+    int chunk = 0;
+    int offset = 0;
+    locate(row, &chunk, &offset);
+    return m_chunks[chunk][offset];
+}
+
+void ChatMessagesModel::locate(int row, int *chunk, int *offset) const
+{
+    // 最后一个起始行号不大于 row 的块
+    const auto it = std::upper_bound(m_chunkStarts.cbegin(), m_chunkStarts.cend(), row);
+    *chunk = int(it - m_chunkStarts.cbegin()) - 1;
+    *offset = row - m_chunkStarts.at(*chunk);
+}
+
+void ChatMessagesModel::rebuildChunkStarts()
+{
+    m_chunkStarts.resize(m_chunks.size());
+    int start = 0;
+    for (int i = 0; i < m_chunks.size(); ++i) {
+        m_chunkStarts[i] = start;
+        start += m_chunks.at(i).size();
+    }
+}
+
+void ChatMessagesModel::appendToChunks(const QVector<Row> &rows)
+{
+    int next = 0;
+    // 先补满最后一块，再按整块追加
+    if (!m_chunks.isEmpty() && m_chunks.constLast().size() < kChunkSize) {
+        QVector<Row> &last = m_chunks.last();
+        const int take = qMin(kChunkSize - int(last.size()), int(rows.size()));
+        last.append(rows.mid(0, take));
+        next = take;
+    }
+    while (next < rows.size()) {
+        const int take = qMin(kChunkSize, int(rows.size()) - next);
+        m_chunks.append(rows.mid(next, take));
+        next += take;
+    }
+    m_count += rows.size();
+    rebuildChunkStarts();
+}
+
+void ChatMessagesModel::prependToChunks(const QVector<Row> &rows)
+{
+    // 从末尾开始按整块切分，不满的一块落在最前面
+    int end = rows.size();
+    while (end > 0) {
+        const int take = qMin(kChunkSize, end);
+        m_chunks.prepend(rows.mid(end - take, take));
+        end -= take;
+    }
+    m_count += rows.size();
+    rebuildChunkStarts();
+}
+
+void ChatMessagesModel::setVisibleRange(int first, int last)
+{
+    if (first < 0 || last < first) {
+        m_visibleFirst = m_visibleLast = -1;
+        return;
+    }
+    m_visibleFirst = first;
+    m_visibleLast = last;
+}
+
+void ChatMessagesModel::shiftVisibleRange(int row, int delta)
+{
+    if (m_visibleFirst < 0) return;
+    if (m_visibleFirst >= row) m_visibleFirst = qMax(0, m_visibleFirst + delta);
+    if (m_visibleLast >= row) m_visibleLast = qMax(m_visibleFirst, m_visibleLast + delta);
+}
+
+void ChatMessagesModel::evictAwayFromViewport(bool appended)
+{
+    if (m_count <= kMaxWindowMessages) return;
+
+    if (m_visibleFirst < 0 || m_visibleLast >= m_count) {
+        // 不知道视口位置：淘汰新增内容的另一端
+        if (appended) evictFront(m_count);
+        else evictBack(m_count);
+        return;
+    }
+
+    // 视口上方与下方的行数，行数多的一端离视口远，先淘汰它；视口所在的块保留
+    const int above = m_visibleFirst;
+    const int below = m_count - 1 - m_visibleLast;
+    if (above >= below) {
+        evictFront(above);
+        evictBack(m_count - 1 - m_visibleLast);
+    } else {
+        evictBack(below);
+        evictFront(m_visibleFirst);
+    }
+}
+
+void ChatMessagesModel::evictFront(int maxRows)
+{
+    int rows = 0;
+    int chunks = 0;
+    while (chunks < m_chunks.size() - 1 && m_count - rows > kMaxWindowMessages
+           && rows + m_chunks.at(chunks).size() <= maxRows) {
+        rows += m_chunks.at(chunks).size();
+        ++chunks;
+    }
+    if (rows == 0) return;
+
+    beginRemoveRows(QModelIndex(), 0, rows - 1);
+    m_chunks.remove(0, chunks);
+    m_count -= rows;
+    rebuildChunkStarts();
+    m_hasOlder = true;
+    shiftVisibleRange(0, -rows);
+    endRemoveRows();
+}
+
+void ChatMessagesModel::evictBack(int maxRows)
+{
+    int rows = 0;
+    int chunks = 0;
+    while (chunks < m_chunks.size() - 1 && m_count - rows > kMaxWindowMessages
+           && rows + m_chunks.at(m_chunks.size() - 1 - chunks).size() <= maxRows) {
+        rows += m_chunks.at(m_chunks.size() - 1 - chunks).size();
+        ++chunks;
+    }
+    if (rows == 0) return;
+
+    beginRemoveRows(QModelIndex(), m_count - rows, m_count - 1);
+    m_chunks.remove(m_chunks.size() - chunks, chunks);
+    m_count -= rows;
+    rebuildChunkStarts();
+    m_hasNewer = true;
+    endRemoveRows();
+}
+
+void ChatMessagesModel::refreshTimeTexts()
+{
+    for (QVector<Row> &chunk : m_chunks) {
+        for (Row &row : chunk) row.render.timeText = internString(FormatTime(row.message.timestamp));
+    }
+    if (m_count > 0) {
+        emit dataChanged(createIndex(0, 0), createIndex(m_count - 1, 0), {RenderRecordRole});
+    }
+}
+
+void ChatMessagesModel::scheduleMidnightRefresh()
+{
+    // 下一个零点稍后触发，避免恰好落在前一天
+    const QDateTime now = QDateTime::currentDateTime();
+    const QDateTime midnight = now.date().addDays(1).startOfDay();
+    m_midnightTimer.start(int(qBound<qint64>(1000, now.msecsTo(midnight) + 1000, 24 * 3600 * 1000 + 1000)));
+}
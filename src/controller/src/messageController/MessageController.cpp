@@ -8,11 +8,14 @@
 #include "MessageTable.h"
 #include "UserTable.h"
 #include <QMimeData>
+#include <algorithm>
 #include "ImageProcessor.h"
 #include "FileCopyProcessor.h"
 #include <QDir>
 #include <QStandardPaths>
 #include "VideoProcessor.h"
+#include "ConversationExporter.h"
+#include <limits>
 
 
 MessageController::MessageController(DatabaseManager* dbManager, QObject* parent)
@@ -24,13 +27,13 @@ MessageController::MessageController(DatabaseManager* dbManager, QObject* parent
     , m_messagesModel(new ChatMessagesModel(this))
     , currentUser(User())
     , loading(false)
-    , currentOffset(0)
     , isSearchMode(false)
     , reqIdCounter(0)
 
     , imageProcessor(new ImageProcessor(this))
     , fileCopyProcessor(new FileCopyProcessor(this))
     , videoProcessor(new VideoProcessor(this))
+    , exporter(new ConversationExporter(this))
 {
     if (dbManager) {
         messageTable = dbManager->messageTable();
@@ -68,10 +71,23 @@ void MessageController::connectSignals()
 
     // 连接MessageTable信号
     connect(messageTable, &MessageTable::messageSaved, this, &MessageController::onMessageSaved);
+    connect(messageTable, &MessageTable::messageInserted, this, &MessageController::onMessageInserted);
     connect(messageTable, &MessageTable::messageDeleted, this, &MessageController::onMessageDeleted);
-    connect(messageTable, &MessageTable::messagesLoaded, this, &MessageController::onMessagesLoaded);
+    connect(messageTable, &MessageTable::messagesPageLoaded, this, &MessageController::onMessagesPageLoaded);
+    connect(messageTable, &MessageTable::messagesAroundLoaded, this, &MessageController::onMessagesAroundLoaded);
     connect(messageTable, &MessageTable::mediaItemsLoaded, this, &MessageController::onMediaItemsLoaded);
+    connect(messageTable, &MessageTable::mediaWindowLoaded, this, &MessageController::onMediaWindowLoaded);
+    connect(messageTable, &MessageTable::mediaPageLoaded, this, &MessageController::onMediaPageLoaded);
+    connect(messageTable, &MessageTable::daySummariesLoaded, this, &MessageController::onDaySummariesLoaded);
+    connect(messageTable, &MessageTable::messagesAtDateLoaded, this, &MessageController::onMessagesAtDateLoaded);
+    connect(messageTable, &MessageTable::conversationStatsLoaded, this, &MessageController::onConversationStatsLoaded);
+    connect(messageTable, &MessageTable::importProgress, this, &MessageController::onImportProgress);
+    connect(messageTable, &MessageTable::importFinished, this, &MessageController::onImportFinished);
+    connect(messageTable, &MessageTable::pendingImportsLoaded, this, &MessageController::onPendingImportsLoaded);
+    connect(messageTable, &MessageTable::unreadMentionsLoaded, this, &MessageController::onUnreadMentionsLoaded);
     connect(messageTable, &MessageTable::dbError, this, &MessageController::onDbError);
+    // 清空消息后缓存窗口全部失效
+    connect(messageTable, &MessageTable::messagesCleared, this, [this]() { m_windowCache.clear(); });
 
     if(userTable){
         connect(userTable, &UserTable::currentUserLoaded, this, &MessageController::setCurrentUser);
@@ -85,20 +101,35 @@ void MessageController::connectSignals()
         connect(fileCopyProcessor, &FileCopyProcessor::fileCopied, this, &MessageController::sendFileMessage);
     }
 
+    connect(exporter, &ConversationExporter::exportProgress, this, &MessageController::onExportProgress);
+    connect(exporter, &ConversationExporter::exportFinished, this, &MessageController::onExportFinished);
+
     if(videoProcessor){
         connect(videoProcessor, &VideoProcessor::videoProcessed, this, &MessageController::sendVideoMessage);
     }
 }
 
-void MessageController::setCurrentConversation(Conversation conversation)
+void MessageController::setCurrentConversation(const Conversation &conversation)
 {
     if (m_currentConversation.conversationId != conversation.conversationId) {
+        // 离开的会话窗口以最新消息结尾时放入缓存，切回时无需查询
+        if (m_currentConversation.isValid() && !m_messagesModel->hasNewer()
+            && m_messagesModel->rowCount() > 0) {
+            m_windowCache.insert(m_currentConversation.conversationId,
+                                 m_messagesModel->messages(), m_messagesModel->hasOlder());
+        }
+
         m_currentConversation = conversation;
         m_messagesModel->setConversationId(conversation.conversationId);
-        currentOffset = 0;
         isSearchMode = false;
 
-        loadRecentMessages();
+        MessageWindowCache::Window window;
+        if (m_windowCache.lookup(conversation.conversationId, &window)) {
+            loading = false;
+            m_messagesModel->resetWindow(window.messages, window.hasOlder, false);
+        } else {
+            loadRecentMessages();
+        }
     }
 }
 
@@ -107,11 +138,12 @@ void MessageController::setCurrentUser(int reqId, User user)
     if (currentUser.userId != user.userId && user.userId != -1) {
         currentUser = user;
         m_messagesModel->setCurrentUserId(currentUser.userId);
+        loadUnreadMentions();
     }
 }
 
 // 测试模拟接收信息---------
-void MessageController::saveMessage(Message msg){
+void MessageController::saveMessage(const Message &msg){
     QMetaObject::invokeMethod(messageTable, "saveMessage",
                               Qt::QueuedConnection,
                               Q_ARG(int, 0),
@@ -128,23 +160,12 @@ void MessageController::sendTextMessage(const QString& content)
 
     Message message = createMessage(m_currentConversation, MessageType::TEXT, content);
 
-    // 先添加到模型（立即显示）
-    m_messagesModel->addMessage(message);
-    currentOffset += 1;
-
-    // 异步保存到数据库
-    int reqId = generateReqId();
-    QMetaObject::invokeMethod(messageTable, "saveMessage",
-                              Qt::QueuedConnection,
-                              Q_ARG(int, reqId),
-                              Q_ARG(Message, message));
-
+    // 先添加到模型（立即显示），再异步保存到数据库
+    submitMessage(message);
 
     // ---------------------临时测试-------------
-    const QVector<Message> &original = m_messagesModel->m_messages;
-    QVector<Message> result;
-    result.reserve(qMin(9, original.size()));
-    std::copy_n(original.rbegin(), qMin(9, original.size()), std::back_inserter(result));
+    QVector<Message> result = m_messagesModel->tailMessages(9);
+    std::reverse(result.begin(), result.end());
     emit send(result);
 
     //-------------------------------------------------
@@ -177,21 +198,10 @@ void MessageController::sendImageMessage(const qint64 conversationId,
                                     0,
                                     thumbnailPath);
 
-    if(conversationId==m_currentConversation.conversationId){
-        m_messagesModel->addMessage(message);
-        currentOffset += 1;
-    }
-
-    int reqId = generateReqId();
-    QMetaObject::invokeMethod(messageTable, "saveMessage",
-                              Qt::QueuedConnection,
-                              Q_ARG(int, reqId),
-                              Q_ARG(Message, message));
+    submitMessage(message);
     // ---------------------临时测试-------------
-    const QVector<Message> &original = m_messagesModel->m_messages;
-    QVector<Message> result;
-    result.reserve(qMin(9, original.size()));
-    std::copy_n(original.rbegin(), qMin(9, original.size()), std::back_inserter(result));
+    QVector<Message> result = m_messagesModel->tailMessages(9);
+    std::reverse(result.begin(), result.end());
     emit send(result);
     //-------------------------------------------------
 }
@@ -221,22 +231,11 @@ void MessageController::sendVideoMessage(qint64 conversationId,
                                     thumbnailPath);
 
 
-    if(conversationId==m_currentConversation.conversationId){
-        m_messagesModel->addMessage(message);
-        currentOffset += 1;
-    }
-
-    int reqId = generateReqId();
-    QMetaObject::invokeMethod(messageTable, "saveMessage",
-                              Qt::QueuedConnection,
-                              Q_ARG(int, reqId),
-                              Q_ARG(Message, message));
+    submitMessage(message);
 
     // ---------------------临时测试-------------
-    const QVector<Message> &original = m_messagesModel->m_messages;
-    QVector<Message> result;
-    result.reserve(qMin(9, original.size()));
-    std::copy_n(original.rbegin(), qMin(9, original.size()), std::back_inserter(result));
+    QVector<Message> result = m_messagesModel->tailMessages(9);
+    std::reverse(result.begin(), result.end());
     emit send(result);
     //-------------------------------------------------
 }
@@ -260,22 +259,11 @@ void MessageController::sendFileMessage(const qint64 conversationId,
 
     Message message = createMessage(tempConv, MessageType::FILE, "【文件】"+fileInfo.fileName(), targetPath, fileSize);
 
-    if(conversationId==m_currentConversation.conversationId){
-        m_messagesModel->addMessage(message);
-        currentOffset += 1;
-    }
-
-    int reqId = generateReqId();
-    QMetaObject::invokeMethod(messageTable, "saveMessage",
-                              Qt::QueuedConnection,
-                              Q_ARG(int, reqId),
-                              Q_ARG(Message, message));
+    submitMessage(message);
 
     // ---------------------临时测试-------------
-    const QVector<Message> &original = m_messagesModel->m_messages;
-    QVector<Message> result;
-    result.reserve(qMin(9, original.size()));
-    std::copy_n(original.rbegin(), qMin(9, original.size()), std::back_inserter(result));
+    QVector<Message> result = m_messagesModel->tailMessages(9);
+    std::reverse(result.begin(), result.end());
     emit send(result);
     //-------------------------------------------------
 }
@@ -290,25 +278,36 @@ void MessageController::sendVoiceMessage(const QString& filePath, int duration)
     qint64 fileSize = 0;
     Message message = createMessage(m_currentConversation, MessageType::VOICE, "语音消息", filePath, fileSize, duration);
 
-    m_messagesModel->addMessage(message);
+    submitMessage(message);
 
-    int reqId = generateReqId();
+    // ---------------------临时测试-------------
+    QVector<Message> result = m_messagesModel->tailMessages(9);
+    std::reverse(result.begin(), result.end());
+    emit send(result);
+    //-------------------------------------------------
+}
+
+
+void MessageController::submitMessage(const Message &message)
+{
+    const int reqId = generateReqId();
+    const bool current = message.conversationId == m_currentConversation.conversationId;
+
+    // 窗口以最新消息结尾时直接追加，写入成功后再换成数据库分配的ID
+    if (current && !m_messagesModel->hasNewer()) {
+        m_messagesModel->addMessage(message);
+        m_pendingSends.insert(reqId, message.messageId);
+    }
 
     QMetaObject::invokeMethod(messageTable, "saveMessage",
                               Qt::QueuedConnection,
                               Q_ARG(int, reqId),
                               Q_ARG(Message, message));
 
-    // ---------------------临时测试-------------
-    const QVector<Message> &original = m_messagesModel->m_messages;
-    QVector<Message> result;
-    result.reserve(qMin(9, original.size()));
-    std::copy_n(original.rbegin(), qMin(9, original.size()), std::back_inserter(result));
-    emit send(result);
-    //-------------------------------------------------
+    // 窗口停在历史位置（跳转、搜索结果）时发送：回到最新消息，读取排在保存之后，包含刚发送的这条
+    if (current && m_messagesModel->hasNewer()) loadRecentMessages();
 }
 
-
 // 异步查询加载操作
 void MessageController::loadRecentMessages(int limit)
 {
@@ -317,17 +316,19 @@ void MessageController::loadRecentMessages(int limit)
     }
 
     loading = true;
-    currentOffset = 0;
 
     int reqId = generateReqId();
     pendingOperations.insert(reqId, "loadRecentMessages");
 
-    QMetaObject::invokeMethod(messageTable, "getMessages",
+    // 游标取最大值，即从最新一条开始向前读取
+    QMetaObject::invokeMethod(messageTable, "getMessagesFrom",
                               Qt::QueuedConnection,
                               Q_ARG(int, reqId),
                               Q_ARG(qint64, m_currentConversation.conversationId),
-                              Q_ARG(int, limit),
-                              Q_ARG(int, 0));
+                              Q_ARG(qint64, std::numeric_limits<qint64>::max()),
+                              Q_ARG(qint64, std::numeric_limits<qint64>::max()),
+                              Q_ARG(bool, true),
+                              Q_ARG(int, limit));
 }
 
 void MessageController::loadMoreMessages(int limit)
@@ -335,18 +336,102 @@ void MessageController::loadMoreMessages(int limit)
     if (loading || !m_currentConversation.isValid() || !messageTable) {
         return;
     }
+    if (m_messagesModel->rowCount() == 0) {
+        loadRecentMessages(limit);
+        return;
+    }
+    if (!m_messagesModel->hasOlder()) {
+        return;
+    }
 
     loading = true;
 
     int reqId = generateReqId();
     pendingOperations.insert(reqId, "loadMoreMessages");
 
-    QMetaObject::invokeMethod(messageTable, "getMessages",
+    // 以窗口中最早的一条为游标向前读取
+    const Message oldest = m_messagesModel->getMessage(0);
+    QMetaObject::invokeMethod(messageTable, "getMessagesFrom",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, m_currentConversation.conversationId),
+                              Q_ARG(qint64, oldest.timestamp),
+                              Q_ARG(qint64, oldest.messageId),
+                              Q_ARG(bool, true),
+                              Q_ARG(int, limit));
+}
+
+void MessageController::loadNewerMessages(int limit)
+{
+    if (loading || !m_currentConversation.isValid() || !messageTable || !m_messagesModel->hasNewer()) {
+        return;
+    }
+
+    loading = true;
+
+    int reqId = generateReqId();
+    pendingOperations.insert(reqId, "loadNewerMessages");
+
+    // 以窗口中最新的一条为游标向后读取
+    const Message newest = m_messagesModel->getMessage(m_messagesModel->rowCount() - 1);
+    QMetaObject::invokeMethod(messageTable, "getMessagesFrom",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, m_currentConversation.conversationId),
+                              Q_ARG(qint64, newest.timestamp),
+                              Q_ARG(qint64, newest.messageId),
+                              Q_ARG(bool, false),
+                              Q_ARG(int, limit));
+}
+
+void MessageController::loadMessagesAround(qint64 messageId, int before, int after)
+{
+    if (!m_currentConversation.isValid() || !messageTable) {
+        return;
+    }
+
+    // 锚点已在当前窗口内，直接定位
+    if (m_messagesModel->containsMessage(messageId)) {
+        emit jumpedToMessage(messageId);
+        return;
+    }
+
+    loading = true;
+
+    int reqId = generateReqId();
+    pendingOperations.insert(reqId, "loadMessagesAround");
+
+    QMetaObject::invokeMethod(messageTable, "getMessagesAround",
                               Qt::QueuedConnection,
                               Q_ARG(int, reqId),
                               Q_ARG(qint64, m_currentConversation.conversationId),
-                              Q_ARG(int, limit),
-                              Q_ARG(int, currentOffset));
+                              Q_ARG(qint64, messageId),
+                              Q_ARG(int, before),
+                              Q_ARG(int, after));
+}
+
+void MessageController::prefetchConversation(qint64 conversationId, int limit)
+{
+    if (conversationId <= 0 || !messageTable
+        || conversationId == m_currentConversation.conversationId
+        || m_windowCache.contains(conversationId)) {
+        return;
+    }
+    for (auto it = m_prefetchRequests.cbegin(); it != m_prefetchRequests.cend(); ++it) {
+        if (it.value() == conversationId) return; // 已在预取中
+    }
+
+    int reqId = generateReqId();
+    m_prefetchRequests.insert(reqId, conversationId);
+
+    QMetaObject::invokeMethod(messageTable, "getMessagesFrom",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, conversationId),
+                              Q_ARG(qint64, std::numeric_limits<qint64>::max()),
+                              Q_ARG(qint64, std::numeric_limits<qint64>::max()),
+                              Q_ARG(bool, true),
+                              Q_ARG(int, limit));
 }
 
 void MessageController::getMediaItems(qint64 conversationId)
@@ -364,6 +449,167 @@ void MessageController::getMediaItems(qint64 conversationId)
                               Q_ARG(qint64, conversationId));
 }
 
+void MessageController::loadMediaWindow(qint64 conversationId, qint64 anchorMessageId, int radius)
+{
+    if (!messageTable) {
+        emit mediaWindowLoaded(anchorMessageId, QList<MediaItem>(), false, false);
+        return;
+    }
+
+    int reqId = generateReqId();
+    pendingOperations.insert(reqId, "loadMediaWindow");
+
+    QMetaObject::invokeMethod(messageTable, "getMediaWindow",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, conversationId),
+                              Q_ARG(qint64, anchorMessageId),
+                              Q_ARG(int, radius));
+}
+
+void MessageController::loadMoreMedia(qint64 conversationId, const MediaItem &edge, bool older, int limit)
+{
+    if (!messageTable) {
+        emit mediaPageLoaded(older, QList<MediaItem>(), false);
+        return;
+    }
+
+    int reqId = generateReqId();
+    pendingOperations.insert(reqId, "loadMoreMedia");
+
+    QMetaObject::invokeMethod(messageTable, "getMediaPage",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, conversationId),
+                              Q_ARG(qint64, edge.timestamp),
+                              Q_ARG(qint64, edge.messageId),
+                              Q_ARG(bool, older),
+                              Q_ARG(int, limit));
+}
+
+void MessageController::loadTimeline()
+{
+    if (!m_currentConversation.isValid() || !messageTable) {
+        return;
+    }
+
+    int reqId = generateReqId();
+    pendingOperations.insert(reqId, "loadTimeline");
+
+    QMetaObject::invokeMethod(messageTable, "getDaySummaries",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, m_currentConversation.conversationId));
+}
+
+void MessageController::loadConversationStats(qint64 conversationId)
+{
+    if (conversationId <= 0 || !messageTable) {
+        return;
+    }
+
+    int reqId = generateReqId();
+    pendingOperations.insert(reqId, "loadConversationStats");
+
+    QMetaObject::invokeMethod(messageTable, "getConversationStats",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, conversationId));
+}
+
+void MessageController::exportConversation(qint64 conversationId, const QString &outputPath, bool copyMedia)
+{
+    if (conversationId <= 0 || outputPath.isEmpty()) return;
+    if (m_exportReqId >= 0) {
+        qWarning() << "An export is already running";
+        return;
+    }
+
+    m_exportReqId = generateReqId();
+    exporter->exportConversation(m_exportReqId, conversationId, outputPath, copyMedia);
+}
+
+void MessageController::cancelExport()
+{
+    if (m_exportReqId >= 0) exporter->cancel(m_exportReqId);
+}
+
+void MessageController::importHistory(const QString &archivePath)
+{
+    if (archivePath.isEmpty() || !messageTable) return;
+    if (m_importReqId >= 0) {
+        qWarning() << "An import is already running";
+        return;
+    }
+
+    m_importReqId = generateReqId();
+    QMetaObject::invokeMethod(messageTable, "importMessages",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, m_importReqId),
+                              Q_ARG(QString, archivePath));
+}
+
+void MessageController::cancelImport()
+{
+    if (m_importReqId < 0 || !messageTable) return;
+    QMetaObject::invokeMethod(messageTable, "cancelImport",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, m_importReqId));
+}
+
+void MessageController::checkPendingImports()
+{
+    if (!messageTable) return;
+
+    int reqId = generateReqId();
+    pendingOperations.insert(reqId, "checkPendingImports");
+    QMetaObject::invokeMethod(messageTable, "getPendingImports",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId));
+}
+
+void MessageController::loadUnreadMentions()
+{
+    if (currentUser.userId <= 0 || !messageTable) return;
+
+    int reqId = generateReqId();
+    pendingOperations.insert(reqId, "loadUnreadMentions");
+    QMetaObject::invokeMethod(messageTable, "getUnreadMentions",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, currentUser.userId));
+}
+
+void MessageController::markMentionsRead(qint64 conversationId)
+{
+    if (currentUser.userId <= 0 || !messageTable) return;
+
+    QMetaObject::invokeMethod(messageTable, "markMentionsRead",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, generateReqId()),
+                              Q_ARG(qint64, currentUser.userId),
+                              Q_ARG(qint64, conversationId));
+}
+
+void MessageController::jumpToDate(const QDate &date, int limit)
+{
+    if (!date.isValid() || !m_currentConversation.isValid() || !messageTable) {
+        return;
+    }
+
+    loading = true;
+
+    int reqId = generateReqId();
+    pendingOperations.insert(reqId, "jumpToDate");
+
+    QMetaObject::invokeMethod(messageTable, "getMessagesAtDate",
+                              Qt::QueuedConnection,
+                              Q_ARG(int, reqId),
+                              Q_ARG(qint64, m_currentConversation.conversationId),
+                              Q_ARG(int, MessageDaySummary::dayKey(date)),
+                              Q_ARG(int, limit));
+}
+
 
 // 控制UI 操作
 void MessageController::handleCopy(const Message &message)
@@ -450,12 +696,33 @@ void MessageController::handleDelete(const Message &message)
 void MessageController::onMessageSaved(int reqId, bool ok, QString reason)
 {
     if(!ok){
+        m_pendingSends.remove(reqId);
         qDebug()<<reason;
     }
     else {
         emit messageSaved();
-        loadRecentMessages();
+        // 当前会话的窗口由 onMessageInserted 就地追加，不再整体重新加载
+        // 新消息可能 @ 了当前用户
+        loadUnreadMentions();
+    }
+}
+
+void MessageController::onMessageInserted(int reqId, const Message& message)
+{
+    const qint64 localId = m_pendingSends.take(reqId);
+
+    if (message.conversationId != m_currentConversation.conversationId) {
+        // 其他会话的缓存窗口直接追加
+        m_windowCache.appendMessage(message);
+    } else if (localId != 0 && m_messagesModel->containsMessage(localId)) {
+        // 自己发送的消息已在窗口中：换成数据库中的ID
+        m_messagesModel->replaceMessage(localId, message);
+    } else if (!m_messagesModel->hasNewer()) {
+        // 收到的消息：窗口以最新消息结尾时就地追加；停在历史位置（跳转窗口、向前翻页）时不动，
+        // 窗口之后本就标记为还有消息，滚动到末尾时按游标加载
+        m_messagesModel->addMessage(message);
     }
+    emit messageInserted(message);
 }
 
 void MessageController::onMessageDeleted(int reqId, bool success, const QString& error)
@@ -463,30 +730,155 @@ void MessageController::onMessageDeleted(int reqId, bool success, const QString&
     emit messageDeleted(success, error);
 }
 
-void MessageController::onMessagesLoaded(int reqId, const QVector<Message>& messages)
+void MessageController::onMessagesPageLoaded(int reqId, bool older, const QVector<Message>& messages, bool hasMore)
 {
+    Q_UNUSED(older);
+
+    // 预取结果只进入缓存，不触碰当前模型
+    if (m_prefetchRequests.contains(reqId)) {
+        const qint64 conversationId = m_prefetchRequests.take(reqId);
+        if (conversationId != m_currentConversation.conversationId)
+            m_windowCache.insert(conversationId, messages, hasMore);
+        return;
+    }
+
     QString operation = pendingOperations.take(reqId);
+    if (operation.isEmpty()) return;
     loading = false;
 
+    if (!messages.isEmpty() && messages.first().conversationId != m_currentConversation.conversationId) return;
+
     if (operation == "loadRecentMessages") {
-        // 加载最近消息
-        m_messagesModel->clearAll();
-        m_messagesModel->addMessages(messages);
-        currentOffset = messages.count();
+        // 加载最近消息：窗口以最新消息结尾
+        m_messagesModel->resetWindow(messages, hasMore, false);
     } else if (operation == "loadMoreMessages") {
         // 加载更多历史消息
-        for(int i = messages.count()-1; i >= 0; i--){
-            m_messagesModel->insertMessage(0, messages[i]);
-        }
-        currentOffset += messages.count();
+        m_messagesModel->prependMessages(messages);
+        m_messagesModel->setHasOlder(hasMore);
+    } else if (operation == "loadNewerMessages") {
+        m_messagesModel->addMessages(messages);
+        m_messagesModel->setHasNewer(hasMore);
     }
 }
 
+void MessageController::onMessagesAroundLoaded(int reqId, qint64 anchorMessageId, const QVector<Message>& messages,
+                                               bool hasOlder, bool hasNewer)
+{
+    if (pendingOperations.take(reqId) != "loadMessagesAround") return;
+    loading = false;
+
+    if (messages.isEmpty() || messages.first().conversationId != m_currentConversation.conversationId) return;
+
+    m_messagesModel->resetWindow(messages, hasOlder, hasNewer);
+    emit jumpedToMessage(anchorMessageId);
+}
+
 void MessageController::onMediaItemsLoaded(int reqId, const QList<MediaItem>& items)
 {
     emit mediaItemsLoaded(items);
 }
 
+void MessageController::onMediaWindowLoaded(int reqId, qint64 anchorMessageId, const QList<MediaItem>& items,
+                                            bool hasOlder, bool hasNewer)
+{
+    if (pendingOperations.take(reqId) != "loadMediaWindow") return;
+    emit mediaWindowLoaded(anchorMessageId, items, hasOlder, hasNewer);
+}
+
+void MessageController::onMediaPageLoaded(int reqId, bool older, const QList<MediaItem>& items, bool hasMore)
+{
+    if (pendingOperations.take(reqId) != "loadMoreMedia") return;
+    emit mediaPageLoaded(older, items, hasMore);
+}
+
+void MessageController::onDaySummariesLoaded(int reqId, const QList<MessageDaySummary>& summaries)
+{
+    if (pendingOperations.take(reqId) != "loadTimeline") return;
+
+    // 会话已切换时丢弃过期结果
+    if (!summaries.isEmpty() && summaries.first().conversationId != m_currentConversation.conversationId) return;
+    emit timelineLoaded(summaries);
+}
+
+void MessageController::onMessagesAtDateLoaded(int reqId, qint64 anchorMessageId,
+                                               const QVector<Message>& messages, bool hasNewer)
+{
+    if (pendingOperations.take(reqId) != "jumpToDate") return;
+    loading = false;
+
+    if (anchorMessageId == 0 || messages.isEmpty()
+        || messages.first().conversationId != m_currentConversation.conversationId) {
+        return;
+    }
+
+    // 以锚点为起点替换当前窗口，之后按游标向两侧扩展
+    m_messagesModel->resetWindow(messages, true, hasNewer);
+
+    emit jumpedToMessage(anchorMessageId);
+}
+
+void MessageController::onConversationStatsLoaded(int reqId, const ConversationStats& stats)
+{
+    if (pendingOperations.take(reqId) != "loadConversationStats") return;
+    emit conversationStatsLoaded(stats);
+}
+
+void MessageController::onExportProgress(int reqId, qint64 exportedCount, qint64 totalCount)
+{
+    if (reqId != m_exportReqId) return;
+    emit exportProgress(exportedCount, totalCount);
+}
+
+void MessageController::onExportFinished(int reqId, bool ok, const QString& reason, qint64 exportedCount)
+{
+    if (reqId != m_exportReqId) return;
+    m_exportReqId = -1;
+    emit exportFinished(ok, reason, exportedCount);
+}
+
+void MessageController::onImportProgress(int reqId, qint64 importedCount, qint64 bytesRead, qint64 bytesTotal)
+{
+    if (reqId != m_importReqId) return;
+    emit importProgress(importedCount, bytesRead, bytesTotal);
+}
+
+void MessageController::onImportFinished(int reqId, bool ok, const QString& reason,
+                                         qint64 importedCount, qint64 skippedCount)
+{
+    if (reqId != m_importReqId) return;
+    m_importReqId = -1;
+
+    // 导入的消息可能落在任意会话的任意位置，缓存窗口全部作废，当前会话重新加载
+    m_windowCache.clear();
+    if (importedCount > 0 && m_currentConversation.isValid()) loadRecentMessages();
+    if (importedCount > 0) loadUnreadMentions();
+
+    emit importFinished(ok, reason, importedCount, skippedCount);
+}
+
+void MessageController::onPendingImportsLoaded(int reqId, const QStringList& archivePaths)
+{
+    if (pendingOperations.take(reqId) != "checkPendingImports") return;
+    if (!archivePaths.isEmpty()) emit pendingImportsFound(archivePaths);
+}
+
+void MessageController::onUnreadMentionsLoaded(int reqId, const QList<MentionSummary>& mentions)
+{
+    if (pendingOperations.take(reqId) != "loadUnreadMentions") return;
+
+    // 当前会话已在查看，其中的提及不再提示
+    QList<MentionSummary> unread;
+    unread.reserve(mentions.size());
+    for (const MentionSummary &mention : mentions) {
+        if (mention.conversationId == m_currentConversation.conversationId) {
+            markMentionsRead(mention.conversationId);
+            continue;
+        }
+        unread.append(mention);
+    }
+    emit unreadMentionsLoaded(unread);
+}
+
 void MessageController::onDbError(int reqId, const QString& error)
 {
     qWarning() << "Database error in request" << reqId << ":" << error;
@@ -0,0 +1,69 @@
+#include "MessageWindowCache.h"
+
+MessageWindowCache::MessageWindowCache(int maxCostKiB)
+    : m_cache(maxCostKiB)
+{
+}
+
+void MessageWindowCache::insert(qint64 conversationId, const QVector<Message> &messages, bool hasOlder)
+{
+    Window *window = new Window;
+    if (messages.size() > kMaxCachedMessages) {
+        window->messages = messages.mid(messages.size() - kMaxCachedMessages);
+        window->hasOlder = true;
+    } else {
+        window->messages = messages;
+        window->hasOlder = hasOlder;
+    }
+    // QCache 取得所有权；代价超过上限时直接丢弃
+    m_cache.insert(conversationId, window, estimateCostKiB(window->messages));
+}
+
+bool MessageWindowCache::lookup(qint64 conversationId, Window *window)
+{
+    Window *cached = m_cache.object(conversationId);
+    if (!cached) return false;
+    *window = *cached;
+    return true;
+}
+
+bool MessageWindowCache::contains(qint64 conversationId) const
+{
+    return m_cache.contains(conversationId);
+}
+
+void MessageWindowCache::appendMessage(const Message &message)
+{
+    // 取出后原地追加：窗口不再被缓存引用，未被其他副本共享时不会整体复制
+    Window *cached = m_cache.take(message.conversationId);
+    if (!cached) return;
+
+    cached->messages.append(message);
+    if (cached->messages.size() > kMaxCachedMessages) {
+        cached->messages.removeFirst();
+        cached->hasOlder = true;
+    }
+    // 重新插入以更新代价
+    m_cache.insert(message.conversationId, cached, estimateCostKiB(cached->messages));
+}
+
+void MessageWindowCache::remove(qint64 conversationId)
+{
+    m_cache.remove(conversationId);
+}
+
+void MessageWindowCache::clear()
+{
+    m_cache.clear();
+}
+
+int MessageWindowCache::estimateCostKiB(const QVector<Message> &messages)
+{
+    qint64 bytes = 0;
+    for (const Message &m : messages) {
+        bytes += sizeof(Message);
+        bytes += (m.content.size() + m.filePath.size() + m.fileUrl.size() + m.thumbnailPath.size()
+                  + m.senderName.size() + m.avatar.size()) * qint64(sizeof(QChar));
+    }
+    return int(bytes / 1024) + 1;
+}
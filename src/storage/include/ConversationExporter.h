@@ -0,0 +1,43 @@
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <atomic>
+
+/**
+ * @brief 会话导出：在后台线程按游标分页遍历会话消息，流式写出 JSON Lines
+ *
+ * 导出线程从连接池借用独立的数据库连接（WAL 下不阻塞数据库线程的读写），每次只读取一页消息，
+ * 写入经缓冲后批量落盘，内存占用与会话消息总数无关。
+ * 写入目标为临时文件，完成后原子替换；取消或失败时不留下半个文件。
+ * 可选复制消息引用的本地媒体文件到导出文件旁的 <文件名>_media 目录。
+ */
+class ConversationExporter : public QObject {
+    Q_OBJECT
+public:
+    explicit ConversationExporter(QObject *parent = nullptr);
+    ~ConversationExporter() override;
+
+    void exportConversation(int reqId, qint64 conversationId, const QString &outputPath, bool copyMedia);
+    // 请求取消；导出线程在处理完当前页后停止
+    void cancel(int reqId);
+    void cancelAll();
+
+signals:
+    // 在导出线程发出（跨线程连接自动排队）；totalCount 来自会话统计，仅用于显示进度
+    void exportProgress(int reqId, qint64 exportedCount, qint64 totalCount);
+    void exportFinished(int reqId, bool ok, QString reason, qint64 exportedCount);
+
+private:
+    using CancelFlag = QSharedPointer<std::atomic<bool>>;
+
+    void run(int reqId, qint64 conversationId, const QString &outputPath, bool copyMedia,
+             const CancelFlag &cancelled);
+
+    QThreadPool m_pool;
+    QMutex m_mutex;
+    QHash<int, CancelFlag> m_cancelFlags; // 进行中的导出 reqId -> 取消标记
+};
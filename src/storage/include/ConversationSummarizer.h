@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QSharedPointer>
+#include <QtSql/QSqlDatabase>
+
+class MessageShardRouter;
+class NativeStatementCache;
+
+/**
+ * @brief 会话摘要（last_message_content / last_message_time / unread_count）的批量维护
+ *
+ * 替代原先逐行执行的 trigger_conversation_insert / trigger_conversation_delete：
+ * 写入路径在事务内记录变更，提交前调用 flush()，每个受影响的会话只写一次。
+ * 结果与触发器逐行执行一致：
+ *  - 插入：最后一条摘要取本事务最后插入的消息，未读数加上插入条数；
+ *  - 删除：被删消息不早于当前摘要时间时，按剩余消息（跨分片）重新取最新一条。
+ */
+class ConversationSummarizer {
+public:
+    ConversationSummarizer(QSharedPointer<QSqlDatabase> database, MessageShardRouter *router);
+
+    // 设置后摘要的读写走原生 sqlite3 语句（缓存不可用时仍用 QtSql）
+    void setNativeCache(NativeStatementCache *native) { m_native = native; }
+
+    void recordInsert(qint64 conversationId, const QString &content, qint64 msgTime);
+    void recordDelete(qint64 conversationId, qint64 msgTime);
+    // 摘要可能已失效（如分片被整体删除），无条件按剩余消息重算
+    void markStale(qint64 conversationId);
+
+    // 写入所有待处理的会话摘要，应在所属事务提交前调用；失败时保留待处理数据
+    bool flush(QString *error = nullptr);
+    // 事务回滚时丢弃待处理数据
+    void discard();
+
+    bool hasPending() const { return !m_pending.isEmpty(); }
+
+private:
+    struct Pending {
+        bool inserted = false;
+        QVariant lastContent;
+        qint64 lastTime = 0;
+        int insertCount = 0;
+        bool deleted = false;
+        qint64 maxDeletedTime = 0;   // 被删消息中最晚的时间，用于判断是否需要重算
+        bool stale = false;
+    };
+
+    bool recompute(qint64 conversationId, const Pending &pending, QString *error);
+    // 取单个表中会话的最新一条消息，没有时 content/msgTime 保持不变
+    bool latestInTable(const QString &table, qint64 conversationId,
+                       QVariant *content, QVariant *msgTime, QString *error);
+    bool nativeEnabled() const;
+
+    QSharedPointer<QSqlDatabase> m_database;
+    MessageShardRouter *m_router = nullptr;
+    NativeStatementCache *m_native = nullptr;
+    QHash<qint64, Pending> m_pending;
+};
@@ -20,10 +20,25 @@ public:
     // 将 PRAGMA 应用于传入的连接（供外部线程连接复用）
     static void applyPragmas(QSqlDatabase &db);
 
+    // 派生表（按天汇总、会话统计）为空而消息表非空时回填，用于分片挂载（schema 为挂载名）；
+    // 主库升级后由 SchemaMigrator 在后台分块回填
+    static bool backfillDerivedTables(QSqlDatabase &db, const QString &schema = QString());
+
+    // 删除旧版本中缺少清空保护条件的删除触发器，随后由建触发器语句按新定义重建
+    static void dropUnguardedTriggers(QSqlDatabase &db, const QString &schema = QString());
+
+    // 结构指纹与迁移版本均为最新时返回 true，启动可跳过全部 DDL
+    static bool isSchemaCurrent(QSqlDatabase &db);
+    // 结构被临时改动（如导入时删除索引）后作废指纹，下次启动或挂载分片时重新执行 DDL（schema 为分片挂载名）
+    static void invalidateSchemaFingerprint(QSqlDatabase &db, const QString &schema = QString());
+
 private:
     bool databaseFileExists() const;
     bool openMainConnection();
-    bool createTables(QSqlDatabase &db);
+    // complete 返回全部索引、触发器是否创建成功（有失败时不记录指纹，下次启动重试）
+    bool createTables(QSqlDatabase &db, bool *complete = nullptr);
+    // 慢路径：执行 DDL 与迁移，成功后记录结构指纹
+    bool migrateSchema(QSqlDatabase &db, bool freshDatabase);
 
     bool removeDatabaseFile();
     void resetDatabase();
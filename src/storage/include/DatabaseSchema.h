@@ -13,6 +13,13 @@ public:
     static const char* TABLE_CONVERSATIONS;
     static const char* TABLE_MESSAGES;
     static const char* TABLE_MEDIA_CACHE;
+    static const char* TABLE_MESSAGE_DAY_SUMMARY;
+    static const char* TABLE_CONVERSATION_STATS;
+    static const char* TABLE_MESSAGE_PURGES;
+    static const char* TABLE_MESSAGE_IMPORT_MARKS;
+    static const char* TABLE_MESSAGE_IMPORTS;
+    static const char* TABLE_MESSAGE_MENTIONS;
+    static const char* TABLE_SCHEMA_META;
 
     // 创建表的SQL语句
     static QString getCreateTableUser();
@@ -22,9 +29,46 @@ public:
     static QString getCreateTableConversations();
     static QString getCreateTableMessages();
     static QString getCreateTableMediaCache();
+    static QString getCreateTableMessageDaySummary(const QString &schema = QString());
+    static QString getCreateTableConversationStats(const QString &schema = QString());
+    static QString getCreateTableMessagePurges(const QString &schema = QString());
+    static QString getCreateTableMessageImportMarks(const QString &schema = QString());
+    static QString getCreateTableMessageImports();
+    static QString getCreateTableMessageMentions();
+    static QString getCreateTableSchemaMeta();
+    // 主库全部建表语句（按依赖顺序）
+    static QStringList getCreateTables();
+
+    // 消息分片（ATTACH 的独立数据库文件，schema 为挂载名）
+    static QString getCreateTableMessageShard(const QString &schema);
+    static QStringList getCreateMessageShardIndexes(const QString &schema);
 
     static QStringList getCreateTriggers();
+
+    // 按天消息汇总的维护触发器与回填语句（schema 为空表示主库）
+    static QStringList getCreateDaySummaryTriggers(const QString &schema = QString());
+    static QStringList getBackfillDaySummary(const QString &schema = QString());
+
+    // 会话统计的维护触发器与回填语句
+    static QStringList getCreateConversationStatsTriggers(const QString &schema = QString());
+    static QStringList getBackfillConversationStats(const QString &schema = QString());
+
+    // 带批量清空/导入保护条件的触发器名（分别引用 message_purges / message_import_marks），旧库中不带条件的需重建
+    static QStringList getPurgeGuardedTriggerNames();
+    static QStringList getImportGuardedTriggerNames();
+    // 批量导入：重建被标记会话的派生表、删除 messages 二级索引
+    static QStringList getRebuildMarkedDerived(const QString &schema = QString());
+    // 批量清空：按剩余消息重建一个会话（0 为全部）的派生表
+    static QStringList getRebuildConversationDerived(const QString &schema, qint64 conversationId);
+    // 迁移回填：按剩余消息重建会话ID在 (afterId, lastId] 内的派生表
+    static QStringList getRebuildConversationRangeDerived(const QString &schema, qint64 afterId, qint64 lastId);
+    static QStringList getDropMessageIndexes(const QString &schema = QString());
     static QString getCreateIndexes();
+
+    // 结构指纹：建表、索引、触发器语句的摘要；与库中记录一致时启动跳过全部 DDL
+    static QString schemaFingerprint();
+    // 分片结构指纹（非零正整数，记录在分片的 PRAGMA user_version 中）
+    static int shardSchemaFingerprint();
 };
 
 #endif // DATABASESCHEMA_H
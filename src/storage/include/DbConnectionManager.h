@@ -4,6 +4,7 @@
 #include <QThreadStorage>
 #include <QMutex>
 
+// 常驻线程（数据库线程）的连接，随线程存活；线程池中的短任务改用 DbConnectionPool 借用连接
 class DbConnectionManager {
 public:
     static QSharedPointer<QSqlDatabase> connectionForCurrentThread();
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <QSqlDatabase>
+#include <QSharedPointer>
+#include <QList>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
+
+class QThread;
+
+/**
+ * @brief 供线程池任务使用的有界数据库连接池
+ *
+ * DbConnectionManager 为常驻线程（数据库线程）按线程保存连接；线程池中的短任务
+ * （导出、媒体缓存查询等）改从连接池借用连接，用完由 Lease 析构自动归还：
+ *  - QSqlDatabase 只能在创建它的线程中使用，因此连接在借用方线程上打开，只借给同一线程，
+ *    也由该线程关闭：线程池线程复用时沿用自己的连接，线程结束（QThread::finished）时关闭；
+ *  - 连接数不超过上限，连接全部借出时借用方等待，超时返回无效 Lease；上限已满但有其他线程
+ *    的空闲连接时将其退役（不再计入上限），由所属线程在下次借用/归还或结束时关闭；
+ *  - 连接创建时执行一次 applyPragmas，之后复用不再重复；
+ *  - 空闲超过 kIdleTimeoutMs 的连接在所属线程借用/归还时回收（至少保留 kMinIdle 个）；
+ *  - 统计借用等待时间与连接数，等待明显偏长时打印警告。
+ * Lease 须在借用它的线程上归还；归还前借用方需结束事务并 DETACH 自己附加的分片
+ * （MessageShardRouter 析构时会完成）。
+ * 连接池不随静态析构释放，退出前（QCoreApplication 销毁前）须调用 shutdown()。
+ */
+class DbConnectionPool {
+public:
+    struct Metrics {
+        int size = 0;             // 当前打开的连接数
+        int idle = 0;             // 空闲连接数
+        int maxSize = 0;          // 连接数上限
+        qint64 checkouts = 0;     // 累计借用次数
+        qint64 waits = 0;         // 需要等待的借用次数
+        qint64 totalWaitMs = 0;   // 累计等待时间
+        qint64 maxWaitMs = 0;     // 单次最长等待
+        qint64 timeouts = 0;      // 等待超时次数
+        qint64 created = 0;       // 累计创建的连接数
+        qint64 reaped = 0;        // 累计回收的空闲连接数
+    };
+
+    // 借用的连接，析构时归还；只能移动不能复制
+    class Lease {
+    public:
+        Lease() = default;
+        ~Lease();
+        Lease(Lease &&other) noexcept;
+        Lease &operator=(Lease &&other) noexcept;
+        Lease(const Lease &) = delete;
+        Lease &operator=(const Lease &) = delete;
+
+        bool isValid() const { return !m_database.isNull(); }
+        explicit operator bool() const { return isValid(); }
+        QSharedPointer<QSqlDatabase> database() const { return m_database; }
+        QSqlDatabase &operator*() const { return *m_database; }
+        QSqlDatabase *operator->() const { return m_database.data(); }
+
+        void release(); // 提前归还
+
+    private:
+        friend class DbConnectionPool;
+        Lease(DbConnectionPool *pool, QSharedPointer<QSqlDatabase> database);
+
+        DbConnectionPool *m_pool = nullptr;
+        QSharedPointer<QSqlDatabase> m_database;
+        QThread *m_thread = nullptr; // 借用线程，须在该线程上归还
+    };
+
+    static DbConnectionPool &instance();
+
+    // 借用连接：有空闲连接直接返回，未达上限时新建，否则最多等待 timeoutMs
+    Lease acquire(int timeoutMs = kDefaultAcquireTimeoutMs);
+
+    // 退出前调用：拒绝新的借用，最多等待 timeoutMs 让借出的连接归还，然后关闭全部连接；
+    // 线程池任务应已结束，此时剩余连接不再被任何线程使用，由调用线程统一关闭
+    void shutdown(int timeoutMs = kDefaultAcquireTimeoutMs);
+
+    Metrics metrics() const;
+
+    static constexpr int kDefaultAcquireTimeoutMs = 5000;
+    static constexpr int kMinIdle = 1;
+    static constexpr qint64 kIdleTimeoutMs = 60 * 1000;
+
+private:
+    struct Entry {
+        QSharedPointer<QSqlDatabase> database;
+        qint64 idleSinceMs = 0;
+        QThread *owner = nullptr; // 创建连接的线程，只在该线程上借出和关闭
+    };
+
+    DbConnectionPool();
+    ~DbConnectionPool() = default;
+
+    void release(QSharedPointer<QSqlDatabase> database);
+    QSharedPointer<QSqlDatabase> openConnection(); // 不持锁调用
+    // 当前线程拥有的、空闲超时的连接与退役连接
+    void reapIdleLocked(qint64 nowMs, QList<QSharedPointer<QSqlDatabase>> *reaped);
+    void watchThreadLocked(QThread *thread);       // 线程结束时关闭它的连接
+    void closeThreadConnections(QThread *thread);  // 在 thread 自身上调用
+    static void closeConnection(QSharedPointer<QSqlDatabase> &database); // 关闭并移除连接，调用前需释放其他副本
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_available;
+    QList<Entry> m_idle;      // 空闲连接，末尾为最近归还的
+    QList<Entry> m_retired;   // 已退役、等待所属线程关闭的空闲连接
+    QSet<QThread *> m_watchedThreads;
+    int m_size = 0;           // 已打开（含借出）与正在打开的连接数，不含退役连接
+    int m_maxSize = 0;
+    bool m_shutdown = false;
+    Metrics m_metrics;
+};
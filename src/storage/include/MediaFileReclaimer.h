@@ -0,0 +1,32 @@
+#pragma once
+
+#include <QObject>
+#include <QStringList>
+#include <QThreadPool>
+
+/**
+ * @brief 媒体文件回收队列：消息批量清空后，在后台线程删除其引用的本地媒体文件
+ *
+ * 只回收应用数据目录下由本程序生成的文件（图片、视频、缩略图、语音、接收的文件），
+ * 用户从其他位置选择发送的原始文件不会被触碰。
+ * 单线程串行删除，避免与前台缩略图加载等 IO 争抢磁盘。
+ */
+class MediaFileReclaimer : public QObject {
+    Q_OBJECT
+public:
+    explicit MediaFileReclaimer(QObject *parent = nullptr);
+    ~MediaFileReclaimer() override;
+
+    // 入队一批待删除的文件路径（空串和重复路径会被忽略）
+    void enqueue(const QStringList &paths);
+
+    // 路径是否位于可回收的应用数据子目录中
+    static bool isReclaimable(const QString &path);
+
+signals:
+    // 每批删除完成后发出（在后台线程发出，跨线程连接自动排队）
+    void reclaimed(int fileCount, qint64 bytes);
+
+private:
+    QThreadPool m_pool;
+};
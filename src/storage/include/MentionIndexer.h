@@ -0,0 +1,41 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QSharedPointer>
+#include <QtSql/QSqlDatabase>
+#include "models/Message.h"
+
+/**
+ * @brief 群聊 @ 提及索引（message_mentions）的维护
+ *
+ * 写入消息时提取正文中的 @昵称（按群内昵称或用户昵称匹配群成员，@所有人 匹配全部成员），
+ * 只为当前登录用户写入 (会话, 消息, 被提及用户) 索引行（@我 索引），与消息在同一事务提交。
+ * 未读提及走 (user_id, conversation_id) 部分索引，所有群的未读 @ 一次查询即可取出。
+ * 索引表只存在于主库，消息 ID 与所属会话一起定位，分片被整体删除后清理失效的行。
+ */
+class MentionIndexer {
+public:
+    explicit MentionIndexer(QSharedPointer<QSqlDatabase> database);
+
+    // 提取并写入提及，非群聊或不含 @ 时不访问数据库；markRead 用于导入的历史消息
+    bool index(const Message &message, bool markRead = false, QString *error = nullptr);
+
+    bool removeMessage(qint64 conversationId, qint64 messageId, QString *error = nullptr);
+    // 删除 message_id 不超过 maxMessageId 的索引行，conversationId 为 0 时不限会话
+    bool removeConversation(qint64 conversationId, qint64 maxMessageId, QString *error = nullptr);
+    // 分片删除后清理该分片时间范围 [startTime, endTime) 内消息已不存在的索引行
+    bool removeOrphansBetween(qint64 startTime, qint64 endTime, QString *error = nullptr);
+
+    // 正文中的 @ 名称（@ 后到空白或下一个 @ 为止）
+    static QStringList extractNames(const QString &content);
+
+private:
+    qint64 groupOf(qint64 conversationId); // 会话所属群ID，单聊返回 0
+    qint64 currentUserId();                // 当前登录用户ID，尚未登录返回 0
+
+    QSharedPointer<QSqlDatabase> m_database;
+    QHash<qint64, qint64> m_groupOfConversation; // 会话类型不会变化，缓存查询结果
+    qint64 m_currentUserId = 0;                  // 登录后不变，查到后缓存
+};
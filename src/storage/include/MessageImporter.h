@@ -0,0 +1,79 @@
+#pragma once
+
+#include <QObject>
+#include <QSet>
+#include <QList>
+#include <QSharedPointer>
+#include <QtSql/QSqlDatabase>
+
+class QFile;
+class MessageShardRouter;
+class ConversationSummarizer;
+class MentionIndexer;
+
+/**
+ * @brief 批量导入 JSON Lines 聊天记录（ConversationExporter 导出格式）
+ *
+ * 与批量清空一样在数据库线程分批执行，批与批之间让出事件循环：
+ *  - 每批在一个事务内写入，检查点（文件偏移）随同一事务提交，中断后从检查点继续；
+ *  - 导入期间在 message_import_marks 中标记涉及的会话，插入触发器跳过逐行维护，
+ *    结束时按会话一次性重建按天汇总与统计，会话摘要也只重算一次；
+ *  - @ 提及照常写入索引，但作为历史消息标为已读；
+ *  - 文件较大时先删除 messages 二级索引，结束后重建。
+ * 取消或失败同样执行收尾（重建派生表、恢复索引、移除标记），但保留检查点以便继续。
+ */
+class MessageImporter : public QObject {
+    Q_OBJECT
+public:
+    MessageImporter(QSharedPointer<QSqlDatabase> database, MessageShardRouter *router,
+                    ConversationSummarizer *summarizer, MentionIndexer *mentions, QObject *parent = nullptr);
+    ~MessageImporter() override;
+
+    // 同一文件存在检查点且大小未变时从检查点继续
+    void start(int reqId, const QString &archivePath);
+    void cancel(int reqId);
+
+    // 存在检查点（未完成）的导入文件
+    QStringList pendingArchives() const;
+    // 启动时调用：上次进程在导入中途退出，对其涉及的会话执行收尾，检查点保留
+    void recoverInterrupted();
+
+signals:
+    void importProgress(int reqId, qint64 importedCount, qint64 bytesRead, qint64 bytesTotal);
+    void importFinished(int reqId, bool ok, QString reason, qint64 importedCount, qint64 skippedCount);
+
+private slots:
+    void runStep();
+
+private:
+    struct Job {
+        int reqId = 0;
+        QString path;
+        qint64 size = 0;
+        qint64 offset = 0;          // 已提交内容的结束位置
+        qint64 imported = 0;
+        qint64 skipped = 0;
+        QSet<qint64> conversations; // 已写入的会话（含此前中断的部分）
+        QSet<QString> periods;      // 已写入的分片周期（空串为主库表）
+        QSet<QString> prepared;     // 本次运行已处理（删除索引）的分片周期
+        QSet<QString> marked;       // 本次运行已写入标记的 "周期:会话ID"
+        bool dropIndexes = false;
+        bool cancelled = false;
+        QSharedPointer<QFile> file;
+    };
+
+    bool openJob(Job &job, QString *error);
+    bool importBatch(Job &job, bool *done, QString *error);
+    bool saveCheckpoint(const Job &job, QString *error);
+    // 收尾：恢复索引、重建被标记会话的派生表、移除标记、重算会话摘要
+    void cleanup(const QSet<qint64> &conversations, const QSet<QString> &periods);
+    void finishJob(Job &job, bool ok, const QString &reason);
+
+    QSharedPointer<QSqlDatabase> m_database;
+    MessageShardRouter *m_router;
+    ConversationSummarizer *m_summarizer;
+    MentionIndexer *m_mentions;
+    QList<Job> m_jobs;              // 排队中的导入任务，队首为正在执行的任务
+    QSet<qint64> m_knownConversations; // 导入开始时已存在的会话与用户（外键校验）
+    QSet<qint64> m_knownUsers;
+};
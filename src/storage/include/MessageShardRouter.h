@@ -0,0 +1,81 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QSharedPointer>
+#include <QtSql/QSqlDatabase>
+#include <atomic>
+
+/**
+ * @brief 消息分片路由：按月份把消息写入独立的数据库文件（messages_yyyyMM.db）
+ *
+ * 分片文件按需 ATTACH 到当前线程的连接上（schema 名为 shard_yyyyMM），
+ * 同时挂载的分片数量有上限，超出时按最近最少使用顺序 DETACH。
+ * 主库中的 messages 表作为最旧的“历史分片”始终参与查询：进入分片模式时主库表已覆盖的月份
+ * （最新消息所在月份及更早）继续写入主库表，之后的月份才写入分片，因此主库表中的消息总比
+ * 所有分片旧，按 periodsNewestFirst 的顺序依次读取即按时间有序。关闭开关后只要还有分片，
+ * 新消息仍写入分片。
+ * 删除过期分片只需 DETACH 后删除文件，不再需要大范围 DELETE。
+ * 分片模式下 message_id 由主库中的单一序列分配（schema_meta 中的 message_seq），
+ * 写入时显式插入，保证主库表与各分片之间的消息ID不重复。
+ *
+ * 仅在 setEnabled(true) 或磁盘上已存在分片文件时生效；未生效时只路由到主库 messages 表，
+ * 与未分片的行为完全一致。
+ * 分片目录只在构造时扫描一次，之后由本路由的创建/删除维护周期列表，读写路由不再访问文件系统；
+ * 分片只由数据库线程上的路由创建和删除，其他线程上的短期路由（导出等）构造时取得当时的列表。
+ */
+class MessageShardRouter {
+public:
+    explicit MessageShardRouter(QSharedPointer<QSqlDatabase> database);
+    ~MessageShardRouter();
+
+    // 全局开关，需在 DatabaseManager::start() 之前设置
+    static void setEnabled(bool enabled);
+    static bool isEnabled();
+
+    static QString shardDirectory();                 // 分片文件目录（不保证已存在）
+    static QString periodForTime(qint64 msgTime);    // 时间戳 -> 分片周期（yyyyMM，UTC）
+    // 分片周期覆盖的时间范围 [startTime, endTime)
+    static void periodTimeRange(const QString &period, qint64 *startTime, qint64 *endTime);
+
+    bool isActive() const;                           // 是否处于分片模式
+
+    // 写入路由：返回 msgTime 所属分片的表名（必要时创建并挂载），不晚于主库表覆盖月份的写入主库表，失败返回空串
+    QString tableForWrite(qint64 msgTime, QString *error = nullptr);
+    // 在写事务内连续分配 count 个消息ID，返回第一个；未处于分片模式时返回 0（由表自行分配），失败返回 -1
+    // 须先调用 tableForWrite（序列的首次初始化需要挂载分片，不能在事务内进行）
+    qint64 allocateMessageIds(int count, QString *error = nullptr);
+
+    // 读取路由：按时间从新到旧返回所有分片周期，末尾的空串表示主库 messages 表
+    QStringList periodsNewestFirst() const;
+    // 与 [startTime, endTime] 有交集的分片周期（从旧到新，主库 messages 表在最前）
+    QStringList periodsInRange(qint64 startTime, qint64 endTime) const;
+
+    // 将分片周期解析为可直接用于 SQL 的表名（按需挂载），失败返回空串
+    // table 为分片库中的表名，默认 messages，也可以是 message_day_summary 等随分片存放的表
+    QString tableForPeriod(const QString &period, const QString &table = QStringLiteral("messages"));
+
+    // 删除整个分片：DETACH 后删除文件
+    bool dropShard(const QString &period, QString *error = nullptr);
+    // 删除早于 period 的所有分片，返回实际删除的周期
+    QStringList dropShardsBefore(const QString &period);
+
+private:
+    QString attach(const QString &period, bool create, QString *error);
+    void detach(const QString &period);
+    void touch(const QString &period);
+    static QString schemaName(const QString &period);
+    static QString shardFilePath(const QString &period);
+    static QStringList scanPeriods();
+    bool ensureIdSequence(QString *error);
+    bool ensureMainBoundary(QString *error);
+
+    QSharedPointer<QSqlDatabase> m_database;
+    QStringList m_periods;    // 磁盘上已有的分片周期（升序），构造时扫描
+    QStringList m_attached;   // 已挂载周期，最近使用的在末尾
+    bool m_sequenceReady = false; // 主库中的消息ID序列已初始化
+    QString m_mainBoundary;       // 主库表最新消息所在周期，不晚于它的消息写入主库表（空串表示主库表为空）
+    bool m_boundaryReady = false;
+
+    static std::atomic<bool> s_enabled;
+};
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <QSharedPointer>
+#include <QtSql/QSqlDatabase>
+
+struct sqlite3;
+struct sqlite3_stmt;
+class NativeStatementCache;
+
+/**
+ * @brief 已编译语句的 RAII 句柄（来自 NativeStatementCache）
+ *
+ * 绕过 QtSql 驱动层：参数按类型直接绑定，列按类型直接读取，只有文本列做 UTF-8 -> QString 转换。
+ * 析构时 reset 并清空绑定，语句回到缓存供下次复用。参数与列序号与 SQL 中的顺序一致（参数从 1 开始，列从 0 开始）。
+ */
+class NativeStatement {
+public:
+    NativeStatement() = default;
+    ~NativeStatement();
+    NativeStatement(NativeStatement &&other) noexcept;
+    NativeStatement &operator=(NativeStatement &&other) noexcept;
+    NativeStatement(const NativeStatement &) = delete;
+    NativeStatement &operator=(const NativeStatement &) = delete;
+
+    bool isValid() const { return m_stmt != nullptr; }
+    explicit operator bool() const { return isValid(); }
+
+    void bindInt64(int index, qint64 value);
+    void bindText(int index, const QString &value);
+    void bindNull(int index);
+    void bind(int index, const QVariant &value); // 空值、整数或文本
+
+    // 取下一行：有结果行返回 true；执行完毕或出错返回 false（用 hasError 区分）
+    bool next();
+    // 执行到结束（写语句）
+    bool exec();
+    // 重置到可重新绑定执行的状态（同一语句循环执行时使用）
+    void reset();
+    bool hasError() const { return !m_error.isEmpty(); }
+    QString errorString() const { return m_error; }
+
+    qint64 int64At(int column) const;
+    int intAt(int column) const;
+    QString textAt(int column) const;
+    bool isNullAt(int column) const;
+    QVariant valueAt(int column) const; // 空值、整数或文本
+
+private:
+    friend class NativeStatementCache;
+    NativeStatement(NativeStatementCache *cache, sqlite3_stmt *stmt, const QString &sql);
+    void release();
+
+    NativeStatementCache *m_cache = nullptr;
+    sqlite3_stmt *m_stmt = nullptr;
+    QString m_sql;
+    QString m_error;
+};
+
+/**
+ * @brief Qt 连接背后 sqlite3 句柄上的语句缓存（热点查询的原生快速路径）
+ *
+ * 与 QtSql 共用同一个连接，事务（db.transaction()）、ATTACH 的分片对两边同样可见。
+ * 构建时未找到 SQLite3 开发库，或运行时 Qt 驱动插件没有使用与本模块同一个 SQLite 共享库
+ * （Qt 默认构建自带 SQLite，两份库的全局状态相互独立，不能共用句柄），isAvailable() 返回 false，
+ * 调用方继续走 QtSql 路径。
+ * 只能在连接所属线程使用；必须在连接关闭前析构。
+ */
+class NativeStatementCache {
+public:
+    explicit NativeStatementCache(QSharedPointer<QSqlDatabase> database);
+    ~NativeStatementCache();
+
+    bool isAvailable() const { return m_handle != nullptr; }
+
+    // 取缓存中已编译的语句，不存在时编译；失败返回无效句柄
+    NativeStatement prepare(const QString &sql, QString *error = nullptr);
+    qint64 lastInsertId() const;
+    // 自上次调用以来连接的页缓存命中/未命中次数（读取后清零），供基准比较查询的页读取量；不可用时返回 false
+    bool takePageCacheStats(int *hits, int *misses);
+    static constexpr int kMaxCachedStatements = 64;
+
+private:
+    friend class NativeStatement;
+    void release(const QString &sql, sqlite3_stmt *stmt, bool reusable);
+
+    QSharedPointer<QSqlDatabase> m_database;
+    sqlite3 *m_handle = nullptr;
+    QHash<QString, sqlite3_stmt *> m_idle; // SQL -> 空闲的已编译语句
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <QObject>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QHash>
+#include <QtSql/QSqlDatabase>
+
+class QTimer;
+class MessageShardRouter;
+class MentionIndexer;
+
+/**
+ * @brief 结构迁移：版本号记录在 PRAGMA user_version
+ *
+ * 每个迁移分两部分：
+ *  - 结构变更（ALTER TABLE 等快速 DDL），启动时由 DatabaseInitializer 在初始化连接上同步执行；
+ *  - 数据回填（可选），登记到 schema_meta 的 backfill:<版本>，界面启动后由数据库线程分块执行，
+ *    每块一个事务并随同提交游标，块与块之间间隔 kStepIntervalMs 让出数据库线程，中断后从游标继续。
+ * 新建的数据库没有历史数据，只记录版本号，不登记回填。
+ */
+class SchemaMigrator : public QObject {
+    Q_OBJECT
+public:
+    // 当前代码对应的迁移版本
+    static int latestVersion();
+
+    // 执行 fromVersion 之后各迁移的结构变更并登记回填，最后写入 user_version（调用方负责事务）
+    static bool applySchemaSteps(QSqlDatabase &db, int fromVersion, bool freshDatabase, QString *error = nullptr);
+
+    SchemaMigrator(QSharedPointer<QSqlDatabase> database, MessageShardRouter *router,
+                   MentionIndexer *mentions, QObject *parent = nullptr);
+
+    // 延迟 delayMs 后开始执行未完成的回填（数据库线程调用）
+    void start(int delayMs = kStartDelayMs);
+
+    static constexpr int kStartDelayMs = 3000;   // 等界面首屏加载完成
+    static constexpr int kStepIntervalMs = 50;   // 块间隔
+    static constexpr int kStepBudgetMs = 30;     // 单块耗时上限
+
+signals:
+    void backfillFinished(int version, bool ok);
+
+private slots:
+    void runStep();
+
+private:
+    // 各迁移的回填：从 cursor 继续处理一块，新游标与数据在同一事务提交，完成时置 done
+    bool backfillStep(int version, QString *cursor, bool *done, QString *error);
+    bool backfillMentions(QString *cursor, bool *done, QString *error);
+    bool backfillDerived(QString *cursor, bool *done, QString *error);
+
+    bool saveCursor(int version, const QString &cursor, bool done, QString *error);
+
+    QSharedPointer<QSqlDatabase> m_database;
+    MessageShardRouter *m_router;
+    MentionIndexer *m_mentions;
+    QTimer *m_timer;
+    QList<int> m_pending;          // 未完成回填的迁移版本，升序
+    QHash<int, QString> m_cursors; // 迁移版本 -> 回填游标
+};
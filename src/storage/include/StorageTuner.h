@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QString>
+#include <QtSql/QSqlDatabase>
+#include <QHash>
+#include <QMutex>
+
+// 存储调优档位：由数据库大小、WAL 大小和可用内存共同决定
+struct StorageTuningProfile {
+    int tier = -1;                  // 档位（数据库每翻一倍升一档，-1 表示未计算）
+    qint64 dbBytes = 0;             // 测量时的数据库文件大小
+    qint64 walBytes = 0;            // 测量时的 WAL 文件大小
+    qint64 availableRamBytes = 0;   // 测量时的可用物理内存
+
+    qint64 cacheSizeKiB = 64000;    // PRAGMA cache_size（以 KiB 计，写入时取负值）
+    qint64 mmapSizeBytes = 0;       // PRAGMA mmap_size（0 表示关闭）
+    int walAutoCheckpoint = 1000;   // PRAGMA wal_autocheckpoint（页数）
+    qint64 softHeapLimitBytes = 0;  // PRAGMA soft_heap_limit（进程级页缓存上限，0 表示不限制）
+
+    QString toString() const;
+};
+
+/**
+ * @brief 根据数据库规模与主机内存自适应选择 SQLite 参数
+ *
+ * 调优策略：
+ *  - cache_size：数据库大小的 1/4，下限 8 MiB，上限取 256 MiB 与可用内存 1/16 的较小值；
+ *  - mmap_size：可用内存不足 2 GiB 时关闭；否则为数据库大小的 2 倍（预留增长空间），
+ *    下限 64 MiB，上限取 1 GiB 与可用内存 1/8 的较小值；基准测试发现 mmap 更慢时关闭；
+ *  - wal_autocheckpoint：数据库越大检查点越稀疏（1000/4000/8000 页），
+ *    但 WAL 已超过 64 MiB 时回落到 1000 页，尽快把 WAL 收回；
+ *  - soft_heap_limit：可用内存的 1/8，限定在 64 MiB ~ 1 GiB。
+ *
+ * 档位按数据库大小的倍增划分（16 MiB 为第 0 档），数据库跨档增长时重新应用参数。
+ * mmap 对比基准每个档位只测一次，结论记录在 schema_meta 中，之后启动直接沿用。
+ */
+class StorageTuner {
+public:
+    // 纯策略函数：给定测量值返回调优档位
+    static StorageTuningProfile chooseProfile(qint64 dbBytes, qint64 walBytes, qint64 availableRamBytes);
+
+    // 测量数据库文件、WAL 文件和可用内存后选择档位
+    static StorageTuningProfile measure(const QString &dbPath);
+
+    // 将档位应用到指定连接，并记录该连接当前的档位
+    static void apply(QSqlDatabase &db, const StorageTuningProfile &profile);
+
+    // 重新测量，档位变化时重新应用；返回是否发生了调整
+    static bool retuneIfNeeded(QSqlDatabase &db);
+
+    // 验证所选档位（mmap 开/关对比）：数据库档位与上次测量时相同则沿用记录的结论，
+    // 档位变化或设置了环境变量 WECHAT_STORAGE_BENCHMARK=1 时重新测量
+    static void benchmarkIfNeeded(QSqlDatabase &db);
+
+    // 当前生效的档位
+    static StorageTuningProfile currentProfile();
+
+    // 可用物理内存（字节），无法获取时返回 1 GiB
+    static qint64 availableMemoryBytes();
+
+private:
+    static qint64 benchmarkReads(QSqlDatabase &db);
+    // 读写 schema_meta 中的基准结论（"档位:mmap 是否关闭"），无记录时返回 false
+    static bool loadBenchmarkResult(QSqlDatabase &db, int *tier, bool *mmapDisabled);
+    static void saveBenchmarkResult(QSqlDatabase &db, int tier, bool mmapDisabled);
+
+    static QMutex s_mutex;
+    static StorageTuningProfile s_current;
+    static QHash<QString, int> s_appliedTiers; // 连接名 -> 已应用档位
+    static bool s_mmapDisabledByBenchmark;
+};
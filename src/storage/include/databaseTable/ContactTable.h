@@ -21,8 +21,8 @@ public slots:
     void getCurrentUser(int reqId);//获取当前登录用户
 
     // 异步槽函数：均携带reqId参数，用于Controller区分并发请求的结果对应关系
-    void saveContact(int reqId, Contact contact);    // 保存联系人（新增）
-    void updateContact(int reqId, Contact contact);  // 更新联系人信息
+    void saveContact(int reqId, const Contact &contact);    // 保存联系人（新增）
+    void updateContact(int reqId, const Contact &contact);  // 更新联系人信息
     void deleteContact(int reqId, qint64 userId);    // 根据用户ID删除联系人
 
 
@@ -42,10 +42,10 @@ signals:
     void contactUpdated(int reqId, bool ok, QString reason);    // 联系人更新结果
     void contactDeleted(int reqId, bool ok, QString reason);    // 联系人删除结果
 
-    void allContactsLoaded(int reqId, QList<Contact> contacts);      // 所有联系人加载完成（返回联系人列表）
-    void contactLoaded(int reqId, Contact contact);                  // 单个联系人加载完成（返回联系人对象）
-    void searchContactsResult(int reqId, QList<Contact> contacts);   // 搜索联系人结果（返回符合条件的联系人列表）
-    void starredContactsLoaded(int reqId, QList<Contact> contacts);  // 星标联系人加载完成
+    void allContactsLoaded(int reqId, const QList<Contact> &contacts);      // 所有联系人加载完成（返回联系人列表）
+    void contactLoaded(int reqId, const Contact &contact);                  // 单个联系人加载完成（返回联系人对象）
+    void searchContactsResult(int reqId, const QList<Contact> &contacts);   // 搜索联系人结果（返回符合条件的联系人列表）
+    void starredContactsLoaded(int reqId, const QList<Contact> &contacts);  // 星标联系人加载完成
 
     void contactStarredSet(int reqId, bool ok);    // 星标状态设置结果
     void contactBlockedSet(int reqId, bool ok);    // 屏蔽状态设置结果
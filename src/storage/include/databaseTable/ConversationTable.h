@@ -22,6 +22,10 @@ public slots:
     void deleteConversation(int reqId, qint64 conversationId);   // 根据会话ID删除会话
 
     void getAllConversations(int reqId);                         // 获取所有会话
+    // 按 (is_top, last_message_time, conversation_id) 降序分页：游标为上一页最后一个会话，cursorConversationId <= 0 时从头读取
+    void getConversationsPage(int reqId, qint64 cursorConversationId, bool cursorIsTop, qint64 cursorTime, int limit);
+    // 查找会话（按会话ID，或按单聊对方用户ID）及其在列表排序中的位置，用于加载到包含该会话的页
+    void locateConversation(int reqId, qint64 conversationId, qint64 userId);
     void getConversation(int reqId, qint64 conversationId);      // 根据会话ID获取单个会话
 
     void setUnreadCount(int reqId, qint64 conversationId, int unreadCount);     // 设置会话未读消息数量
@@ -34,8 +38,10 @@ signals:
     void conversationUpdated(int reqId, bool ok, QString reason);         // 会话更新结果（成功状态及失败原因）
     void conversationDeleted(int reqId, bool ok, qint64 conversationId);  // 会话删除结果（成功状态及被删除的会话ID）
 
-    void allConversationsLoaded(int reqId, QList<Conversation> conversations);  // 所有会话加载完成（返回会话列表）
-    void conversationLoaded(int reqId, Conversation conversation);              // 单个会话加载完成（返回会话对象）
+    void allConversationsLoaded(int reqId, const QList<Conversation> &conversations);  // 所有会话加载完成（返回会话列表）
+    void conversationsPageLoaded(int reqId, bool firstPage, const QList<Conversation> &conversations, bool hasMore); // 一页会话加载完成
+    void conversationLocated(int reqId, const Conversation &conversation, int row);    // 会话定位结果（row 为排序位置，未找到为 -1）
+    void conversationLoaded(int reqId, const Conversation &conversation);              // 单个会话加载完成（返回会话对象）
 
     void topStatusToggled(int reqId, qint64 conversationId);  // 会话置顶状态切换结果（返回被操作的会话ID）
     void dbError(int reqId, QString error);                   // 数据库操作错误信号（错误信息）
@@ -3,8 +3,22 @@
 #include <QObject>
 #include <QtSql/QSqlDatabase>
 #include <QList>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
 #include "models/Message.h"
 #include "models/MediaItem.h"
+#include "models/MessageDaySummary.h"
+#include "models/ConversationStats.h"
+#include "models/MentionSummary.h"
+
+class MessageShardRouter;
+class MediaFileReclaimer;
+class ConversationSummarizer;
+class MessageImporter;
+class MentionIndexer;
+class SchemaMigrator;
+class NativeStatementCache;
 
 class MessageTable : public QObject {
     Q_OBJECT
@@ -17,43 +31,134 @@ public:
 public slots:
     // 异步操作（带 reqId）
     void saveMessage(int reqId, Message message);
-    void updateMessage(int reqId, Message message);
+    void updateMessage(int reqId, const Message &message);
     void deleteMessage(int reqId, qint64 messageId);
 
     void getMessages(int reqId, qint64 conversationId, int limit, int offset);
+    // 锚点窗口：anchorMessageId 之前 before 条、之后（含锚点）after 条；之后按游标向两侧扩展
+    void getMessagesAround(int reqId, qint64 conversationId, qint64 anchorMessageId, int before, int after);
+    void getMessagesFrom(int reqId, qint64 conversationId, qint64 cursorTime, qint64 cursorMessageId,
+                         bool older, int limit);
     void getMessage(int reqId, qint64 messageId);
     void getLastMessage(int reqId, qint64 conversationId);
 
+    // 清空走分块批量删除：删除触发器被 message_purges 标记跳过，汇总在结束时一次性修正，
+    // 媒体文件交给后台回收队列；分块之间让出事件循环，其他数据库请求可以穿插执行
     void clearMessages(int reqId);
     void clearConversationMessages(int reqId, qint64 conversationId);
 
     void getMessagesByTimeRange(int reqId, qint64 conversationId, qint64 startTime, qint64 endTime);
     void getMessageCount(int reqId, qint64 conversationId);
+    void getConversationStats(int reqId, qint64 conversationId);
 
     void getMediaItems(int reqId, qint64 conversationId);
+    // 媒体画廊按窗口加载：以 anchorMessageId 为中心前后各 radius 条，之后按游标向两侧扩展
+    void getMediaWindow(int reqId, qint64 conversationId, qint64 anchorMessageId, int radius);
+    void getMediaPage(int reqId, qint64 conversationId, qint64 cursorTime, qint64 cursorMessageId,
+                      bool older, int limit);
+
+    // 群聊 @ 提及：一次查询取出用户在所有会话中的未读提及；打开会话后标为已读
+    void getUnreadMentions(int reqId, qint64 userId);
+    void markMentionsRead(int reqId, qint64 userId, qint64 conversationId);
+
+    // 按天汇总：时间轴密度与跳转到日期
+    void getDaySummaries(int reqId, qint64 conversationId);
+    void getMessagesAtDate(int reqId, qint64 conversationId, int dayKey, int limit);
+
+    // 删除早于 beforeTime 所在月份的消息分片（文件级删除）
+    void dropMessageShardsBefore(int reqId, qint64 beforeTime);
+
+    // 批量导入 JSON Lines 聊天记录：分批大事务写入，可中断后从检查点继续，见 MessageImporter
+    void importMessages(int reqId, QString archivePath);
+    void cancelImport(int reqId);
+    void getPendingImports(int reqId);
 
 signals:
 
     void messageSaved(int reqId, bool ok, QString reason);
+    // 写入成功后携带数据库分配的 messageId，供缓存等保持同步
+    void messageInserted(int reqId, const Message &message);
     void messageUpdated(int reqId, bool ok, QString reason);
     void messageDeleted(int reqId, bool ok, QString reason);
 
-    void messagesLoaded(int reqId, QVector<Message> messages);
-    void messageLoaded(int reqId, Message message);
-    void lastMessageLoaded(int reqId, Message message);
+    void messagesLoaded(int reqId, const QVector<Message> &messages);
+    // 结果均按时间升序
+    void messagesAroundLoaded(int reqId, qint64 anchorMessageId, const QVector<Message> &messages, bool hasOlder, bool hasNewer);
+    void messagesPageLoaded(int reqId, bool older, const QVector<Message> &messages, bool hasMore);
+    void messageLoaded(int reqId, const Message &message);
+    void lastMessageLoaded(int reqId, const Message &message);
 
     void messagesCleared(int reqId, bool ok, QString reason);
     void conversationMessagesCleared(int reqId, bool ok, QString reason);
+    void purgeProgress(int reqId, int deletedCount);
 
-    void messagesByTimeRangeLoaded(int reqId, QList<Message> messages);
+    void messagesByTimeRangeLoaded(int reqId, const QList<Message> &messages);
     void messageCountLoaded(int reqId, int count);
+    void conversationStatsLoaded(int reqId, ConversationStats stats);
+
+    void mediaItemsLoaded(int reqId, const QList<MediaItem> &items);
+    // 结果均按时间升序
+    void mediaWindowLoaded(int reqId, qint64 anchorMessageId, const QList<MediaItem> &items, bool hasOlder, bool hasNewer);
+    void mediaPageLoaded(int reqId, bool older, const QList<MediaItem> &items, bool hasMore);
 
-    void mediaItemsLoaded(int reqId, QList<MediaItem> items);
+    void messageShardsDropped(int reqId, int count);
+
+    void unreadMentionsLoaded(int reqId, QList<MentionSummary> mentions);
+
+    void importProgress(int reqId, qint64 importedCount, qint64 bytesRead, qint64 bytesTotal);
+    void importFinished(int reqId, bool ok, QString reason, qint64 importedCount, qint64 skippedCount);
+    void pendingImportsLoaded(int reqId, QStringList archivePaths);
+
+    void daySummariesLoaded(int reqId, QList<MessageDaySummary> summaries);
+    // anchorMessageId 为目标日期（或其后最近一天）的第一条消息，结果从锚点起按时间升序
+    void messagesAtDateLoaded(int reqId, qint64 anchorMessageId, const QVector<Message> &messages, bool hasNewer);
 
     // 通用错误
     void dbError(int reqId, QString error);
 
+private slots:
+    void onRetuneTimeout();
+    void runPurgeStep();
+
 private:
+    struct PurgeJob {
+        int reqId = 0;
+        qint64 conversationId = 0; // 0 表示清空全部消息
+        QStringList periods;       // 尚未处理的分片周期（空串为主库表）
+        QStringList marked;        // 已写入清空标记的分片周期
+        QHash<QString, qint64> maxIds; // 请求清空时各分片的最大消息ID，之后写入的消息不在清空范围内
+        QSet<QString> mediaPaths;  // 已删除消息引用的媒体文件，清空结束后回收仍无消息引用的部分
+        int deleted = 0;
+    };
+    void enqueuePurge(int reqId, qint64 conversationId);
+    bool purgeChunk(PurgeJob &job, const QString &period, bool *done, QString *error);
+    void finishPurge(const PurgeJob &job, bool ok, const QString &reason);
+    // 从 paths 中去掉主库表或任一分片中仍有消息引用的路径（导入与重发的消息可能共用同一文件）
+    QStringList unreferencedMediaPaths(const QSet<QString> &paths);
+
+    // 读取并合并各分片中的会话统计
+    bool loadConversationStats(qint64 conversationId, ConversationStats *stats, QString *error);
+    // 从游标沿指定方向跨分片读取最多 limit 条消息（联表带发送者信息），结果按读取方向排列
+    bool fetchMessagePage(qint64 conversationId, qint64 cursorTime, qint64 cursorMessageId,
+                          bool older, bool inclusive, int limit,
+                          QVector<Message> *messages, QString *error);
+    // 执行联表查询并把结果行追加到 messages；有原生语句缓存时走原生路径，binds 依次绑定到占位符
+    bool appendJoinedRows(const QString &sql, const QVariantList &binds,
+                          QVector<Message> *messages, QString *error);
+    // 从游标 (cursorTime, cursorMessageId) 沿指定方向跨分片读取最多 limit 条媒体，结果按读取方向排列
+    bool fetchMediaPage(qint64 conversationId, qint64 cursorTime, qint64 cursorMessageId,
+                        bool older, bool inclusive, int limit,
+                        QList<MediaItem> *items, QString *error);
+
     QSharedPointer<QSqlDatabase> m_database;
+    QScopedPointer<NativeStatementCache> m_native; // 热点读写的原生 sqlite3 语句缓存（不可用时走 QtSql）
+    QScopedPointer<MessageShardRouter> m_router; // 消息分片路由（未启用分片时只路由到主库表）
+    QScopedPointer<ConversationSummarizer> m_summarizer; // 会话摘要批量维护（每次提交每个会话只写一次）
+    QScopedPointer<MentionIndexer> m_mentions; // 群聊 @ 提及索引维护
+    QTimer *m_retuneTimer = nullptr; // 定期按数据库增长重新评估存储调优档位
+    MediaFileReclaimer *m_reclaimer = nullptr; // 清空消息后的媒体文件回收
+    MessageImporter *m_importer = nullptr;     // 批量导入
+    SchemaMigrator *m_migrator = nullptr;      // 结构迁移的后台回填
+    QList<PurgeJob> m_purgeJobs;     // 排队中的清空任务，队首为正在执行的任务
 
 };
@@ -0,0 +1,256 @@
+#include "ConversationExporter.h"
+#include "DbConnectionPool.h"
+#include "MessageShardRouter.h"
+#include "DatabaseSchema.h"
+#include "models/Message.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QSaveFile>
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr int kPageSize = 500;                  // 每次从数据库读取的消息条数
+constexpr int kWriteBufferBytes = 256 * 1024;   // 写缓冲达到该大小后落盘
+constexpr int kProgressIntervalMs = 100;        // 进度信号最小间隔
+
+// 按 (msg_time, message_id) 游标向后读取一页，联表带发送者名称
+QString exportPageSql(const QString &table)
+{
+    return QString(R"(
+        SELECT
+            m.*,
+            CASE WHEN c.user_id IS NOT NULL THEN c.remark_name ELSE u.nickname END AS senderName
+        FROM %1 m
+        INNER JOIN users u ON m.sender_id = u.user_id
+        LEFT JOIN contacts c ON m.sender_id = c.user_id
+        WHERE m.conversation_id = ?
+          AND m.msg_time >= ? AND (m.msg_time > ? OR m.message_id > ?)
+        ORDER BY m.msg_time ASC, m.message_id ASC
+        LIMIT ?
+    )").arg(table);
+}
+
+// 会话消息总数：合并各分片的统计行
+qint64 totalMessageCount(QSqlDatabase &db, MessageShardRouter &router, qint64 conversationId)
+{
+    qint64 total = 0;
+    const QStringList periods = router.periodsNewestFirst();
+    for (const QString &period : periods) {
+        const QString table = router.tableForPeriod(period, DatabaseSchema::TABLE_CONVERSATION_STATS);
+        if (table.isEmpty()) continue;
+
+        QSqlQuery query(db);
+        query.prepare(QString("SELECT message_count FROM %1 WHERE conversation_id = ?").arg(table));
+        query.addBindValue(conversationId);
+        if (query.exec() && query.next()) total += query.value(0).toLongLong();
+    }
+    return total;
+}
+
+// 复制消息引用的本地文件，返回目标文件名；文件不存在或复制失败返回空串
+QString copyMediaFile(const Message &message, const QDir &mediaDir)
+{
+    const QFileInfo source(message.filePath);
+    if (message.filePath.isEmpty() || !source.isFile()) return QString();
+
+    // 以 messageId 为前缀，避免不同消息的同名文件互相覆盖
+    const QString name = QString("%1_%2").arg(message.messageId).arg(source.fileName());
+    const QString target = mediaDir.absoluteFilePath(name);
+    const QFileInfo existing(target);
+    if (existing.exists() && existing.size() == source.size()) return name;
+
+    QFile::remove(target);
+    if (!QFile::copy(source.absoluteFilePath(), target)) {
+        qWarning() << "Export: copy media failed" << source.absoluteFilePath();
+        return QString();
+    }
+    return name;
+}
+}
+
+ConversationExporter::ConversationExporter(QObject *parent)
+    : QObject(parent)
+{
+    // 单线程串行导出；数据库连接从 DbConnectionPool 借用，线程空闲后可正常回收
+    m_pool.setMaxThreadCount(1);
+}
+
+ConversationExporter::~ConversationExporter()
+{
+    cancelAll();
+    m_pool.waitForDone();
+}
+
+void ConversationExporter::exportConversation(int reqId, qint64 conversationId,
+                                              const QString &outputPath, bool copyMedia)
+{
+    CancelFlag cancelled = CancelFlag::create(false);
+    {
+        QMutexLocker lock(&m_mutex);
+        m_cancelFlags.insert(reqId, cancelled);
+    }
+
+    m_pool.start([this, reqId, conversationId, outputPath, copyMedia, cancelled]() {
+        run(reqId, conversationId, outputPath, copyMedia, cancelled);
+    });
+}
+
+void ConversationExporter::cancel(int reqId)
+{
+    QMutexLocker lock(&m_mutex);
+    if (const CancelFlag flag = m_cancelFlags.value(reqId)) flag->store(true);
+}
+
+void ConversationExporter::cancelAll()
+{
+    QMutexLocker lock(&m_mutex);
+    for (const CancelFlag &flag : std::as_const(m_cancelFlags)) flag->store(true);
+}
+
+void ConversationExporter::run(int reqId, qint64 conversationId, const QString &outputPath,
+                               bool copyMedia, const CancelFlag &cancelled)
+{
+    qint64 exported = 0;
+    auto finish = [&](bool ok, const QString &reason) {
+        {
+            QMutexLocker lock(&m_mutex);
+            m_cancelFlags.remove(reqId);
+        }
+        if (ok) qDebug() << "Exported" << exported << "messages of conversation" << conversationId << "to" << outputPath;
+        else qWarning() << "Export of conversation" << conversationId << "failed:" << reason;
+        emit exportFinished(reqId, ok, reason, exported);
+    };
+
+    if (cancelled->load()) {
+        finish(false, "Export cancelled");
+        return;
+    }
+
+    // 借用连接池中的连接，任务结束时归还（router 先析构，附加的分片随之 DETACH）
+    DbConnectionPool::Lease lease = DbConnectionPool::instance().acquire();
+    if (!lease) {
+        finish(false, "Failed to open database connection for export");
+        return;
+    }
+    QSharedPointer<QSqlDatabase> db = lease.database();
+    MessageShardRouter router(db);
+
+    QSaveFile file(outputPath);
+    if (!file.open(QIODevice::WriteOnly)) {
+        finish(false, file.errorString());
+        return;
+    }
+
+    QDir mediaDir;
+    QString mediaDirName;
+    if (copyMedia) {
+        const QFileInfo info(outputPath);
+        mediaDirName = info.completeBaseName() + "_media";
+        mediaDir = QDir(info.absolutePath());
+        if (!mediaDir.mkpath(mediaDirName) || !mediaDir.cd(mediaDirName)) {
+            file.cancelWriting();
+            finish(false, QString("Failed to create media directory %1").arg(mediaDirName));
+            return;
+        }
+    }
+
+    const qint64 total = totalMessageCount(*db, router, conversationId);
+    emit exportProgress(reqId, 0, total);
+
+    QByteArray buffer;
+    buffer.reserve(kWriteBufferBytes * 2);
+    auto flushBuffer = [&]() {
+        if (buffer.isEmpty()) return true;
+        if (file.write(buffer) != buffer.size()) return false;
+        buffer.clear();
+        return true;
+    };
+
+    QElapsedTimer progressTimer;
+    progressTimer.start();
+
+    // 按周期从旧到新逐个分片完整遍历：每个分片独立游标，保证每条消息恰好导出一次
+    QStringList periods = router.periodsNewestFirst();
+    std::reverse(periods.begin(), periods.end());
+
+    for (const QString &period : std::as_const(periods)) {
+        const QString table = router.tableForPeriod(period);
+        if (table.isEmpty()) continue;
+
+        QSqlQuery query(*db);
+        query.setForwardOnly(true);
+        query.prepare(exportPageSql(table));
+
+        qint64 cursorTime = std::numeric_limits<qint64>::min();
+        qint64 cursorMessageId = std::numeric_limits<qint64>::min();
+        for (;;) {
+            if (cancelled->load()) {
+                file.cancelWriting();
+                finish(false, "Export cancelled");
+                return;
+            }
+
+            query.addBindValue(conversationId);
+            query.addBindValue(cursorTime);
+            query.addBindValue(cursorTime);
+            query.addBindValue(cursorMessageId);
+            query.addBindValue(kPageSize);
+            if (!query.exec()) {
+                const QString error = query.lastError().text();
+                file.cancelWriting();
+                finish(false, error);
+                return;
+            }
+
+            int rows = 0;
+            while (query.next()) {
+                Message message(query);
+                QJsonObject json = message.toJson();
+                json.insert("sender_name", query.value("senderName").toString());
+                if (copyMedia) {
+                    const QString copied = copyMediaFile(message, mediaDir);
+                    if (!copied.isEmpty()) json.insert("export_file", mediaDirName + '/' + copied);
+                }
+                buffer += QJsonDocument(json).toJson(QJsonDocument::Compact);
+                buffer += '\n';
+
+                cursorTime = message.timestamp;
+                cursorMessageId = message.messageId;
+                ++rows;
+            }
+            query.finish();
+            exported += rows;
+
+            if (buffer.size() >= kWriteBufferBytes && !flushBuffer()) {
+                const QString error = file.errorString();
+                file.cancelWriting();
+                finish(false, error);
+                return;
+            }
+            if (progressTimer.elapsed() >= kProgressIntervalMs) {
+                emit exportProgress(reqId, exported, qMax(total, exported));
+                progressTimer.restart();
+            }
+            if (rows < kPageSize) break;
+        }
+    }
+
+    if (!flushBuffer() || !file.commit()) {
+        const QString error = file.errorString();
+        file.cancelWriting();
+        finish(false, error);
+        return;
+    }
+
+    emit exportProgress(reqId, exported, qMax(total, exported));
+    finish(true, QString());
+}
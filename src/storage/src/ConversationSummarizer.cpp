@@ -0,0 +1,181 @@
+#include "ConversationSummarizer.h"
+#include "MessageShardRouter.h"
+#include "NativeSqlite.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QDebug>
+
+ConversationSummarizer::ConversationSummarizer(QSharedPointer<QSqlDatabase> database, MessageShardRouter *router)
+    : m_database(std::move(database))
+    , m_router(router)
+{
+}
+
+void ConversationSummarizer::recordInsert(qint64 conversationId, const QString &content, qint64 msgTime)
+{
+    Pending &p = m_pending[conversationId];
+    p.inserted = true;
+    p.lastContent = content;
+    p.lastTime = msgTime;
+    ++p.insertCount;
+}
+
+void ConversationSummarizer::recordDelete(qint64 conversationId, qint64 msgTime)
+{
+    Pending &p = m_pending[conversationId];
+    if (!p.deleted || msgTime > p.maxDeletedTime) p.maxDeletedTime = msgTime;
+    p.deleted = true;
+}
+
+void ConversationSummarizer::markStale(qint64 conversationId)
+{
+    m_pending[conversationId].stale = true;
+}
+
+bool ConversationSummarizer::flush(QString *error)
+{
+    if (m_pending.isEmpty()) return true;
+
+    const QString updateSql = QStringLiteral(
+        "UPDATE conversations "
+        "SET last_message_content = ?, last_message_time = ?, unread_count = unread_count + ? "
+        "WHERE conversation_id = ?");
+
+    if (nativeEnabled()) {
+        for (auto it = m_pending.cbegin(); it != m_pending.cend(); ++it) {
+            const Pending &p = it.value();
+            if (p.inserted) {
+                NativeStatement update = m_native->prepare(updateSql, error);
+                if (!update) return false;
+                update.bind(1, p.lastContent);
+                update.bindInt64(2, p.lastTime);
+                update.bindInt64(3, p.insertCount);
+                update.bindInt64(4, it.key());
+                if (!update.exec()) {
+                    if (error) *error = update.errorString();
+                    return false;
+                }
+            }
+            if ((p.deleted || p.stale) && !recompute(it.key(), p, error))
+                return false;
+        }
+        m_pending.clear();
+        return true;
+    }
+
+    QSqlQuery update(*m_database);
+    update.prepare(updateSql);
+
+    for (auto it = m_pending.cbegin(); it != m_pending.cend(); ++it) {
+        const Pending &p = it.value();
+        if (p.inserted) {
+            update.addBindValue(p.lastContent);
+            update.addBindValue(p.lastTime);
+            update.addBindValue(p.insertCount);
+            update.addBindValue(it.key());
+            if (!update.exec()) {
+                if (error) *error = update.lastError().text();
+                return false;
+            }
+        }
+        if ((p.deleted || p.stale) && !recompute(it.key(), p, error))
+            return false;
+    }
+
+    m_pending.clear();
+    return true;
+}
+
+void ConversationSummarizer::discard()
+{
+    m_pending.clear();
+}
+
+bool ConversationSummarizer::recompute(qint64 conversationId, const Pending &pending, QString *error)
+{
+    QVariant content;
+    QVariant msgTime;
+
+    // 主库表与各分片中取最新的一条
+    const QStringList periods = m_router->periodsNewestFirst();
+    for (const QString &period : periods) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
+
+        if (!latestInTable(table, conversationId, &content, &msgTime, error)) return false;
+    }
+    // 没有剩余消息时写 0 而不是 NULL：会话列表按 (is_top, last_message_time, conversation_id) 行值比较分页，
+    // NULL 参与比较结果为 NULL，该会话会从后续页中消失
+    if (msgTime.isNull()) msgTime = qint64(0);
+
+    // 与原删除触发器一致：只有删除的消息不早于当前摘要时才更新
+    const QString updateSql = QString("UPDATE conversations SET last_message_content = ?, last_message_time = ? "
+                                      "WHERE conversation_id = ?%1").arg(pending.stale ? "" : " AND last_message_time <= ?");
+    if (nativeEnabled()) {
+        NativeStatement update = m_native->prepare(updateSql, error);
+        if (!update) return false;
+        update.bind(1, content);
+        update.bind(2, msgTime);
+        update.bindInt64(3, conversationId);
+        if (!pending.stale) update.bindInt64(4, pending.maxDeletedTime);
+        if (!update.exec()) {
+            if (error) *error = update.errorString();
+            return false;
+        }
+        return true;
+    }
+
+    QSqlQuery update(*m_database);
+    update.prepare(updateSql);
+    update.addBindValue(content);
+    update.addBindValue(msgTime);
+    update.addBindValue(conversationId);
+    if (!pending.stale) update.addBindValue(pending.maxDeletedTime);
+    if (!update.exec()) {
+        if (error) *error = update.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool ConversationSummarizer::latestInTable(const QString &table, qint64 conversationId,
+                                           QVariant *content, QVariant *msgTime, QString *error)
+{
+    const QString sql = QString("SELECT content, msg_time FROM %1 WHERE conversation_id = ? "
+                                "ORDER BY msg_time DESC, message_id DESC LIMIT 1").arg(table);
+
+    if (nativeEnabled()) {
+        NativeStatement query = m_native->prepare(sql, error);
+        if (!query) return false;
+        query.bindInt64(1, conversationId);
+        if (query.next()) {
+            if (msgTime->isNull() || query.int64At(1) > msgTime->toLongLong()) {
+                *content = query.valueAt(0);
+                *msgTime = query.int64At(1);
+            }
+        } else if (query.hasError()) {
+            if (error) *error = query.errorString();
+            return false;
+        }
+        return true;
+    }
+
+    QSqlQuery query(*m_database);
+    query.prepare(sql);
+    query.addBindValue(conversationId);
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    if (query.next() && (msgTime->isNull() || query.value(1).toLongLong() > msgTime->toLongLong())) {
+        *content = query.value(0);
+        *msgTime = query.value(1);
+    }
+    return true;
+}
+
+bool ConversationSummarizer::nativeEnabled() const
+{
+    return m_native && m_native->isAvailable();
+}
@@ -1,5 +1,7 @@
 #include "DatabaseInitializer.h"
 #include "DatabaseSchema.h"
+#include "StorageTuner.h"
+#include "SchemaMigrator.h"
 #include <QStandardPaths>
 #include <QDir>
 #include <QSqlQuery>
@@ -15,16 +17,8 @@ DatabaseInitializer::DatabaseInitializer(QObject* parent)
     : QObject(parent)
 {
     m_dbPath = databasePath();
-    // 如果外部已经初始化过，标记也要同步
-    if (!s_initialized.load()) {
-        QMutexLocker lock(&s_initMutex);
-        if (!s_initialized.load()) {
-            if (databaseFileExists()) {
-                s_initialized.store(true);
-                qDebug() << "Database already exists and is valid, marked as initialized";
-            }
-        }
-    }
+    // 已存在的数据库也需要走一次 ensureInitialized：结构指纹或迁移版本落后时执行 DDL（均为 IF NOT EXISTS）
+    // 与迁移，新版本增加的表、索引和触发器由此补齐到旧数据库上；结构已是最新时跳过
 }
 
 DatabaseInitializer::~DatabaseInitializer()
@@ -72,15 +66,22 @@ bool DatabaseInitializer::ensureInitialized()
 
     applyPragmas(db);
 
-    bool ok = createTables(db);
+    bool ok = true;
+    if (dbFileExisted && isSchemaCurrent(db)) {
+        qDebug() << "Database schema is current, skipping DDL";
+    } else {
+        ok = migrateSchema(db, !dbFileExisted);
+    }
 
     db.close();
     QSqlDatabase::removeDatabase("main");
 
     if (!ok) {
         qCritical() << "Database initialization failed";
-        // 初始化失败时删除数据库文件
-        removeDatabaseFile();
+        // 仅删除本次新建的数据库文件，已有数据不能因补齐结构失败而丢失
+        if (!dbFileExisted) {
+            removeDatabaseFile();
+        }
         return false;
     }
 
@@ -109,7 +110,6 @@ void DatabaseInitializer::applyPragmas(QSqlDatabase &db)
         "PRAGMA foreign_keys = ON",
         "PRAGMA journal_mode = WAL",
         "PRAGMA synchronous = NORMAL",
-        "PRAGMA cache_size = -64000",
         "PRAGMA temp_store = MEMORY"
     };
     for (const QString &p : pragmas) {
@@ -117,9 +117,63 @@ void DatabaseInitializer::applyPragmas(QSqlDatabase &db)
         if (!q.exec(p))
             qWarning() << "Failed to set pragma" << p << q.lastError().text();
     }
+
+    // cache_size / mmap_size / wal_autocheckpoint 按数据库规模与可用内存自适应
+    StorageTuner::apply(db, StorageTuner::measure(db.databaseName()));
+}
+
+bool DatabaseInitializer::isSchemaCurrent(QSqlDatabase &db)
+{
+    QSqlQuery q(db);
+    if (!q.exec("PRAGMA user_version") || !q.next() || q.value(0).toInt() != SchemaMigrator::latestVersion())
+        return false;
+
+    // 旧库没有 schema_meta 表时查询失败，同样走慢路径
+    q.prepare(QString("SELECT value FROM %1 WHERE key = 'fingerprint'").arg(DatabaseSchema::TABLE_SCHEMA_META));
+    return q.exec() && q.next() && q.value(0).toString() == DatabaseSchema::schemaFingerprint();
+}
+
+void DatabaseInitializer::invalidateSchemaFingerprint(QSqlDatabase &db, const QString &schema)
+{
+    QSqlQuery q(db);
+    const bool ok = schema.isEmpty()
+        ? q.exec(QString("DELETE FROM %1 WHERE key = 'fingerprint'").arg(DatabaseSchema::TABLE_SCHEMA_META))
+        : q.exec(QString("PRAGMA %1.user_version = 0").arg(schema));
+    if (!ok) qWarning() << "Invalidate schema fingerprint failed:" << q.lastError().text();
 }
 
-bool DatabaseInitializer::createTables(QSqlDatabase &db)
+bool DatabaseInitializer::migrateSchema(QSqlDatabase &db, bool freshDatabase)
+{
+    bool complete = true;
+    if (!createTables(db, &complete)) return false;
+
+    QSqlQuery q(db);
+    const int fromVersion = (q.exec("PRAGMA user_version") && q.next()) ? q.value(0).toInt() : 0;
+
+    if (!db.transaction()) {
+        qCritical() << "Failed to start transaction for migrations:" << db.lastError().text();
+        return false;
+    }
+    QString error;
+    if (!SchemaMigrator::applySchemaSteps(db, fromVersion, freshDatabase, &error)) {
+        db.rollback();
+        qCritical() << error;
+        return false;
+    }
+    if (complete) {
+        q.prepare(QString("INSERT OR REPLACE INTO %1 (key, value) VALUES ('fingerprint', ?)")
+                      .arg(DatabaseSchema::TABLE_SCHEMA_META));
+        q.addBindValue(DatabaseSchema::schemaFingerprint());
+        if (!q.exec()) qWarning() << "Save schema fingerprint failed:" << q.lastError().text();
+    }
+    if (!db.commit()) {
+        qCritical() << "Commit failed for migrations:" << db.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool DatabaseInitializer::createTables(QSqlDatabase &db, bool *complete)
 {
     // 开始事务
     if (!db.transaction()) {
@@ -130,15 +184,7 @@ bool DatabaseInitializer::createTables(QSqlDatabase &db)
     QSqlQuery q(db);
 
     // 1. 先创建所有表
-    const QStringList tables = {
-        DatabaseSchema::getCreateTableUser(),
-        DatabaseSchema::getCreateTableContacts(),
-        DatabaseSchema::getCreateTableGroups(),
-        DatabaseSchema::getCreateTableGroupMembers(),
-        DatabaseSchema::getCreateTableConversations(),
-        DatabaseSchema::getCreateTableMessages(),
-        DatabaseSchema::getCreateTableMediaCache()
-    };
+    const QStringList tables = DatabaseSchema::getCreateTables();
 
     for (const QString &sql : tables) {
         if (!q.exec(sql)) {
@@ -168,11 +214,13 @@ bool DatabaseInitializer::createTables(QSqlDatabase &db)
             if (!q.exec(trimmedSql)) {
                 qWarning() << "Create index failed:" << q.lastError().text() << "SQL:" << trimmedSql;
                 // 索引创建失败不中断，继续执行
+                if (complete) *complete = false;
             }
         }
     }
 
     // 创建触发器
+    dropUnguardedTriggers(db);
     const QStringList triggers = DatabaseSchema::getCreateTriggers();
     for (const QString& sql : triggers) {
         const QString trimmedSql = sql.trimmed();
@@ -180,6 +228,7 @@ bool DatabaseInitializer::createTables(QSqlDatabase &db)
             if (!q.exec(trimmedSql)) {
                 qWarning() << "Create trigger failed:" << q.lastError().text() << "SQL:" << trimmedSql;
                 // 触发器创建失败不中断，继续执行
+                if (complete) *complete = false;
             }
         }
     }
@@ -190,9 +239,80 @@ bool DatabaseInitializer::createTables(QSqlDatabase &db)
         return false;
     }
 
+    // 旧数据库上的汇总/统计表由结构迁移 2 在后台按会话分块回填（SchemaMigrator），不在启动时同步执行
     return true;
 }
 
+bool DatabaseInitializer::backfillDerivedTables(QSqlDatabase &db, const QString &schema)
+{
+    const QString prefix = schema.isEmpty() ? QString() : schema + ".";
+    QSqlQuery q(db);
+    if (!q.exec(QString("SELECT 1 FROM %1messages LIMIT 1").arg(prefix)) || !q.next())
+        return true;
+
+    // 派生表 -> 回填语句；派生表非空说明已由触发器维护，跳过
+    const QList<QPair<QString, QStringList>> derived = {
+        {DatabaseSchema::TABLE_MESSAGE_DAY_SUMMARY, DatabaseSchema::getBackfillDaySummary(schema)},
+        {DatabaseSchema::TABLE_CONVERSATION_STATS, DatabaseSchema::getBackfillConversationStats(schema)}
+    };
+
+    bool ok = true;
+    for (const auto &entry : derived) {
+        if (q.exec(QString("SELECT 1 FROM %1%2 LIMIT 1").arg(prefix, entry.first)) && q.next())
+            continue;
+
+        if (!db.transaction()) {
+            qWarning() << "Failed to start transaction for backfill:" << db.lastError().text();
+            return false;
+        }
+        bool stepOk = true;
+        for (const QString &sql : entry.second) {
+            if (!q.exec(sql)) {
+                qWarning() << "Backfill" << entry.first << "failed:" << q.lastError().text();
+                stepOk = false;
+                break;
+            }
+        }
+        if (!stepOk) {
+            db.rollback();
+            ok = false;
+            continue;
+        }
+        if (!db.commit()) {
+            qWarning() << "Commit failed for backfill:" << db.lastError().text();
+            ok = false;
+            continue;
+        }
+        qDebug() << "Backfilled" << entry.first << "for" << (schema.isEmpty() ? QString("main") : schema);
+    }
+    return ok;
+}
+
+void DatabaseInitializer::dropUnguardedTriggers(QSqlDatabase &db, const QString &schema)
+{
+    const QString prefix = schema.isEmpty() ? QString() : schema + ".";
+    // 删除触发器须引用清空标记表，插入触发器须引用导入标记表
+    const QList<QPair<QStringList, QString>> guards{
+        {DatabaseSchema::getPurgeGuardedTriggerNames(), DatabaseSchema::TABLE_MESSAGE_PURGES},
+        {DatabaseSchema::getImportGuardedTriggerNames(), DatabaseSchema::TABLE_MESSAGE_IMPORT_MARKS}};
+
+    QSqlQuery q(db);
+    QStringList outdated;
+    for (const auto &guard : guards) {
+        if (!q.exec(QString("SELECT name FROM %1sqlite_master WHERE type = 'trigger' "
+                            "AND name IN ('%2') AND sql NOT LIKE '%%3%'")
+                        .arg(prefix, guard.first.join("', '"), guard.second))) {
+            qWarning() << "Query triggers failed:" << q.lastError().text();
+            return;
+        }
+        while (q.next()) outdated << q.value(0).toString();
+    }
+    for (const QString &name : std::as_const(outdated)) {
+        if (!q.exec(QString("DROP TRIGGER IF EXISTS %1%2").arg(prefix, name)))
+            qWarning() << "Drop trigger failed:" << name << q.lastError().text();
+    }
+}
+
 bool DatabaseInitializer::removeDatabaseFile()
 {
     if (m_dbPath.isEmpty()) {
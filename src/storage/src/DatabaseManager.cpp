@@ -1,4 +1,5 @@
 #include "DatabaseManager.h"
+#include "DbConnectionPool.h"
 #include <QDebug>
 #include "UserTable.h"
 #include "ContactTable.h"
@@ -58,6 +59,8 @@ void DatabaseManager::stop()
         m_dbThread->quit();
         m_dbThread->wait(3000); // 可调整超时
     }
+    // 线程池任务已随各自的所有者结束，关闭连接池中剩余的连接（须在 QCoreApplication 销毁前）
+    DbConnectionPool::instance().shutdown();
 }
 
 
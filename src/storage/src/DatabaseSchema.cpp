@@ -1,5 +1,6 @@
 #include "DatabaseSchema.h"
 #include <QStringList>
+#include <QCryptographicHash>
 
 // 数据库表名常量定义
 const char* DatabaseSchema::TABLE_CURRENT_USER = "users";
@@ -9,6 +10,41 @@ const char* DatabaseSchema::TABLE_GROUPS = "groups";
 const char* DatabaseSchema::TABLE_CONVERSATIONS = "conversations";
 const char* DatabaseSchema::TABLE_MESSAGES = "messages";
 const char* DatabaseSchema::TABLE_MEDIA_CACHE = "media_cache";
+const char* DatabaseSchema::TABLE_MESSAGE_DAY_SUMMARY = "message_day_summary";
+const char* DatabaseSchema::TABLE_CONVERSATION_STATS = "conversation_stats";
+const char* DatabaseSchema::TABLE_MESSAGE_PURGES = "message_purges";
+const char* DatabaseSchema::TABLE_MESSAGE_IMPORT_MARKS = "message_import_marks";
+const char* DatabaseSchema::TABLE_MESSAGE_IMPORTS = "message_imports";
+const char* DatabaseSchema::TABLE_MESSAGE_MENTIONS = "message_mentions";
+const char* DatabaseSchema::TABLE_SCHEMA_META = "schema_meta";
+
+namespace {
+// 消息时间戳 -> 本地日期键（yyyyMMdd）
+QString dayKeyExpr(const QString &column)
+{
+    return QString("CAST(strftime('%Y%m%d', %1, 'unixepoch', 'localtime') AS INTEGER)").arg(column);
+}
+
+QString schemaPrefix(const QString &schema)
+{
+    return schema.isEmpty() ? QString() : schema + ".";
+}
+
+// 删除触发器的保护条件：会话（或整库，conversation_id = 0）正在批量清空时跳过逐行维护，
+// 由清空流程结束时一次性修正汇总数据
+const char *kPurgeGuard =
+    "WHEN NOT EXISTS (SELECT 1 FROM message_purges WHERE conversation_id IN (OLD.conversation_id, 0))";
+
+// 插入触发器的保护条件：会话正在批量导入时跳过逐行维护，由导入结束时按会话重建汇总数据
+const char *kImportGuard =
+    "WHEN NOT EXISTS (SELECT 1 FROM message_import_marks WHERE conversation_id = NEW.conversation_id)";
+
+// messages 表（主库与分片）上的二级索引名，批量导入期间可整体删除后重建
+const char *const kMessageIndexNames[] = {
+    "idx_messages_conversation_time", "idx_messages_conversation_page", "idx_messages_conversation_keys",
+    "idx_messages_sender_time", "idx_messages_time", "idx_messages_type", "idx_messages_media_gallery"
+};
+}
 
 /**
  * @brief 获取创建"用户表"的SQL语句
@@ -109,7 +145,7 @@ QString DatabaseSchema::getCreateTableConversations() {
             avatar TEXT,                                 -- 会话头像URL
             avatar_local_path TEXT,                      -- 头像本地路径
             last_message_content TEXT,                   -- 最后一条消息内容
-            last_message_time INTEGER,                   -- 最后一条消息时间戳
+            last_message_time INTEGER DEFAULT 0,         -- 最后一条消息时间戳，没有消息时为 0（不为 NULL，分页游标依赖行值比较）
 
             unread_count INTEGER DEFAULT 0,              -- 未读数量
             is_top INTEGER DEFAULT 0,                    -- 是否置顶
@@ -149,6 +185,183 @@ QString DatabaseSchema::getCreateTableMessages() {
     )";
 }
 
+/**
+ * @brief 获取创建"消息分片表"的SQL语句
+ * 与 messages 表结构一致；SQLite 不支持跨库外键，分片表不声明外键
+ * message_id 不在分片内自增，由主库序列分配后显式写入（见 MessageShardRouter::allocateMessageIds）
+ */
+QString DatabaseSchema::getCreateTableMessageShard(const QString &schema) {
+    return QString(R"(
+        CREATE TABLE IF NOT EXISTS %1.messages (
+            message_id INTEGER PRIMARY KEY,              -- 消息ID
+            conversation_id INTEGER NOT NULL,            -- 所属会话ID
+            sender_id INTEGER NOT NULL,                  -- 发送者用户ID
+            consignee_id INTEGER NOT NULL,               -- 接收者用户ID
+
+            type INTEGER NOT NULL,                       -- 消息类型
+            content TEXT,                                -- 消息内容
+            file_path TEXT,                              -- 媒体本地路径
+            file_url TEXT,                               -- 媒体远程URL
+            file_size INTEGER,                           -- 媒体大小（字节）
+            duration INTEGER,                            -- 音视频时长（秒）
+            thumbnail_path TEXT,                         -- 缩略图路径
+            msg_time INTEGER                             -- 发送/接收时间戳
+        )
+    )").arg(schema);
+}
+
+/**
+ * @brief 获取创建消息分片索引的SQL语句
+ */
+QStringList DatabaseSchema::getCreateMessageShardIndexes(const QString &schema) {
+    return {
+        QString("DROP INDEX IF EXISTS %1.idx_messages_conversation_time").arg(schema),
+        QString("DROP INDEX IF EXISTS %1.idx_messages_conversation_page").arg(schema),
+        QString("CREATE INDEX IF NOT EXISTS %1.idx_messages_conversation_keys ON messages(conversation_id, msg_time, message_id, "
+                "sender_id, consignee_id, type)").arg(schema),
+        QString("CREATE INDEX IF NOT EXISTS %1.idx_messages_time ON messages(msg_time DESC)").arg(schema),
+        QString("CREATE INDEX IF NOT EXISTS %1.idx_messages_media_gallery ON messages(conversation_id, msg_time, message_id, "
+                "type, thumbnail_path, file_path, file_url) WHERE type IN (1, 2)").arg(schema)
+    };
+}
+
+/**
+ * @brief 获取创建"按天消息汇总表"的SQL语句
+ * 每个会话每天一行，由触发器随消息插入/删除增量维护
+ */
+QString DatabaseSchema::getCreateTableMessageDaySummary(const QString &schema) {
+    return QString(R"(
+        CREATE TABLE IF NOT EXISTS %1message_day_summary (
+            conversation_id INTEGER NOT NULL,            -- 会话ID
+            day INTEGER NOT NULL,                        -- 本地日期（yyyyMMdd）
+            message_count INTEGER NOT NULL DEFAULT 0,    -- 当天消息数
+            first_message_id INTEGER,                    -- 当天第一条消息ID
+            first_msg_time INTEGER,                      -- 当天第一条消息时间
+            last_message_id INTEGER,                     -- 当天最后一条消息ID
+            last_msg_time INTEGER,                       -- 当天最后一条消息时间
+
+            PRIMARY KEY (conversation_id, day)
+        ) WITHOUT ROWID
+    )").arg(schemaPrefix(schema));
+}
+
+/**
+ * @brief 获取创建"会话统计表"的SQL语句
+ * 每个会话一行，由触发器随消息插入/删除以 O(1) 增量维护
+ */
+QString DatabaseSchema::getCreateTableConversationStats(const QString &schema) {
+    return QString(R"(
+        CREATE TABLE IF NOT EXISTS %1conversation_stats (
+            conversation_id INTEGER PRIMARY KEY,         -- 会话ID
+            message_count INTEGER NOT NULL DEFAULT 0,    -- 消息总数
+            text_count INTEGER NOT NULL DEFAULT 0,       -- 文本消息数
+            image_count INTEGER NOT NULL DEFAULT 0,      -- 图片消息数
+            video_count INTEGER NOT NULL DEFAULT 0,      -- 视频消息数
+            file_count INTEGER NOT NULL DEFAULT 0,       -- 文件消息数
+            voice_count INTEGER NOT NULL DEFAULT 0,      -- 语音消息数
+            media_bytes INTEGER NOT NULL DEFAULT 0,      -- 媒体/文件总字节数
+            first_msg_time INTEGER,                      -- 第一条消息时间
+            last_msg_time INTEGER                        -- 最后一条消息时间
+        )
+    )").arg(schemaPrefix(schema));
+}
+
+/**
+ * @brief 获取创建"批量清空标记表"的SQL语句
+ * 存在记录期间，对应会话的删除触发器不再逐行执行
+ */
+QString DatabaseSchema::getCreateTableMessagePurges(const QString &schema) {
+    return QString(R"(
+        CREATE TABLE IF NOT EXISTS %1message_purges (
+            conversation_id INTEGER PRIMARY KEY          -- 正在清空的会话ID，0 表示整表清空
+        )
+    )").arg(schemaPrefix(schema));
+}
+
+/**
+ * @brief 获取创建"批量导入标记表"的SQL语句
+ * 存在记录期间，对应会话的插入触发器不再逐行执行；与清空标记分表，两者互不清除对方的标记
+ */
+QString DatabaseSchema::getCreateTableMessageImportMarks(const QString &schema) {
+    return QString(R"(
+        CREATE TABLE IF NOT EXISTS %1message_import_marks (
+            conversation_id INTEGER PRIMARY KEY          -- 正在导入的会话ID
+        )
+    )").arg(schemaPrefix(schema));
+}
+
+/**
+ * @brief 获取创建"群聊 @ 提及索引表"的SQL语句
+ * 写入消息时提取，只记录当前登录用户被提及的消息；未读提及由 idx_mentions_unread 部分索引按用户一次查出
+ */
+QString DatabaseSchema::getCreateTableMessageMentions() {
+    return R"(
+        CREATE TABLE IF NOT EXISTS message_mentions (
+            conversation_id INTEGER NOT NULL,            -- 会话ID
+            message_id INTEGER NOT NULL,                 -- 消息ID
+            user_id INTEGER NOT NULL,                    -- 被提及的用户ID
+            msg_time INTEGER NOT NULL,                   -- 消息时间
+            is_read INTEGER NOT NULL DEFAULT 0,          -- 是否已读
+
+            PRIMARY KEY (conversation_id, message_id, user_id)
+        ) WITHOUT ROWID
+    )";
+}
+
+/**
+ * @brief 获取创建"结构元数据表"的SQL语句
+ * fingerprint：当前结构指纹；backfill:<版本>：尚未完成的迁移回填及其游标；
+ * tuning_benchmark：存储调优基准的结论（"档位:mmap 是否关闭"）；
+ * message_seq：分片模式下已分配的最大消息ID（主库表与各分片共用一个ID序列）
+ * 迁移版本本身记录在 PRAGMA user_version 中
+ */
+QString DatabaseSchema::getCreateTableSchemaMeta() {
+    return R"(
+        CREATE TABLE IF NOT EXISTS schema_meta (
+            key TEXT PRIMARY KEY,                        -- 键
+            value TEXT                                   -- 值
+        )
+    )";
+}
+
+QStringList DatabaseSchema::getCreateTables() {
+    return {
+        getCreateTableUser(),
+        getCreateTableContacts(),
+        getCreateTableGroups(),
+        getCreateTableGroupMembers(),
+        getCreateTableConversations(),
+        getCreateTableMessages(),
+        getCreateTableMediaCache(),
+        getCreateTableMessageDaySummary(),
+        getCreateTableConversationStats(),
+        getCreateTableMessagePurges(),
+        getCreateTableMessageImportMarks(),
+        getCreateTableMessageImports(),
+        getCreateTableMessageMentions(),
+        getCreateTableSchemaMeta()
+    };
+}
+
+/**
+ * @brief 获取创建"消息导入检查点表"的SQL语句
+ * 每批写入与检查点在同一事务提交，中断后从 byte_offset 继续
+ */
+QString DatabaseSchema::getCreateTableMessageImports() {
+    return R"(
+        CREATE TABLE IF NOT EXISTS message_imports (
+            archive_path TEXT PRIMARY KEY,               -- 导入文件路径
+            archive_size INTEGER NOT NULL,               -- 导入文件大小（判断文件是否变化）
+            byte_offset INTEGER NOT NULL DEFAULT 0,      -- 已提交内容在文件中的结束位置
+            imported_count INTEGER NOT NULL DEFAULT 0,   -- 已写入条数
+            skipped_count INTEGER NOT NULL DEFAULT 0,    -- 跳过条数（格式错误或引用不存在的会话/用户）
+            conversations TEXT,                          -- 已写入的会话ID（逗号分隔）
+            periods TEXT,                                -- 已写入的分片周期（逗号分隔，main 为主库表）
+            started_at INTEGER                           -- 开始时间
+        )
+    )";
+}
+
 /**
  * @brief 获取创建"媒体缓存表"的SQL语句
  */
@@ -170,50 +383,15 @@ QString DatabaseSchema::getCreateTableMediaCache() {
 
 
 /**
- * @brief 获取创建消息表触发器的SQL语句
- * 用于在插入、更新、删除消息时自动更新会话的最后消息
+ * @brief 获取创建触发器的SQL语句
+ * 会话最后消息/未读数不再由触发器维护，见 ConversationSummarizer
  */
 QStringList DatabaseSchema::getCreateTriggers()
 {
-    return {
-        // 消息插入触发器 - 简化版本
-        R"(
-            CREATE TRIGGER IF NOT EXISTS trigger_conversation_insert
-            AFTER INSERT ON messages
-            FOR EACH ROW
-            BEGIN
-                UPDATE conversations
-                SET last_message_content = NEW.content,
-                    last_message_time = NEW.msg_time,
-                    unread_count = unread_count + 1
-                WHERE conversation_id = NEW.conversation_id;
-            END
-        )",
-
-        // 消息删除触发器 - 简化版本
-        R"(
-            CREATE TRIGGER IF NOT EXISTS trigger_conversation_delete
-            AFTER DELETE ON messages
-            FOR EACH ROW
-            BEGIN
-                -- 只有当删除的是最后一条消息时才更新
-                UPDATE conversations
-                SET last_message_content = (
-                    SELECT content FROM messages
-                    WHERE conversation_id = OLD.conversation_id
-                    ORDER BY msg_time DESC, message_id DESC
-                    LIMIT 1
-                ),
-                last_message_time = (
-                    SELECT msg_time FROM messages
-                    WHERE conversation_id = OLD.conversation_id
-                    ORDER BY msg_time DESC, message_id DESC
-                    LIMIT 1
-                )
-                WHERE conversation_id = OLD.conversation_id
-                AND last_message_time <= OLD.msg_time;
-            END
-        )",
+    return getCreateDaySummaryTriggers() + getCreateConversationStatsTriggers() + QStringList{
+        // 会话摘要改由 ConversationSummarizer 在写事务提交前批量维护，移除旧版逐行触发器
+        "DROP TRIGGER IF EXISTS trigger_conversation_insert",
+        "DROP TRIGGER IF EXISTS trigger_conversation_delete",
 
         // 唯一当前用户触发器
         R"(
@@ -275,6 +453,332 @@ QStringList DatabaseSchema::getCreateTriggers()
 }
 
 
+/**
+ * @brief 获取维护按天消息汇总的触发器
+ * 插入时 UPSERT 当天计数与首尾消息；删除时计数减一，删除的恰好是首/尾消息时在当天范围内重新定位
+ */
+QStringList DatabaseSchema::getCreateDaySummaryTriggers(const QString &schema)
+{
+    const QString prefix = schemaPrefix(schema);
+    const QString newDay = dayKeyExpr("NEW.msg_time");
+    const QString oldDay = dayKeyExpr("OLD.msg_time");
+    const QString rowDay = dayKeyExpr("msg_time");
+
+    return {
+        QString(R"(
+            CREATE TRIGGER IF NOT EXISTS %1trigger_day_summary_insert
+            AFTER INSERT ON messages
+            FOR EACH ROW
+            )" + QString(kImportGuard) + R"(
+            BEGIN
+                INSERT INTO message_day_summary
+                    (conversation_id, day, message_count,
+                     first_message_id, first_msg_time, last_message_id, last_msg_time)
+                VALUES (NEW.conversation_id, %2, 1,
+                        NEW.message_id, NEW.msg_time, NEW.message_id, NEW.msg_time)
+                ON CONFLICT(conversation_id, day) DO UPDATE SET
+                    message_count = message_count + 1,
+                    first_message_id = CASE WHEN excluded.first_msg_time < first_msg_time
+                                            THEN excluded.first_message_id ELSE first_message_id END,
+                    first_msg_time = MIN(first_msg_time, excluded.first_msg_time),
+                    last_message_id = CASE WHEN excluded.last_msg_time >= last_msg_time
+                                           THEN excluded.last_message_id ELSE last_message_id END,
+                    last_msg_time = MAX(last_msg_time, excluded.last_msg_time);
+            END
+        )").arg(prefix, newDay),
+
+        QString(R"(
+            CREATE TRIGGER IF NOT EXISTS %1trigger_day_summary_delete
+            AFTER DELETE ON messages
+            FOR EACH ROW
+            )" + QString(kPurgeGuard) + R"(
+            BEGIN
+                UPDATE message_day_summary
+                SET message_count = message_count - 1,
+                    first_message_id = CASE WHEN first_message_id = OLD.message_id THEN (
+                        SELECT message_id FROM messages
+                        WHERE conversation_id = OLD.conversation_id
+                          AND msg_time BETWEEN OLD.msg_time - 86400 AND OLD.msg_time + 86400
+                          AND %3 = %2
+                        ORDER BY msg_time ASC, message_id ASC LIMIT 1
+                    ) ELSE first_message_id END,
+                    first_msg_time = CASE WHEN first_message_id = OLD.message_id THEN (
+                        SELECT msg_time FROM messages
+                        WHERE conversation_id = OLD.conversation_id
+                          AND msg_time BETWEEN OLD.msg_time - 86400 AND OLD.msg_time + 86400
+                          AND %3 = %2
+                        ORDER BY msg_time ASC, message_id ASC LIMIT 1
+                    ) ELSE first_msg_time END,
+                    last_message_id = CASE WHEN last_message_id = OLD.message_id THEN (
+                        SELECT message_id FROM messages
+                        WHERE conversation_id = OLD.conversation_id
+                          AND msg_time BETWEEN OLD.msg_time - 86400 AND OLD.msg_time + 86400
+                          AND %3 = %2
+                        ORDER BY msg_time DESC, message_id DESC LIMIT 1
+                    ) ELSE last_message_id END,
+                    last_msg_time = CASE WHEN last_message_id = OLD.message_id THEN (
+                        SELECT msg_time FROM messages
+                        WHERE conversation_id = OLD.conversation_id
+                          AND msg_time BETWEEN OLD.msg_time - 86400 AND OLD.msg_time + 86400
+                          AND %3 = %2
+                        ORDER BY msg_time DESC, message_id DESC LIMIT 1
+                    ) ELSE last_msg_time END
+                WHERE conversation_id = OLD.conversation_id AND day = %2;
+
+                DELETE FROM message_day_summary
+                WHERE conversation_id = OLD.conversation_id AND day = %2 AND message_count <= 0;
+            END
+        )").arg(prefix, oldDay, rowDay)
+    };
+}
+
+/**
+ * @brief 获取回填按天消息汇总的SQL语句（汇总表为空而消息表非空时执行一次）
+ */
+QStringList DatabaseSchema::getBackfillDaySummary(const QString &schema)
+{
+    const QString prefix = schemaPrefix(schema);
+    const QString rowDay = dayKeyExpr("msg_time");
+
+    return {
+        QString(R"(
+            INSERT OR IGNORE INTO %1message_day_summary
+                (conversation_id, day, message_count, first_msg_time, last_msg_time)
+            SELECT conversation_id, %2 AS d, COUNT(*), MIN(msg_time), MAX(msg_time)
+            FROM %1messages
+            GROUP BY conversation_id, d
+        )").arg(prefix, rowDay),
+
+        QString(R"(
+            UPDATE %1message_day_summary
+            SET first_message_id = (
+                    SELECT message_id FROM %1messages m
+                    WHERE m.conversation_id = message_day_summary.conversation_id
+                      AND m.msg_time = message_day_summary.first_msg_time
+                    ORDER BY m.message_id ASC LIMIT 1),
+                last_message_id = (
+                    SELECT message_id FROM %1messages m
+                    WHERE m.conversation_id = message_day_summary.conversation_id
+                      AND m.msg_time = message_day_summary.last_msg_time
+                    ORDER BY m.message_id DESC LIMIT 1)
+            WHERE first_message_id IS NULL
+        )").arg(prefix)
+    };
+}
+
+/**
+ * @brief 获取维护会话统计的触发器
+ * 计数与字节数直接加减；首/尾时间只有删除的恰好是边界消息时才走索引重新取值
+ */
+QStringList DatabaseSchema::getCreateConversationStatsTriggers(const QString &schema)
+{
+    const QString prefix = schemaPrefix(schema);
+
+    return {
+        QString(R"(
+            CREATE TRIGGER IF NOT EXISTS %1trigger_conversation_stats_insert
+            AFTER INSERT ON messages
+            FOR EACH ROW
+            )" + QString(kImportGuard) + R"(
+            BEGIN
+                INSERT INTO conversation_stats
+                    (conversation_id, message_count, text_count, image_count, video_count,
+                     file_count, voice_count, media_bytes, first_msg_time, last_msg_time)
+                VALUES (NEW.conversation_id, 1,
+                        NEW.type = 0, NEW.type = 1, NEW.type = 2, NEW.type = 3, NEW.type = 4,
+                        CASE WHEN NEW.type <> 0 THEN COALESCE(NEW.file_size, 0) ELSE 0 END,
+                        NEW.msg_time, NEW.msg_time)
+                ON CONFLICT(conversation_id) DO UPDATE SET
+                    message_count = message_count + 1,
+                    text_count = text_count + excluded.text_count,
+                    image_count = image_count + excluded.image_count,
+                    video_count = video_count + excluded.video_count,
+                    file_count = file_count + excluded.file_count,
+                    voice_count = voice_count + excluded.voice_count,
+                    media_bytes = media_bytes + excluded.media_bytes,
+                    first_msg_time = MIN(COALESCE(first_msg_time, excluded.first_msg_time), excluded.first_msg_time),
+                    last_msg_time = MAX(COALESCE(last_msg_time, excluded.last_msg_time), excluded.last_msg_time);
+            END
+        )").arg(prefix),
+
+        QString(R"(
+            CREATE TRIGGER IF NOT EXISTS %1trigger_conversation_stats_delete
+            AFTER DELETE ON messages
+            FOR EACH ROW
+            )" + QString(kPurgeGuard) + R"(
+            BEGIN
+                UPDATE conversation_stats
+                SET message_count = message_count - 1,
+                    text_count = text_count - (OLD.type = 0),
+                    image_count = image_count - (OLD.type = 1),
+                    video_count = video_count - (OLD.type = 2),
+                    file_count = file_count - (OLD.type = 3),
+                    voice_count = voice_count - (OLD.type = 4),
+                    media_bytes = media_bytes - CASE WHEN OLD.type <> 0 THEN COALESCE(OLD.file_size, 0) ELSE 0 END,
+                    first_msg_time = CASE WHEN first_msg_time = OLD.msg_time
+                        THEN (SELECT MIN(msg_time) FROM messages WHERE conversation_id = OLD.conversation_id)
+                        ELSE first_msg_time END,
+                    last_msg_time = CASE WHEN last_msg_time = OLD.msg_time
+                        THEN (SELECT MAX(msg_time) FROM messages WHERE conversation_id = OLD.conversation_id)
+                        ELSE last_msg_time END
+                WHERE conversation_id = OLD.conversation_id;
+
+                DELETE FROM conversation_stats
+                WHERE conversation_id = OLD.conversation_id AND message_count <= 0;
+            END
+        )").arg(prefix),
+
+        // 类型或大小被修改时（同一会话内）调整对应计数
+        QString(R"(
+            CREATE TRIGGER IF NOT EXISTS %1trigger_conversation_stats_update
+            AFTER UPDATE OF type, file_size ON messages
+            FOR EACH ROW
+            WHEN OLD.conversation_id = NEW.conversation_id
+            BEGIN
+                UPDATE conversation_stats
+                SET text_count = text_count - (OLD.type = 0) + (NEW.type = 0),
+                    image_count = image_count - (OLD.type = 1) + (NEW.type = 1),
+                    video_count = video_count - (OLD.type = 2) + (NEW.type = 2),
+                    file_count = file_count - (OLD.type = 3) + (NEW.type = 3),
+                    voice_count = voice_count - (OLD.type = 4) + (NEW.type = 4),
+                    media_bytes = media_bytes
+                        - CASE WHEN OLD.type <> 0 THEN COALESCE(OLD.file_size, 0) ELSE 0 END
+                        + CASE WHEN NEW.type <> 0 THEN COALESCE(NEW.file_size, 0) ELSE 0 END
+                WHERE conversation_id = NEW.conversation_id;
+            END
+        )").arg(prefix)
+    };
+}
+
+/**
+ * @brief 获取回填会话统计的SQL语句（统计表为空而消息表非空时执行一次）
+ */
+QStringList DatabaseSchema::getBackfillConversationStats(const QString &schema)
+{
+    return {
+        QString(R"(
+            INSERT OR IGNORE INTO %1conversation_stats
+                (conversation_id, message_count, text_count, image_count, video_count,
+                 file_count, voice_count, media_bytes, first_msg_time, last_msg_time)
+            SELECT conversation_id, COUNT(*),
+                   SUM(type = 0), SUM(type = 1), SUM(type = 2), SUM(type = 3), SUM(type = 4),
+                   SUM(CASE WHEN type <> 0 THEN COALESCE(file_size, 0) ELSE 0 END),
+                   MIN(msg_time), MAX(msg_time)
+            FROM %1messages
+            GROUP BY conversation_id
+        )").arg(schemaPrefix(schema))
+    };
+}
+
+/**
+ * @brief 带批量清空保护条件（message_purges）的删除触发器
+ * 旧数据库中同名触发器没有保护条件，初始化/挂载时据此删除后重建
+ */
+QStringList DatabaseSchema::getPurgeGuardedTriggerNames()
+{
+    return {"trigger_day_summary_delete", "trigger_conversation_stats_delete"};
+}
+
+/**
+ * @brief 带批量导入保护条件（message_import_marks）的插入触发器
+ * 旧数据库中同名触发器没有保护条件或仍引用 message_purges，初始化/挂载时据此删除后重建
+ */
+QStringList DatabaseSchema::getImportGuardedTriggerNames()
+{
+    return {"trigger_day_summary_insert", "trigger_conversation_stats_insert"};
+}
+
+namespace {
+// 按当前消息重建满足 condition 的会话的按天汇总与会话统计
+QStringList rebuildDerived(const QString &schema, const QString &condition)
+{
+    const QString prefix = schemaPrefix(schema);
+    const QString rowDay = dayKeyExpr("msg_time");
+
+    return {
+        QString("DELETE FROM %1message_day_summary WHERE %2").arg(prefix, condition),
+        QString("DELETE FROM %1conversation_stats WHERE %2").arg(prefix, condition),
+
+        QString(R"(
+            INSERT INTO %1message_day_summary
+                (conversation_id, day, message_count, first_msg_time, last_msg_time)
+            SELECT conversation_id, %2 AS d, COUNT(*), MIN(msg_time), MAX(msg_time)
+            FROM %1messages
+            WHERE %3
+            GROUP BY conversation_id, d
+        )").arg(prefix, rowDay, condition),
+
+        QString(R"(
+            UPDATE %1message_day_summary
+            SET first_message_id = (
+                    SELECT message_id FROM %1messages m
+                    WHERE m.conversation_id = message_day_summary.conversation_id
+                      AND m.msg_time = message_day_summary.first_msg_time
+                    ORDER BY m.message_id ASC LIMIT 1),
+                last_message_id = (
+                    SELECT message_id FROM %1messages m
+                    WHERE m.conversation_id = message_day_summary.conversation_id
+                      AND m.msg_time = message_day_summary.last_msg_time
+                    ORDER BY m.message_id DESC LIMIT 1)
+            WHERE first_message_id IS NULL AND %2
+        )").arg(prefix, condition),
+
+        QString(R"(
+            INSERT INTO %1conversation_stats
+                (conversation_id, message_count, text_count, image_count, video_count,
+                 file_count, voice_count, media_bytes, first_msg_time, last_msg_time)
+            SELECT conversation_id, COUNT(*),
+                   SUM(type = 0), SUM(type = 1), SUM(type = 2), SUM(type = 3), SUM(type = 4),
+                   SUM(CASE WHEN type <> 0 THEN COALESCE(file_size, 0) ELSE 0 END),
+                   MIN(msg_time), MAX(msg_time)
+            FROM %1messages
+            WHERE %2
+            GROUP BY conversation_id
+        )").arg(prefix, condition)
+    };
+}
+}
+
+/**
+ * @brief 重建被标记会话（message_import_marks 中）的按天汇总与会话统计
+ * 批量导入结束时执行，替代导入期间被跳过的逐行触发器维护
+ */
+QStringList DatabaseSchema::getRebuildMarkedDerived(const QString &schema)
+{
+    return rebuildDerived(schema, QString("conversation_id IN (SELECT conversation_id FROM %1message_import_marks)")
+                                      .arg(schemaPrefix(schema)));
+}
+
+/**
+ * @brief 按剩余消息重建一个会话（conversationId 为 0 时为全部会话）的按天汇总与会话统计
+ * 批量清空结束时执行：清空期间删除触发器被跳过，其间新写入的消息也需要计入
+ */
+QStringList DatabaseSchema::getRebuildConversationDerived(const QString &schema, qint64 conversationId)
+{
+    return rebuildDerived(schema, conversationId > 0 ? QString("conversation_id = %1").arg(conversationId)
+                                                     : QStringLiteral("1"));
+}
+
+/**
+ * @brief 按当前消息重建会话ID在 (afterId, lastId] 内的会话的按天汇总与会话统计
+ * 结构迁移的后台回填按会话ID分块执行
+ */
+QStringList DatabaseSchema::getRebuildConversationRangeDerived(const QString &schema, qint64 afterId, qint64 lastId)
+{
+    return rebuildDerived(schema, QString("conversation_id > %1 AND conversation_id <= %2").arg(afterId).arg(lastId));
+}
+
+/**
+ * @brief 删除 messages 表二级索引的SQL语句（批量导入前执行，结束后按建索引语句重建）
+ */
+QStringList DatabaseSchema::getDropMessageIndexes(const QString &schema)
+{
+    QStringList sqls;
+    for (const char *name : kMessageIndexNames)
+        sqls << QString("DROP INDEX IF EXISTS %1%2").arg(schemaPrefix(schema), QLatin1String(name));
+    return sqls;
+}
+
 /**
  * @brief 获取创建数据库索引的SQL语句
  */
@@ -296,15 +800,27 @@ QString DatabaseSchema::getCreateIndexes() {
 
         -- 会话表索引
         CREATE INDEX IF NOT EXISTS idx_conversations_last_time ON conversations(last_message_time DESC);
-        CREATE INDEX IF NOT EXISTS idx_conversations_top_time ON conversations(is_top, last_message_time DESC);
+        -- 会话列表分页：(is_top, last_message_time, conversation_id) 降序，游标行值比较直接定位
+        DROP INDEX IF EXISTS idx_conversations_top_time;
+        CREATE INDEX IF NOT EXISTS idx_conversations_list ON conversations(is_top DESC, last_message_time DESC, conversation_id DESC);
         CREATE INDEX IF NOT EXISTS idx_conversations_group_user ON conversations(group_id, user_id);
         CREATE INDEX IF NOT EXISTS idx_conversations_type ON conversations(type);
 
         -- 消息表索引（关键性能索引）
-        CREATE INDEX IF NOT EXISTS idx_messages_conversation_time ON messages(conversation_id, msg_time DESC);
+        -- 会话消息分页：按 (conversation_id, msg_time, message_id) 聚簇的窄列索引，一页消息的索引项落在相邻的索引页上；
+        -- 正文、文件、URL、缩略图等宽列不进索引，按 rowid 回表读取。取代原 (conversation_id, msg_time) 索引
+        -- 与带 content 的 idx_messages_conversation_page
+        DROP INDEX IF EXISTS idx_messages_conversation_time;
+        DROP INDEX IF EXISTS idx_messages_conversation_page;
+        CREATE INDEX IF NOT EXISTS idx_messages_conversation_keys ON messages(conversation_id, msg_time, message_id, sender_id, consignee_id, type);
         CREATE INDEX IF NOT EXISTS idx_messages_sender_time ON messages(sender_id, msg_time DESC);
         CREATE INDEX IF NOT EXISTS idx_messages_time ON messages(msg_time DESC);
         CREATE INDEX IF NOT EXISTS idx_messages_type ON messages(type);
+        -- 媒体画廊：仅图片/视频的部分覆盖索引，按 (msg_time, message_id) 游标分页无需回表
+        CREATE INDEX IF NOT EXISTS idx_messages_media_gallery ON messages(conversation_id, msg_time, message_id, type, thumbnail_path, file_path, file_url) WHERE type IN (1, 2);
+
+        -- 未读 @ 提及：按用户取各会话的未读提及（WITHOUT ROWID 表的索引自带主键列，无需回表）
+        CREATE INDEX IF NOT EXISTS idx_mentions_unread ON message_mentions(user_id, conversation_id, msg_time) WHERE is_read = 0;
 
         -- 媒体缓存索引
         CREATE INDEX IF NOT EXISTS idx_media_url ON media_cache(original_url);
@@ -312,3 +828,34 @@ QString DatabaseSchema::getCreateIndexes() {
         CREATE INDEX IF NOT EXISTS idx_media_type ON media_cache(file_type);
     )";
 }
+
+QString DatabaseSchema::schemaFingerprint() {
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    for (const QString &sql : getCreateTables()) hash.addData(sql.toUtf8());
+    hash.addData(getCreateIndexes().toUtf8());
+    for (const QString &sql : getCreateTriggers()) hash.addData(sql.toUtf8());
+    return QString::fromLatin1(hash.result().toHex());
+}
+
+int DatabaseSchema::shardSchemaFingerprint() {
+    static const int fingerprint = [] {
+        // 分片语句中的挂载名不影响结构，用固定名计算
+        const QString schema = QStringLiteral("shard");
+        QStringList ddl{getCreateTableMessageShard(schema),
+                        getCreateTableMessageDaySummary(schema),
+                        getCreateTableConversationStats(schema),
+                        getCreateTableMessagePurges(schema),
+                        getCreateTableMessageImportMarks(schema)};
+        ddl << getCreateMessageShardIndexes(schema)
+            << getCreateDaySummaryTriggers(schema)
+            << getCreateConversationStatsTriggers(schema);
+
+        QCryptographicHash hash(QCryptographicHash::Sha1);
+        for (const QString &sql : std::as_const(ddl)) hash.addData(sql.toUtf8());
+        const QByteArray digest = hash.result();
+        const quint32 value = (quint32(quint8(digest[0])) << 24) | (quint32(quint8(digest[1])) << 16)
+                            | (quint32(quint8(digest[2])) << 8) | quint32(quint8(digest[3]));
+        return int(value & 0x7fffffff) | 1; // 非零正数，0 留给未记录/已失效
+    }();
+    return fingerprint;
+}
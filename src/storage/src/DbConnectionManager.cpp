@@ -1,9 +1,11 @@
 #include "DbConnectionManager.h"
 #include "DatabaseInitializer.h"
+#include "StorageTuner.h"
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QThread>
 #include <QDebug>
+#include <atomic>
 
 // 自动管理线程数据库连接
 QThreadStorage<QSharedPointer<QSqlDatabase>> DbConnectionManager::s_connections;
@@ -31,6 +33,11 @@ QSharedPointer<QSqlDatabase> DbConnectionManager::connectionForCurrentThread()
         DatabaseInitializer::applyPragmas(*db);
         s_connections.setLocalData(db);
 
+        // 首个工作连接负责验证调优档位（在数据库线程上执行，不阻塞界面；同一档位只测一次）
+        static std::atomic<bool> benchmarked{false};
+        if (!benchmarked.exchange(true))
+            StorageTuner::benchmarkIfNeeded(*db);
+
         qDebug() << "Created database connection for thread:" << connName;
     }
     return s_connections.localData();
@@ -0,0 +1,287 @@
+#include "DbConnectionPool.h"
+#include "DatabaseInitializer.h"
+#include <QSqlError>
+#include <QThread>
+#include <QDeadlineTimer>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <atomic>
+
+namespace {
+// 借用等待超过该时长时打印警告，提示连接池上限偏小或有任务长期占用连接
+constexpr qint64 kSlowCheckoutMs = 200;
+}
+
+// ---- Lease ----
+
+DbConnectionPool::Lease::Lease(DbConnectionPool *pool, QSharedPointer<QSqlDatabase> database)
+    : m_pool(pool)
+    , m_database(std::move(database))
+    , m_thread(QThread::currentThread())
+{
+}
+
+DbConnectionPool::Lease::~Lease()
+{
+    release();
+}
+
+DbConnectionPool::Lease::Lease(Lease &&other) noexcept
+    : m_pool(other.m_pool)
+    , m_database(std::move(other.m_database))
+    , m_thread(other.m_thread)
+{
+    other.m_pool = nullptr;
+    other.m_database.reset();
+}
+
+DbConnectionPool::Lease &DbConnectionPool::Lease::operator=(Lease &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_pool = other.m_pool;
+        m_database = std::move(other.m_database);
+        m_thread = other.m_thread;
+        other.m_pool = nullptr;
+        other.m_database.reset();
+    }
+    return *this;
+}
+
+void DbConnectionPool::Lease::release()
+{
+    Q_ASSERT_X(!m_database || m_thread == QThread::currentThread(), "DbConnectionPool::Lease",
+               "a pooled connection must be returned on the thread that borrowed it");
+    if (m_pool && m_database) m_pool->release(std::move(m_database));
+    m_database.reset();
+    m_pool = nullptr;
+}
+
+// ---- DbConnectionPool ----
+
+DbConnectionPool &DbConnectionPool::instance()
+{
+    // 有意不析构：静态析构时 QCoreApplication 已销毁，不能再操作 QSqlDatabase，连接由 shutdown() 关闭
+    static DbConnectionPool *pool = new DbConnectionPool;
+    return *pool;
+}
+
+DbConnectionPool::DbConnectionPool()
+{
+    // WAL 模式下读可以并发、写串行，连接数超过核数收益很小
+    m_maxSize = qBound(2, QThread::idealThreadCount(), 4);
+    m_metrics.maxSize = m_maxSize;
+}
+
+DbConnectionPool::Lease DbConnectionPool::acquire(int timeoutMs)
+{
+    QThread *const thread = QThread::currentThread();
+    QList<QSharedPointer<QSqlDatabase>> reaped;
+    QSharedPointer<QSqlDatabase> database;
+    bool create = false;
+    qint64 waitedMs = 0;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (m_shutdown) return Lease();
+        ++m_metrics.checkouts;
+        reapIdleLocked(QDateTime::currentMSecsSinceEpoch(), &reaped);
+
+        QElapsedTimer timer;
+        timer.start();
+        bool waited = false;
+        bool timedOut = false;
+        for (;;) {
+            if (m_shutdown) {
+                timedOut = true;
+                break;
+            }
+            // 只借出本线程创建的连接，取最近归还的，页缓存最热
+            int own = -1;
+            for (int i = m_idle.size() - 1; i >= 0 && own < 0; --i) {
+                if (m_idle.at(i).owner == thread) own = i;
+            }
+            if (own >= 0) {
+                database = m_idle.takeAt(own).database;
+                break;
+            }
+            if (m_size < m_maxSize) {
+                ++m_size; // 先占位，打开连接时不持锁
+                create = true;
+                break;
+            }
+            if (!m_idle.isEmpty()) {
+                // 上限已满且只有其他线程的空闲连接：退役最早归还的一个，名额让给本线程
+                m_retired.append(m_idle.takeFirst());
+                create = true;
+                break;
+            }
+
+            waited = true;
+            const qint64 remaining = timeoutMs - timer.elapsed();
+            if (remaining <= 0 || !m_available.wait(&m_mutex, QDeadlineTimer(remaining))) {
+                if (!m_idle.isEmpty() || m_size < m_maxSize) continue;
+                ++m_metrics.timeouts;
+                qWarning() << "Database connection pool exhausted, waited" << timer.elapsed() << "ms";
+                timedOut = true;
+                break;
+            }
+        }
+        if (waited) {
+            waitedMs = timer.elapsed();
+            ++m_metrics.waits;
+            m_metrics.totalWaitMs += waitedMs;
+            m_metrics.maxWaitMs = qMax(m_metrics.maxWaitMs, waitedMs);
+        }
+        if (create) watchThreadLocked(thread);
+        if (timedOut) waitedMs = 0;
+    }
+    for (auto &db : reaped) closeConnection(db);
+
+    if (waitedMs >= kSlowCheckoutMs)
+        qWarning() << "Slow database connection checkout:" << waitedMs << "ms";
+
+    if (create) {
+        database = openConnection();
+        QMutexLocker lock(&m_mutex);
+        if (!database) {
+            --m_size;
+            m_available.wakeOne();
+            return Lease();
+        }
+        ++m_metrics.created;
+    }
+    if (!database) return Lease();
+    return Lease(this, database);
+}
+
+void DbConnectionPool::shutdown(int timeoutMs)
+{
+    QList<Entry> entries;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_shutdown = true;
+        m_available.wakeAll();
+
+        // 等待借出的连接归还（归还时会唤醒）
+        QDeadlineTimer deadline(timeoutMs);
+        while (m_idle.size() < m_size) {
+            if (!m_available.wait(&m_mutex, deadline)) {
+                qWarning() << "Database connection pool shutdown with" << (m_size - m_idle.size())
+                           << "connections still leased";
+                break;
+            }
+        }
+        entries = m_idle + m_retired;
+        m_size -= m_idle.size();
+        m_idle.clear();
+        m_retired.clear();
+    }
+    for (Entry &entry : entries) closeConnection(entry.database);
+}
+
+DbConnectionPool::Metrics DbConnectionPool::metrics() const
+{
+    QMutexLocker lock(&m_mutex);
+    Metrics metrics = m_metrics;
+    metrics.size = m_size;
+    metrics.idle = m_idle.size();
+    return metrics;
+}
+
+void DbConnectionPool::release(QSharedPointer<QSqlDatabase> database)
+{
+    QList<QSharedPointer<QSqlDatabase>> reaped;
+    {
+        QMutexLocker lock(&m_mutex);
+        if (!database->isOpen() || m_shutdown) {
+            // 借用方关闭了连接或连接池已关闭，不再放回，在本线程（所属线程）上关闭
+            --m_size;
+            reaped.append(database);
+        } else {
+            const qint64 now = QDateTime::currentMSecsSinceEpoch();
+            m_idle.append({database, now, QThread::currentThread()});
+            reapIdleLocked(now, &reaped);
+        }
+        m_available.wakeAll();
+    }
+    database.reset();
+    for (auto &db : reaped) closeConnection(db);
+}
+
+QSharedPointer<QSqlDatabase> DbConnectionPool::openConnection()
+{
+    static std::atomic<int> s_counter{0};
+    const QString connName = QString("pool_%1").arg(s_counter.fetch_add(1));
+
+    auto db = QSharedPointer<QSqlDatabase>::create(QSqlDatabase::addDatabase("QSQLITE", connName));
+    db->setDatabaseName(DatabaseInitializer::databasePath());
+    if (!db->open()) {
+        qCritical() << "Failed to open pooled database connection" << connName << db->lastError().text();
+        closeConnection(db);
+        return nullptr;
+    }
+
+    DatabaseInitializer::applyPragmas(*db);
+    qDebug() << "Created pooled database connection:" << connName;
+    return db;
+}
+
+void DbConnectionPool::reapIdleLocked(qint64 nowMs, QList<QSharedPointer<QSqlDatabase>> *reaped)
+{
+    QThread *const thread = QThread::currentThread();
+    for (int i = m_retired.size() - 1; i >= 0; --i) {
+        if (m_retired.at(i).owner == thread) reaped->append(m_retired.takeAt(i).database);
+    }
+
+    // m_idle 按归还时间递增，最早归还的在前；只能关闭本线程的连接
+    for (int i = 0; i < m_idle.size() && m_idle.size() > kMinIdle;) {
+        const Entry &entry = m_idle.at(i);
+        if (nowMs - entry.idleSinceMs <= kIdleTimeoutMs) break;
+        if (entry.owner != thread) {
+            ++i;
+            continue;
+        }
+        reaped->append(m_idle.takeAt(i).database);
+        --m_size;
+        ++m_metrics.reaped;
+    }
+}
+
+void DbConnectionPool::watchThreadLocked(QThread *thread)
+{
+    if (m_watchedThreads.contains(thread)) return;
+    m_watchedThreads.insert(thread);
+    // finished 在线程自身上发出，直接连接保证连接在所属线程上关闭
+    QObject::connect(thread, &QThread::finished, thread, [this, thread]() {
+        closeThreadConnections(thread);
+    }, Qt::DirectConnection);
+}
+
+void DbConnectionPool::closeThreadConnections(QThread *thread)
+{
+    QList<QSharedPointer<QSqlDatabase>> closing;
+    {
+        QMutexLocker lock(&m_mutex);
+        m_watchedThreads.remove(thread);
+        for (int i = m_idle.size() - 1; i >= 0; --i) {
+            if (m_idle.at(i).owner != thread) continue;
+            closing.append(m_idle.takeAt(i).database);
+            --m_size;
+        }
+        for (int i = m_retired.size() - 1; i >= 0; --i) {
+            if (m_retired.at(i).owner == thread) closing.append(m_retired.takeAt(i).database);
+        }
+        m_available.wakeAll();
+    }
+    for (auto &db : closing) closeConnection(db);
+}
+
+void DbConnectionPool::closeConnection(QSharedPointer<QSqlDatabase> &database)
+{
+    if (!database) return;
+    const QString connName = database->connectionName();
+    database->close();
+    database.reset(); // removeDatabase 前释放所有 QSqlDatabase 副本
+    QSqlDatabase::removeDatabase(connName);
+}
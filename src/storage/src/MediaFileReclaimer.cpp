@@ -0,0 +1,65 @@
+#include "MediaFileReclaimer.h"
+#include <QStandardPaths>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QDebug>
+
+namespace {
+// 由 ImageProcessor / VideoProcessor / FileCopyProcessor / VoiceRecordDialog 写入的目录
+const char *const kReclaimableDirs[] = {
+    "images", "thumbnails", "videos", "video_thumbnails", "file", "VoiceMessages"
+};
+}
+
+MediaFileReclaimer::MediaFileReclaimer(QObject *parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(1);
+}
+
+MediaFileReclaimer::~MediaFileReclaimer()
+{
+    m_pool.waitForDone(5000);
+}
+
+bool MediaFileReclaimer::isReclaimable(const QString &path)
+{
+    if (path.isEmpty()) return false;
+
+    static const QString base = QDir(QStandardPaths::writableLocation(
+                                         QStandardPaths::AppLocalDataLocation)).absolutePath();
+    const QString cleaned = QDir::cleanPath(QFileInfo(path).absoluteFilePath());
+    for (const char *dir : kReclaimableDirs) {
+        if (cleaned.startsWith(base + '/' + QLatin1String(dir) + '/'))
+            return true;
+    }
+    return false;
+}
+
+void MediaFileReclaimer::enqueue(const QStringList &paths)
+{
+    QSet<QString> seen;
+    QStringList batch;
+    for (const QString &path : paths) {
+        if (!isReclaimable(path) || seen.contains(path)) continue;
+        seen.insert(path);
+        batch << path;
+    }
+    if (batch.isEmpty()) return;
+
+    m_pool.start([this, batch]() {
+        int count = 0;
+        qint64 bytes = 0;
+        for (const QString &path : batch) {
+            const qint64 size = QFileInfo(path).size();
+            if (QFile::remove(path)) {
+                ++count;
+                bytes += size;
+            }
+        }
+        qDebug() << "Reclaimed" << count << "media files," << bytes << "bytes";
+        emit reclaimed(count, bytes);
+    });
+}
@@ -0,0 +1,148 @@
+#include "MentionIndexer.h"
+#include "DatabaseSchema.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QRegularExpression>
+
+namespace {
+// 与“@所有人”等价的写法
+const QStringList kMentionAllNames = {QStringLiteral("所有人"), QStringLiteral("all")};
+}
+
+MentionIndexer::MentionIndexer(QSharedPointer<QSqlDatabase> database)
+    : m_database(std::move(database))
+{
+}
+
+QStringList MentionIndexer::extractNames(const QString &content)
+{
+    QStringList names;
+    if (!content.contains(QLatin1Char('@'))) return names;
+
+    // 插入提及时名称后通常跟一个空格（含 U+2005），\s 在 Unicode 模式下均能匹配
+    static const QRegularExpression re(QStringLiteral("@([^\\s@]+)"));
+    QRegularExpressionMatchIterator it = re.globalMatch(content);
+    while (it.hasNext()) {
+        const QString name = it.next().captured(1);
+        if (!names.contains(name)) names << name;
+    }
+    return names;
+}
+
+qint64 MentionIndexer::groupOf(qint64 conversationId)
+{
+    auto it = m_groupOfConversation.constFind(conversationId);
+    if (it != m_groupOfConversation.constEnd()) return it.value();
+
+    qint64 groupId = 0;
+    QSqlQuery query(*m_database);
+    query.prepare("SELECT group_id FROM conversations WHERE conversation_id = ? AND type = 1");
+    query.addBindValue(conversationId);
+    if (query.exec() && query.next()) groupId = query.value(0).toLongLong();
+
+    m_groupOfConversation.insert(conversationId, groupId);
+    return groupId;
+}
+
+qint64 MentionIndexer::currentUserId()
+{
+    if (m_currentUserId > 0) return m_currentUserId;
+
+    QSqlQuery query(*m_database);
+    if (query.exec("SELECT user_id FROM users WHERE is_current = 1 LIMIT 1") && query.next())
+        m_currentUserId = query.value(0).toLongLong();
+    return m_currentUserId;
+}
+
+bool MentionIndexer::index(const Message &message, bool markRead, QString *error)
+{
+    if (!message.isText()) return true;
+    const QStringList names = extractNames(message.content);
+    if (names.isEmpty()) return true;
+
+    const qint64 groupId = groupOf(message.conversationId);
+    if (groupId <= 0) return true;
+
+    // 未读提及只按当前用户读取，其他成员的行永远不会被标为已读，不写入
+    const qint64 userId = currentUserId();
+    if (userId <= 0 || userId == message.senderId) return true;
+
+    const QString insert = QString("INSERT OR IGNORE INTO %1 (conversation_id, message_id, user_id, msg_time, is_read) "
+                                   "SELECT ?, ?, gm.user_id, ?, ? FROM group_members gm ")
+                               .arg(DatabaseSchema::TABLE_MESSAGE_MENTIONS);
+
+    QSqlQuery query(*m_database);
+    for (const QString &name : names) {
+        const bool all = kMentionAllNames.contains(name, Qt::CaseInsensitive);
+        query.prepare(insert + (all
+            ? QString("WHERE gm.group_id = ? AND gm.user_id = ?")
+            : QString("JOIN users u ON u.user_id = gm.user_id "
+                      "WHERE gm.group_id = ? AND gm.user_id = ? AND (gm.nickname = ? OR u.nickname = ?)")));
+        query.addBindValue(message.conversationId);
+        query.addBindValue(message.messageId);
+        query.addBindValue(message.timestamp);
+        query.addBindValue(markRead ? 1 : 0);
+        query.addBindValue(groupId);
+        query.addBindValue(userId);
+        if (!all) {
+            query.addBindValue(name);
+            query.addBindValue(name);
+        }
+        if (!query.exec()) {
+            if (error) *error = query.lastError().text();
+            return false;
+        }
+        // 当前用户已被提及，其余名称不必再匹配
+        if (query.numRowsAffected() > 0) break;
+    }
+    return true;
+}
+
+bool MentionIndexer::removeMessage(qint64 conversationId, qint64 messageId, QString *error)
+{
+    QSqlQuery query(*m_database);
+    query.prepare(QString("DELETE FROM %1 WHERE conversation_id = ? AND message_id = ?")
+                      .arg(DatabaseSchema::TABLE_MESSAGE_MENTIONS));
+    query.addBindValue(conversationId);
+    query.addBindValue(messageId);
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool MentionIndexer::removeConversation(qint64 conversationId, qint64 maxMessageId, QString *error)
+{
+    QSqlQuery query(*m_database);
+    if (conversationId > 0) {
+        query.prepare(QString("DELETE FROM %1 WHERE conversation_id = ? AND message_id <= ?")
+                          .arg(DatabaseSchema::TABLE_MESSAGE_MENTIONS));
+        query.addBindValue(conversationId);
+    } else {
+        query.prepare(QString("DELETE FROM %1 WHERE message_id <= ?").arg(DatabaseSchema::TABLE_MESSAGE_MENTIONS));
+    }
+    query.addBindValue(maxMessageId);
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+bool MentionIndexer::removeOrphansBetween(qint64 startTime, qint64 endTime, QString *error)
+{
+    // 该时间范围对应的分片已整体删除，范围内剩余的消息只可能在主库表中；其他分片的提及不受影响
+    QSqlQuery query(*m_database);
+    query.prepare(QString("DELETE FROM %1 WHERE msg_time >= ? AND msg_time < ? AND NOT EXISTS ("
+                          "SELECT 1 FROM messages m WHERE m.message_id = %1.message_id "
+                          "AND m.conversation_id = %1.conversation_id)")
+                      .arg(DatabaseSchema::TABLE_MESSAGE_MENTIONS));
+    query.addBindValue(startTime);
+    query.addBindValue(endTime);
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,425 @@
+#include "MessageImporter.h"
+#include "MessageShardRouter.h"
+#include "ConversationSummarizer.h"
+#include "MentionIndexer.h"
+#include "DatabaseInitializer.h"
+#include "DatabaseSchema.h"
+#include "models/Message.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QDateTime>
+#include <QDebug>
+
+namespace {
+constexpr int kImportBatchRows = 20000;                          // 每个事务写入的行数
+constexpr int kMaxPeriodsPerBatch = 4;                           // 每批涉及的分片数上限（ATTACH 不能在事务内执行）
+constexpr qint64 kIndexRebuildThresholdBytes = 32 * 1024 * 1024; // 剩余内容超过该大小时删除索引后重建
+
+// 检查点中主库表记为 main
+QString encodePeriod(const QString &period)
+{
+    return period.isEmpty() ? QStringLiteral("main") : period;
+}
+
+QString decodePeriod(const QString &text)
+{
+    return text == QLatin1String("main") ? QString() : text;
+}
+
+QString joinIds(const QSet<qint64> &ids)
+{
+    QStringList list;
+    list.reserve(ids.size());
+    for (qint64 id : ids) list << QString::number(id);
+    return list.join(',');
+}
+
+QString joinPeriods(const QSet<QString> &periods)
+{
+    QStringList list;
+    for (const QString &period : periods) list << encodePeriod(period);
+    return list.join(',');
+}
+}
+
+MessageImporter::MessageImporter(QSharedPointer<QSqlDatabase> database, MessageShardRouter *router,
+                                 ConversationSummarizer *summarizer, MentionIndexer *mentions, QObject *parent)
+    : QObject(parent)
+    , m_database(std::move(database))
+    , m_router(router)
+    , m_summarizer(summarizer)
+    , m_mentions(mentions)
+{
+}
+
+MessageImporter::~MessageImporter() = default;
+
+void MessageImporter::start(int reqId, const QString &archivePath)
+{
+    Job job;
+    job.reqId = reqId;
+    job.path = QFileInfo(archivePath).absoluteFilePath();
+    m_jobs.append(job);
+
+    if (m_jobs.size() == 1)
+        QMetaObject::invokeMethod(this, &MessageImporter::runStep, Qt::QueuedConnection);
+}
+
+void MessageImporter::cancel(int reqId)
+{
+    for (Job &job : m_jobs) {
+        if (job.reqId == reqId) job.cancelled = true;
+    }
+}
+
+QStringList MessageImporter::pendingArchives() const
+{
+    QStringList paths;
+    QSqlQuery query(*m_database);
+    if (query.exec(QString("SELECT archive_path FROM %1 ORDER BY started_at")
+                       .arg(DatabaseSchema::TABLE_MESSAGE_IMPORTS))) {
+        while (query.next()) paths << query.value(0).toString();
+    }
+    return paths;
+}
+
+void MessageImporter::recoverInterrupted()
+{
+    QSqlQuery query(*m_database);
+    if (!query.exec(QString("SELECT conversations, periods FROM %1").arg(DatabaseSchema::TABLE_MESSAGE_IMPORTS)))
+        return;
+
+    QSet<qint64> conversations;
+    QSet<QString> periods;
+    while (query.next()) {
+        const QStringList ids = query.value(0).toString().split(',', Qt::SkipEmptyParts);
+        for (const QString &id : ids) conversations.insert(id.toLongLong());
+        const QStringList names = query.value(1).toString().split(',', Qt::SkipEmptyParts);
+        for (const QString &name : names) periods.insert(decodePeriod(name));
+    }
+    if (conversations.isEmpty()) return;
+
+    qDebug() << "Recovering interrupted import of" << conversations.size() << "conversations";
+    cleanup(conversations, periods);
+}
+
+void MessageImporter::runStep()
+{
+    if (m_jobs.isEmpty()) return;
+    Job &job = m_jobs.first();
+
+    QString error;
+    bool ok = true;
+    bool done = false;
+    if (job.cancelled) {
+        ok = false;
+        error = "Import cancelled";
+    } else if (!job.file) {
+        ok = openJob(job, &error);
+    } else {
+        ok = importBatch(job, &done, &error);
+        if (ok && !done) emit importProgress(job.reqId, job.imported, job.offset, job.size);
+    }
+
+    if (ok && !done) {
+        // 本批完成，让出事件循环后继续
+        QMetaObject::invokeMethod(this, &MessageImporter::runStep, Qt::QueuedConnection);
+        return;
+    }
+
+    Job finished = m_jobs.takeFirst();
+    finishJob(finished, ok, error);
+
+    if (!m_jobs.isEmpty())
+        QMetaObject::invokeMethod(this, &MessageImporter::runStep, Qt::QueuedConnection);
+}
+
+bool MessageImporter::openJob(Job &job, QString *error)
+{
+    job.file = QSharedPointer<QFile>::create(job.path);
+    if (!job.file->open(QIODevice::ReadOnly)) {
+        *error = job.file->errorString();
+        return false;
+    }
+    job.size = job.file->size();
+
+    // 同一文件且大小未变：从检查点继续
+    QSqlQuery query(*m_database);
+    query.prepare(QString("SELECT archive_size, byte_offset, imported_count, skipped_count, conversations, periods "
+                          "FROM %1 WHERE archive_path = ?").arg(DatabaseSchema::TABLE_MESSAGE_IMPORTS));
+    query.addBindValue(job.path);
+    if (query.exec() && query.next() && query.value(0).toLongLong() == job.size) {
+        job.offset = query.value(1).toLongLong();
+        job.imported = query.value(2).toLongLong();
+        job.skipped = query.value(3).toLongLong();
+        const QStringList ids = query.value(4).toString().split(',', Qt::SkipEmptyParts);
+        for (const QString &id : ids) job.conversations.insert(id.toLongLong());
+        const QStringList names = query.value(5).toString().split(',', Qt::SkipEmptyParts);
+        for (const QString &name : names) job.periods.insert(decodePeriod(name));
+        qDebug() << "Resuming import of" << job.path << "at byte" << job.offset;
+    }
+    if (!job.file->seek(job.offset)) {
+        *error = job.file->errorString();
+        return false;
+    }
+    job.dropIndexes = job.size - job.offset >= kIndexRebuildThresholdBytes;
+
+    // 外键校验用：只导入引用已存在会话和用户的消息
+    m_knownConversations.clear();
+    m_knownUsers.clear();
+    if (query.exec("SELECT conversation_id FROM conversations")) {
+        while (query.next()) m_knownConversations.insert(query.value(0).toLongLong());
+    }
+    if (query.exec("SELECT user_id FROM users")) {
+        while (query.next()) m_knownUsers.insert(query.value(0).toLongLong());
+    }
+
+    emit importProgress(job.reqId, job.imported, job.offset, job.size);
+    return true;
+}
+
+bool MessageImporter::importBatch(Job &job, bool *done, QString *error)
+{
+    QFile &file = *job.file;
+
+    // 1. 先读取并解析一批，确定涉及的分片
+    QVector<Message> rows;
+    QHash<QString, QString> tables; // 周期 -> 表名
+    rows.reserve(kImportBatchRows);
+    while (rows.size() < kImportBatchRows && !file.atEnd()) {
+        const qint64 lineStart = file.pos();
+        const QByteArray line = file.readLine().trimmed();
+        if (line.isEmpty()) continue;
+
+        QJsonParseError parseError;
+        const QJsonDocument document = QJsonDocument::fromJson(line, &parseError);
+        if (parseError.error != QJsonParseError::NoError || !document.isObject()) {
+            ++job.skipped;
+            continue;
+        }
+        Message message = Message::fromJson(document.object());
+        if (!m_knownConversations.contains(message.conversationId)
+            || !m_knownUsers.contains(message.senderId)
+            || !m_knownUsers.contains(message.consigneeId)) {
+            ++job.skipped;
+            continue;
+        }
+
+        const QString period = MessageShardRouter::isEnabled()
+                                   ? MessageShardRouter::periodForTime(message.timestamp) : QString();
+        if (!tables.contains(period)) {
+            if (tables.size() >= kMaxPeriodsPerBatch) {
+                file.seek(lineStart); // 留给下一批
+                break;
+            }
+            // 挂载分片必须在事务之外完成
+            const QString table = m_router->tableForWrite(message.timestamp, error);
+            if (table.isEmpty()) return false;
+            tables.insert(period, table);
+        }
+        rows.append(std::move(message));
+    }
+
+    // 2. 单个事务写入本批与检查点
+    if (!m_database->transaction()) {
+        *error = m_database->lastError().text();
+        return false;
+    }
+
+    auto fail = [&](const QString &reason) {
+        *error = reason;
+        m_database->rollback();
+        return false;
+    };
+
+    QSqlQuery query(*m_database);
+    for (auto it = tables.cbegin(); it != tables.cend(); ++it) {
+        const QString &period = it.key();
+        if (job.prepared.contains(period)) continue;
+
+        const QString prefix = it.value().section('.', 0, -2);
+        if (job.dropIndexes) {
+            const QStringList drops = DatabaseSchema::getDropMessageIndexes(prefix);
+            for (const QString &sql : drops) {
+                if (!query.exec(sql)) return fail(query.lastError().text());
+            }
+            // 中途退出时索引缺失，作废结构指纹让下次启动/挂载重新建索引
+            DatabaseInitializer::invalidateSchemaFingerprint(*m_database, prefix);
+        }
+        job.prepared.insert(period);
+        job.periods.insert(period);
+    }
+
+    // 分片模式下整批ID一次从主库序列分配，否则为 0 由表自增分配
+    qint64 nextId = m_router->allocateMessageIds(rows.size(), error);
+    if (nextId < 0) return fail(*error);
+
+    QHash<QString, QSharedPointer<QSqlQuery>> inserts; // 表名 -> 预编译的插入语句
+    QSqlQuery marker(*m_database);
+    for (Message &message : rows) {
+        const QString period = MessageShardRouter::isEnabled()
+                                   ? MessageShardRouter::periodForTime(message.timestamp) : QString();
+        const QString table = tables.value(period);
+
+        // 首次写入某分片中的会话时加标记，插入触发器据此跳过
+        const QString markKey = encodePeriod(period) + ':' + QString::number(message.conversationId);
+        if (!job.marked.contains(markKey)) {
+            marker.prepare(QString("INSERT OR IGNORE INTO %1 (conversation_id) VALUES (?)")
+                               .arg(m_router->tableForPeriod(period, DatabaseSchema::TABLE_MESSAGE_IMPORT_MARKS)));
+            marker.addBindValue(message.conversationId);
+            if (!marker.exec()) return fail(marker.lastError().text());
+            job.marked.insert(markKey);
+            job.conversations.insert(message.conversationId);
+        }
+
+        QSharedPointer<QSqlQuery> insert = inserts.value(table);
+        if (!insert) {
+            insert = QSharedPointer<QSqlQuery>::create(*m_database);
+            insert->prepare(QString("INSERT INTO %1 ("
+                                    "message_id, conversation_id, sender_id, consignee_id, type, content, "
+                                    "file_path, file_url, file_size, duration, thumbnail_path, msg_time"
+                                    ") VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)").arg(table));
+            inserts.insert(table, insert);
+        }
+
+        insert->addBindValue(nextId > 0 ? QVariant(nextId++) : QVariant());
+        insert->addBindValue(message.conversationId);
+        insert->addBindValue(message.senderId);
+        insert->addBindValue(message.consigneeId);
+        insert->addBindValue(static_cast<int>(message.type));
+        insert->addBindValue(message.content);
+        insert->addBindValue(message.filePath);
+        insert->addBindValue(message.fileUrl);
+        insert->addBindValue(message.fileSize);
+        insert->addBindValue(message.duration);
+        insert->addBindValue(message.thumbnailPath);
+        insert->addBindValue(message.timestamp);
+        if (!insert->exec()) return fail(insert->lastError().text());
+
+        message.messageId = insert->lastInsertId().toLongLong();
+        QString mentionError;
+        if (!m_mentions->index(message, true, &mentionError)) return fail(mentionError);
+    }
+
+    const qint64 imported = job.imported;
+    job.imported += rows.size();
+    job.offset = file.pos();
+    if (!saveCheckpoint(job, error)) {
+        job.imported = imported;
+        m_database->rollback();
+        return false;
+    }
+    if (!m_database->commit()) {
+        job.imported = imported;
+        return fail(m_database->lastError().text());
+    }
+
+    *done = file.atEnd();
+    return true;
+}
+
+bool MessageImporter::saveCheckpoint(const Job &job, QString *error)
+{
+    QSqlQuery query(*m_database);
+    query.prepare(QString("INSERT INTO %1 (archive_path, archive_size, byte_offset, imported_count, "
+                          "skipped_count, conversations, periods, started_at) "
+                          "VALUES (?, ?, ?, ?, ?, ?, ?, ?) "
+                          "ON CONFLICT(archive_path) DO UPDATE SET "
+                          "archive_size = excluded.archive_size, byte_offset = excluded.byte_offset, "
+                          "imported_count = excluded.imported_count, skipped_count = excluded.skipped_count, "
+                          "conversations = excluded.conversations, periods = excluded.periods")
+                      .arg(DatabaseSchema::TABLE_MESSAGE_IMPORTS));
+    query.addBindValue(job.path);
+    query.addBindValue(job.size);
+    query.addBindValue(job.offset);
+    query.addBindValue(job.imported);
+    query.addBindValue(job.skipped);
+    query.addBindValue(joinIds(job.conversations));
+    query.addBindValue(joinPeriods(job.periods));
+    query.addBindValue(QDateTime::currentSecsSinceEpoch());
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+void MessageImporter::cleanup(const QSet<qint64> &conversations, const QSet<QString> &periods)
+{
+    QSqlQuery query(*m_database);
+
+    for (const QString &period : periods) {
+        const QString marks = m_router->tableForPeriod(period, DatabaseSchema::TABLE_MESSAGE_IMPORT_MARKS);
+        if (marks.isEmpty()) continue;
+        const QString schema = period.isEmpty() ? QString() : marks.section('.', 0, 0);
+
+        // 重建索引（IF NOT EXISTS，未删除时几乎无开销）
+        const QStringList indexes = period.isEmpty()
+                                        ? DatabaseSchema::getCreateIndexes().split(';', Qt::SkipEmptyParts)
+                                        : DatabaseSchema::getCreateMessageShardIndexes(schema);
+        for (const QString &sql : indexes) {
+            const QString trimmedSql = sql.trimmed();
+            if (!trimmedSql.isEmpty() && !query.exec(trimmedSql))
+                qWarning() << "Rebuild index failed:" << query.lastError().text();
+        }
+
+        if (!m_database->transaction()) {
+            qWarning() << "Failed to start transaction for import cleanup:" << m_database->lastError().text();
+            continue;
+        }
+        bool ok = true;
+        const QStringList rebuild = DatabaseSchema::getRebuildMarkedDerived(schema);
+        for (const QString &sql : rebuild) {
+            if (!query.exec(sql)) {
+                qWarning() << "Rebuild derived tables failed:" << query.lastError().text();
+                ok = false;
+                break;
+            }
+        }
+        if (ok) {
+            query.prepare(QString("DELETE FROM %1 WHERE conversation_id = ?").arg(marks));
+            for (qint64 conversationId : conversations) {
+                query.addBindValue(conversationId);
+                if (!query.exec()) {
+                    qWarning() << "Clear import marker failed:" << query.lastError().text();
+                    ok = false;
+                    break;
+                }
+            }
+        }
+        if (!ok || !m_database->commit()) m_database->rollback();
+    }
+
+    // 会话摘要每个会话只重算一次
+    for (qint64 conversationId : conversations) m_summarizer->markStale(conversationId);
+    QString error;
+    if (!m_summarizer->flush(&error)) {
+        qWarning() << "Refresh conversation summary after import failed:" << error;
+        m_summarizer->discard();
+    }
+}
+
+void MessageImporter::finishJob(Job &job, bool ok, const QString &reason)
+{
+    if (job.file) job.file->close();
+    cleanup(job.conversations, job.periods);
+
+    // 成功后删除检查点；取消或失败时保留，下次导入同一文件从检查点继续
+    if (ok) {
+        QSqlQuery query(*m_database);
+        query.prepare(QString("DELETE FROM %1 WHERE archive_path = ?").arg(DatabaseSchema::TABLE_MESSAGE_IMPORTS));
+        query.addBindValue(job.path);
+        if (!query.exec()) qWarning() << "Remove import checkpoint failed:" << query.lastError().text();
+        emit importProgress(job.reqId, job.imported, job.size, job.size);
+    }
+
+    qDebug() << "Import of" << job.path << (ok ? "finished:" : "stopped:") << job.imported
+             << "imported," << job.skipped << "skipped" << reason;
+    emit importFinished(job.reqId, ok, reason, job.imported, job.skipped);
+}
@@ -0,0 +1,336 @@
+#include "MessageShardRouter.h"
+#include "DatabaseInitializer.h"
+#include "DatabaseSchema.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QDateTime>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <QRegularExpression>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+// SQLite 默认最多挂载 10 个数据库，预留余量给其他用途
+constexpr int kMaxAttachedShards = 8;
+}
+
+std::atomic<bool> MessageShardRouter::s_enabled{false};
+
+MessageShardRouter::MessageShardRouter(QSharedPointer<QSqlDatabase> database)
+    : m_database(std::move(database))
+    , m_periods(scanPeriods())
+{
+}
+
+MessageShardRouter::~MessageShardRouter()
+{
+    if (!m_database || !m_database->isOpen()) return;
+    const QStringList attached = m_attached;
+    for (const QString &period : attached) detach(period);
+}
+
+void MessageShardRouter::setEnabled(bool enabled)
+{
+    s_enabled.store(enabled);
+}
+
+bool MessageShardRouter::isEnabled()
+{
+    return s_enabled.load();
+}
+
+QString MessageShardRouter::shardDirectory()
+{
+    return QDir(QFileInfo(DatabaseInitializer::databasePath()).absolutePath()).absoluteFilePath("message_shards");
+}
+
+QString MessageShardRouter::periodForTime(qint64 msgTime)
+{
+    return QDateTime::fromSecsSinceEpoch(msgTime, Qt::UTC).toString("yyyyMM");
+}
+
+void MessageShardRouter::periodTimeRange(const QString &period, qint64 *startTime, qint64 *endTime)
+{
+    const QDate first = QDate::fromString(period, "yyyyMM");
+    if (startTime) *startTime = QDateTime(first, QTime(0, 0), Qt::UTC).toSecsSinceEpoch();
+    if (endTime) *endTime = QDateTime(first.addMonths(1), QTime(0, 0), Qt::UTC).toSecsSinceEpoch();
+}
+
+bool MessageShardRouter::isActive() const
+{
+    // 关闭开关后已有分片仍需参与查询，否则会“丢失”消息
+    return isEnabled() || !m_periods.isEmpty();
+}
+
+QString MessageShardRouter::schemaName(const QString &period)
+{
+    return QString("shard_%1").arg(period);
+}
+
+QString MessageShardRouter::shardFilePath(const QString &period)
+{
+    return QDir(shardDirectory()).absoluteFilePath(QString("messages_%1.db").arg(period));
+}
+
+QStringList MessageShardRouter::scanPeriods()
+{
+    static const QRegularExpression re("^messages_(\\d{6})\\.db$");
+    QStringList periods;
+    // 目录不存在时 entryList 返回空列表
+    const QStringList files = QDir(shardDirectory()).entryList({"messages_*.db"}, QDir::Files);
+    for (const QString &file : files) {
+        const QRegularExpressionMatch match = re.match(file);
+        if (match.hasMatch()) periods << match.captured(1);
+    }
+    std::sort(periods.begin(), periods.end());
+    return periods;
+}
+
+QString MessageShardRouter::tableForWrite(qint64 msgTime, QString *error)
+{
+    if (!isActive()) {
+        // 未分片期间主库表可能写入更新的消息，重新进入分片模式时重新取边界
+        m_boundaryReady = false;
+        return DatabaseSchema::TABLE_MESSAGES;
+    }
+    // 关闭开关后只要还有分片就继续写分片，否则新消息会落在最后读取的主库表中；
+    // 写入主库表时同样要从序列取ID，避免与已有分片中的ID重复
+    if (!ensureIdSequence(error) || !ensureMainBoundary(error)) return QString();
+
+    // 主库表已覆盖的月份（及更早）继续写主库表，保证主库表中的消息总比所有分片旧
+    const QString period = periodForTime(msgTime);
+    if (period <= m_mainBoundary) return DatabaseSchema::TABLE_MESSAGES;
+
+    const QString schema = attach(period, true, error);
+    return schema.isEmpty() ? QString() : schema + ".messages";
+}
+
+bool MessageShardRouter::ensureMainBoundary(QString *error)
+{
+    if (m_boundaryReady) return true;
+
+    QSqlQuery query(*m_database);
+    if (!query.exec(QString("SELECT MAX(msg_time) FROM main.%1").arg(DatabaseSchema::TABLE_MESSAGES)) || !query.next()) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    m_mainBoundary = query.value(0).isNull() ? QString() : periodForTime(query.value(0).toLongLong());
+    m_boundaryReady = true;
+    return true;
+}
+
+bool MessageShardRouter::ensureIdSequence(QString *error)
+{
+    if (m_sequenceReady) return true;
+
+    QSqlQuery query(*m_database);
+    query.prepare(QString("SELECT 1 FROM %1 WHERE key = 'message_seq'").arg(DatabaseSchema::TABLE_SCHEMA_META));
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    if (query.next()) {
+        m_sequenceReady = true;
+        return true;
+    }
+
+    // 首次进入分片模式：序列从主库表与全部已有分片中的最大ID开始
+    qint64 maxId = 0;
+    const QStringList periods = m_periods;
+    for (const QString &period : periods) {
+        const QString table = tableForPeriod(period);
+        if (table.isEmpty()) continue;
+        if (query.exec(QString("SELECT MAX(message_id) FROM %1").arg(table)) && query.next())
+            maxId = std::max(maxId, query.value(0).toLongLong());
+    }
+    if (query.exec(QString("SELECT MAX(message_id) FROM main.%1").arg(DatabaseSchema::TABLE_MESSAGES)) && query.next())
+        maxId = std::max(maxId, query.value(0).toLongLong());
+
+    query.prepare(QString("INSERT OR IGNORE INTO %1 (key, value) VALUES ('message_seq', ?)")
+                      .arg(DatabaseSchema::TABLE_SCHEMA_META));
+    query.addBindValue(QString::number(maxId));
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    m_sequenceReady = true;
+    return true;
+}
+
+qint64 MessageShardRouter::allocateMessageIds(int count, QString *error)
+{
+    if (!m_sequenceReady) return 0;
+
+    // 主库表也可能经由自增分配过ID（如开启分片之前写入的消息），取两者中较大者
+    QSqlQuery query(*m_database);
+    if (!query.exec(QString("SELECT MAX(COALESCE((SELECT CAST(value AS INTEGER) FROM %1 WHERE key = 'message_seq'), 0), "
+                            "COALESCE((SELECT MAX(message_id) FROM main.%2), 0))")
+                        .arg(DatabaseSchema::TABLE_SCHEMA_META, DatabaseSchema::TABLE_MESSAGES))
+        || !query.next()) {
+        if (error) *error = query.lastError().text();
+        return -1;
+    }
+    const qint64 first = query.value(0).toLongLong() + 1;
+
+    query.prepare(QString("UPDATE %1 SET value = ? WHERE key = 'message_seq'").arg(DatabaseSchema::TABLE_SCHEMA_META));
+    query.addBindValue(QString::number(first + count - 1));
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        return -1;
+    }
+    return first;
+}
+
+QStringList MessageShardRouter::periodsNewestFirst() const
+{
+    QStringList periods(m_periods.crbegin(), m_periods.crend());
+    periods << QString(); // 主库 messages 表
+    return periods;
+}
+
+QStringList MessageShardRouter::periodsInRange(qint64 startTime, qint64 endTime) const
+{
+    QStringList periods{QString()};
+    const QString first = periodForTime(startTime);
+    const QString last = periodForTime(endTime);
+    for (const QString &period : std::as_const(m_periods)) {
+        if (period >= first && period <= last) periods << period;
+    }
+    return periods;
+}
+
+QString MessageShardRouter::tableForPeriod(const QString &period, const QString &table)
+{
+    if (period.isEmpty()) return table;
+
+    const QString schema = attach(period, false, nullptr);
+    return schema.isEmpty() ? QString() : schema + "." + table;
+}
+
+QString MessageShardRouter::attach(const QString &period, bool create, QString *error)
+{
+    const QString schema = schemaName(period);
+    if (m_attached.contains(period)) {
+        touch(period);
+        return schema;
+    }
+
+    const QString path = shardFilePath(period);
+    const bool exists = m_periods.contains(period);
+    if (!exists) {
+        if (!create) {
+            if (error) *error = QString("Shard %1 does not exist").arg(period);
+            return QString();
+        }
+        // 只有新建分片时才需要确保目录存在
+        QDir().mkpath(shardDirectory());
+    }
+
+    while (m_attached.size() >= kMaxAttachedShards) {
+        detach(m_attached.first());
+    }
+
+    QSqlQuery query(*m_database);
+    query.prepare(QString("ATTACH DATABASE ? AS %1").arg(schema));
+    query.addBindValue(path);
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        qWarning() << "Attach shard failed:" << period << query.lastError().text();
+        return QString();
+    }
+
+    // 分片结构指纹与当前一致时跳过 DDL
+    const int fingerprint = DatabaseSchema::shardSchemaFingerprint();
+    if (query.exec(QString("PRAGMA %1.user_version").arg(schema)) && query.next()
+        && query.value(0).toInt() == fingerprint) {
+        m_attached.append(period);
+        return schema;
+    }
+
+    // 新建或旧版本分片：补齐表和索引（IF NOT EXISTS，已存在时几乎无开销）
+    QStringList ddl{QString("PRAGMA %1.journal_mode = WAL").arg(schema),
+                    DatabaseSchema::getCreateTableMessageShard(schema),
+                    DatabaseSchema::getCreateTableMessageDaySummary(schema),
+                    DatabaseSchema::getCreateTableConversationStats(schema),
+                    DatabaseSchema::getCreateTableMessagePurges(schema),
+                    DatabaseSchema::getCreateTableMessageImportMarks(schema)};
+    ddl << DatabaseSchema::getCreateMessageShardIndexes(schema);
+    QStringList triggers = DatabaseSchema::getCreateDaySummaryTriggers(schema);
+    triggers << DatabaseSchema::getCreateConversationStatsTriggers(schema);
+    for (const QString &sql : std::as_const(ddl)) {
+        if (!query.exec(sql)) {
+            if (error) *error = query.lastError().text();
+            qWarning() << "Create shard schema failed:" << query.lastError().text() << "SQL:" << sql;
+            QSqlQuery(QString("DETACH DATABASE %1").arg(schema), *m_database);
+            return QString();
+        }
+    }
+
+    DatabaseInitializer::dropUnguardedTriggers(*m_database, schema);
+    for (const QString &sql : std::as_const(triggers)) {
+        if (!query.exec(sql)) {
+            if (error) *error = query.lastError().text();
+            qWarning() << "Create shard trigger failed:" << query.lastError().text() << "SQL:" << sql;
+            QSqlQuery(QString("DETACH DATABASE %1").arg(schema), *m_database);
+            return QString();
+        }
+    }
+
+    if (DatabaseInitializer::backfillDerivedTables(*m_database, schema)
+        && !query.exec(QString("PRAGMA %1.user_version = %2").arg(schema).arg(fingerprint))) {
+        qWarning() << "Save shard schema fingerprint failed:" << period << query.lastError().text();
+    }
+
+    if (!exists) {
+        m_periods.insert(std::lower_bound(m_periods.begin(), m_periods.end(), period), period);
+    }
+    m_attached.append(period);
+    return schema;
+}
+
+void MessageShardRouter::detach(const QString &period)
+{
+    QSqlQuery query(*m_database);
+    if (!query.exec(QString("DETACH DATABASE %1").arg(schemaName(period)))) {
+        qWarning() << "Detach shard failed:" << period << query.lastError().text();
+    }
+    m_attached.removeAll(period);
+}
+
+void MessageShardRouter::touch(const QString &period)
+{
+    m_attached.removeAll(period);
+    m_attached.append(period);
+}
+
+bool MessageShardRouter::dropShard(const QString &period, QString *error)
+{
+    if (period.isEmpty()) {
+        if (error) *error = "The main messages table cannot be dropped as a shard";
+        return false;
+    }
+
+    if (m_attached.contains(period)) detach(period);
+
+    const QString path = shardFilePath(period);
+    if (QFileInfo::exists(path) && !QFile::remove(path)) {
+        if (error) *error = QString("Failed to remove shard file %1").arg(path);
+        return false;
+    }
+    QFile::remove(path + "-wal");
+    QFile::remove(path + "-shm");
+    m_periods.removeAll(period);
+    return true;
+}
+
+QStringList MessageShardRouter::dropShardsBefore(const QString &period)
+{
+    QStringList dropped;
+    const QStringList periods = m_periods;
+    for (const QString &p : periods) {
+        if (p < period && dropShard(p)) dropped << p;
+    }
+    return dropped;
+}
@@ -0,0 +1,274 @@
+#include "NativeSqlite.h"
+#include <QSqlDriver>
+#include <QDebug>
+
+#ifdef WECHAT_NATIVE_SQLITE
+#include <sqlite3.h>
+#include <dlfcn.h>
+
+namespace {
+// Qt 驱动插件解析到的 SQLite 与本模块链接的是否为同一个共享库。
+// 驱动自带 SQLite（Qt 默认构建）时两份库的全局状态与编译选项各自独立，跨库使用句柄是未定义行为；
+// 只有插件链接系统 SQLite（QT_FEATURE_system_sqlite）且与本模块加载的是同一个 .so 时才共用句柄
+bool driverSharesSqliteLibrary(const QSqlDriver *driver)
+{
+    Dl_info ours{};
+    if (!dladdr(reinterpret_cast<void *>(&sqlite3_libversion), &ours) || !ours.dli_fbase) return false;
+
+    // 驱动对象的元对象位于 QSQLITE 插件（或静态构建时的宿主模块）中
+    Dl_info plugin{};
+    if (!dladdr(static_cast<const void *>(driver->metaObject()), &plugin) || !plugin.dli_fname) return false;
+    void *handle = dlopen(plugin.dli_fname, RTLD_LAZY | RTLD_NOLOAD);
+    if (!handle) return false;
+    // 按插件的依赖顺序查找：自带 SQLite 时找到插件内的副本或找不到，链接系统库时找到该库
+    void *symbol = dlsym(handle, "sqlite3_libversion");
+    dlclose(handle);
+
+    Dl_info theirs{};
+    return symbol && dladdr(symbol, &theirs) && theirs.dli_fbase == ours.dli_fbase;
+}
+}
+#endif
+
+// ---- NativeStatement ----
+
+NativeStatement::NativeStatement(NativeStatementCache *cache, sqlite3_stmt *stmt, const QString &sql)
+    : m_cache(cache)
+    , m_stmt(stmt)
+    , m_sql(sql)
+{
+}
+
+NativeStatement::~NativeStatement()
+{
+    release();
+}
+
+NativeStatement::NativeStatement(NativeStatement &&other) noexcept
+    : m_cache(other.m_cache)
+    , m_stmt(other.m_stmt)
+    , m_sql(std::move(other.m_sql))
+    , m_error(std::move(other.m_error))
+{
+    other.m_cache = nullptr;
+    other.m_stmt = nullptr;
+}
+
+NativeStatement &NativeStatement::operator=(NativeStatement &&other) noexcept
+{
+    if (this != &other) {
+        release();
+        m_cache = other.m_cache;
+        m_stmt = other.m_stmt;
+        m_sql = std::move(other.m_sql);
+        m_error = std::move(other.m_error);
+        other.m_cache = nullptr;
+        other.m_stmt = nullptr;
+    }
+    return *this;
+}
+
+void NativeStatement::release()
+{
+    if (m_cache && m_stmt) m_cache->release(m_sql, m_stmt, !hasError());
+    m_cache = nullptr;
+    m_stmt = nullptr;
+}
+
+#ifdef WECHAT_NATIVE_SQLITE
+
+void NativeStatement::bindInt64(int index, qint64 value)
+{
+    sqlite3_bind_int64(m_stmt, index, value);
+}
+
+void NativeStatement::bindText(int index, const QString &value)
+{
+    if (value.isNull()) {
+        sqlite3_bind_null(m_stmt, index);
+        return;
+    }
+    // QString 本身是 UTF-16，直接绑定，由 SQLite 复制
+    sqlite3_bind_text16(m_stmt, index, value.utf16(), int(value.size() * sizeof(char16_t)), SQLITE_TRANSIENT);
+}
+
+void NativeStatement::bindNull(int index)
+{
+    sqlite3_bind_null(m_stmt, index);
+}
+
+bool NativeStatement::next()
+{
+    const int rc = sqlite3_step(m_stmt);
+    if (rc == SQLITE_ROW) return true;
+    if (rc != SQLITE_DONE) m_error = QString::fromUtf8(sqlite3_errmsg(sqlite3_db_handle(m_stmt)));
+    return false;
+}
+
+qint64 NativeStatement::int64At(int column) const
+{
+    return sqlite3_column_int64(m_stmt, column);
+}
+
+int NativeStatement::intAt(int column) const
+{
+    return sqlite3_column_int(m_stmt, column);
+}
+
+QString NativeStatement::textAt(int column) const
+{
+    const auto *text = reinterpret_cast<const char *>(sqlite3_column_text(m_stmt, column));
+    if (!text) return QString();
+    return QString::fromUtf8(text, sqlite3_column_bytes(m_stmt, column));
+}
+
+void NativeStatement::reset()
+{
+    sqlite3_reset(m_stmt);
+    sqlite3_clear_bindings(m_stmt);
+}
+
+bool NativeStatement::isNullAt(int column) const
+{
+    return sqlite3_column_type(m_stmt, column) == SQLITE_NULL;
+}
+
+QVariant NativeStatement::valueAt(int column) const
+{
+    switch (sqlite3_column_type(m_stmt, column)) {
+    case SQLITE_NULL: return QVariant();
+    case SQLITE_INTEGER: return int64At(column);
+    case SQLITE_FLOAT: return sqlite3_column_double(m_stmt, column);
+    default: return textAt(column);
+    }
+}
+
+#else // 未启用原生路径：NativeStatementCache 不可用，不会构造出有效语句
+
+void NativeStatement::bindInt64(int, qint64) {}
+void NativeStatement::bindText(int, const QString &) {}
+void NativeStatement::bindNull(int) {}
+bool NativeStatement::next() { return false; }
+void NativeStatement::reset() {}
+qint64 NativeStatement::int64At(int) const { return 0; }
+int NativeStatement::intAt(int) const { return 0; }
+QString NativeStatement::textAt(int) const { return QString(); }
+bool NativeStatement::isNullAt(int) const { return true; }
+QVariant NativeStatement::valueAt(int) const { return QVariant(); }
+
+#endif
+
+void NativeStatement::bind(int index, const QVariant &value)
+{
+    if (value.isNull()) {
+        bindNull(index);
+    } else if (value.typeId() == QMetaType::LongLong || value.typeId() == QMetaType::Int
+               || value.typeId() == QMetaType::Bool) {
+        bindInt64(index, value.toLongLong());
+    } else {
+        bindText(index, value.toString());
+    }
+}
+
+bool NativeStatement::exec()
+{
+    while (next()) {}
+    return !hasError();
+}
+
+// ---- NativeStatementCache ----
+
+NativeStatementCache::NativeStatementCache(QSharedPointer<QSqlDatabase> database)
+    : m_database(std::move(database))
+{
+#ifdef WECHAT_NATIVE_SQLITE
+    if (!m_database || !m_database->isOpen()) return;
+
+    const QVariant handle = m_database->driver()->handle();
+    if (!handle.isValid() || qstrcmp(handle.typeName(), "sqlite3*") != 0) return;
+
+    // Qt 驱动可能使用自带的 SQLite，与链接的库不是同一份时不能共用句柄（版本相同也不行）
+    if (!driverSharesSqliteLibrary(m_database->driver())) {
+        qInfo() << "Native SQLite fast path disabled: Qt SQL driver does not use the linked SQLite library";
+        return;
+    }
+
+    m_handle = *static_cast<sqlite3 *const *>(handle.constData());
+#endif
+}
+
+NativeStatementCache::~NativeStatementCache()
+{
+#ifdef WECHAT_NATIVE_SQLITE
+    for (sqlite3_stmt *stmt : std::as_const(m_idle)) sqlite3_finalize(stmt);
+#endif
+    m_idle.clear();
+}
+
+NativeStatement NativeStatementCache::prepare(const QString &sql, QString *error)
+{
+#ifdef WECHAT_NATIVE_SQLITE
+    if (!m_handle) {
+        if (error) *error = "Native SQLite is not available";
+        return NativeStatement();
+    }
+
+    sqlite3_stmt *stmt = m_idle.take(sql);
+    if (!stmt) {
+        const QByteArray utf8 = sql.toUtf8();
+        if (sqlite3_prepare_v3(m_handle, utf8.constData(), int(utf8.size()), SQLITE_PREPARE_PERSISTENT,
+                               &stmt, nullptr) != SQLITE_OK) {
+            if (error) *error = QString::fromUtf8(sqlite3_errmsg(m_handle));
+            sqlite3_finalize(stmt);
+            return NativeStatement();
+        }
+    }
+    return NativeStatement(this, stmt, sql);
+#else
+    Q_UNUSED(sql);
+    if (error) *error = "Native SQLite is not available";
+    return NativeStatement();
+#endif
+}
+
+qint64 NativeStatementCache::lastInsertId() const
+{
+#ifdef WECHAT_NATIVE_SQLITE
+    return m_handle ? sqlite3_last_insert_rowid(m_handle) : 0;
+#else
+    return 0;
+#endif
+}
+
+bool NativeStatementCache::takePageCacheStats(int *hits, int *misses)
+{
+#ifdef WECHAT_NATIVE_SQLITE
+    if (!m_handle) return false;
+    int highwater = 0;
+    sqlite3_db_status(m_handle, SQLITE_DBSTATUS_CACHE_HIT, hits, &highwater, 1);
+    sqlite3_db_status(m_handle, SQLITE_DBSTATUS_CACHE_MISS, misses, &highwater, 1);
+    return true;
+#else
+    Q_UNUSED(hits);
+    Q_UNUSED(misses);
+    return false;
+#endif
+}
+
+void NativeStatementCache::release(const QString &sql, sqlite3_stmt *stmt, bool reusable)
+{
+#ifdef WECHAT_NATIVE_SQLITE
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    // 出错的语句（如引用的分片已 DETACH）、同一 SQL 已有空闲语句或缓存已满时直接释放
+    if (!reusable || m_idle.contains(sql) || m_idle.size() >= kMaxCachedStatements) {
+        sqlite3_finalize(stmt);
+        return;
+    }
+    m_idle.insert(sql, stmt);
+#else
+    Q_UNUSED(sql);
+    Q_UNUSED(stmt);
+    Q_UNUSED(reusable);
+#endif
+}
@@ -0,0 +1,337 @@
+#include "SchemaMigrator.h"
+#include "DatabaseSchema.h"
+#include "MessageShardRouter.h"
+#include "MentionIndexer.h"
+#include "models/Message.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+struct Migration {
+    int version;
+    const char *name;
+    QStringList schemaSql; // 启动时同步执行的结构变更
+    bool backfill;         // 是否有后台回填
+};
+
+// 迁移按版本升序追加，已发布的条目不能修改
+const QList<Migration> &migrations()
+{
+    static const QList<Migration> list = {
+        {1, "index @ mentions of existing group messages", {}, true},
+        {2, "rebuild day summaries and conversation stats of existing messages", {}, true},
+        {3, "store 0 instead of NULL as the last message time of empty conversations",
+         {"UPDATE conversations SET last_message_time = 0 WHERE last_message_time IS NULL"}, false},
+        {4, "keep @ mentions of the current user only",
+         {"DELETE FROM message_mentions WHERE EXISTS (SELECT 1 FROM users WHERE is_current = 1) "
+          "AND user_id NOT IN (SELECT user_id FROM users WHERE is_current = 1)"}, false},
+    };
+    return list;
+}
+
+const QString kBackfillKeyPrefix = QStringLiteral("backfill:");
+
+// 提及回填每次扫描的消息ID区间
+constexpr qint64 kMentionScanWindow = 5000;
+// 派生表回填每次重建的会话数
+constexpr int kDerivedRebuildConversations = 32;
+}
+
+int SchemaMigrator::latestVersion()
+{
+    return migrations().isEmpty() ? 0 : migrations().constLast().version;
+}
+
+bool SchemaMigrator::applySchemaSteps(QSqlDatabase &db, int fromVersion, bool freshDatabase, QString *error)
+{
+    QSqlQuery query(db);
+    for (const Migration &migration : migrations()) {
+        if (migration.version <= fromVersion) continue;
+
+        for (const QString &sql : migration.schemaSql) {
+            if (!query.exec(sql)) {
+                if (error) *error = QString("Migration %1 failed: %2").arg(migration.version).arg(query.lastError().text());
+                return false;
+            }
+        }
+
+        if (migration.backfill && !freshDatabase) {
+            query.prepare(QString("INSERT OR REPLACE INTO %1 (key, value) VALUES (?, '')")
+                              .arg(DatabaseSchema::TABLE_SCHEMA_META));
+            query.addBindValue(kBackfillKeyPrefix + QString::number(migration.version));
+            if (!query.exec()) {
+                if (error) *error = query.lastError().text();
+                return false;
+            }
+        }
+        qDebug() << "Applied schema migration" << migration.version << migration.name;
+    }
+
+    if (!query.exec(QString("PRAGMA user_version = %1").arg(latestVersion()))) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
+
+SchemaMigrator::SchemaMigrator(QSharedPointer<QSqlDatabase> database, MessageShardRouter *router,
+                               MentionIndexer *mentions, QObject *parent)
+    : QObject(parent)
+    , m_database(std::move(database))
+    , m_router(router)
+    , m_mentions(mentions)
+    , m_timer(new QTimer(this))
+{
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &SchemaMigrator::runStep);
+}
+
+void SchemaMigrator::start(int delayMs)
+{
+    m_pending.clear();
+    m_cursors.clear();
+
+    QSqlQuery query(*m_database);
+    if (!query.exec(QString("SELECT key, value FROM %1 WHERE key LIKE '%2%'")
+                        .arg(DatabaseSchema::TABLE_SCHEMA_META, kBackfillKeyPrefix))) {
+        qWarning() << "Load pending backfills failed:" << query.lastError().text();
+        return;
+    }
+    while (query.next()) {
+        const int version = query.value(0).toString().mid(kBackfillKeyPrefix.size()).toInt();
+        if (version <= 0) continue;
+        m_pending.append(version);
+        m_cursors.insert(version, query.value(1).toString());
+    }
+    if (m_pending.isEmpty()) return;
+
+    std::sort(m_pending.begin(), m_pending.end());
+    qDebug() << "Pending schema backfills:" << m_pending;
+    m_timer->start(delayMs);
+}
+
+void SchemaMigrator::runStep()
+{
+    if (m_pending.isEmpty()) return;
+
+    const int version = m_pending.constFirst();
+    QString cursor = m_cursors.value(version);
+    bool done = false;
+    QString error;
+    if (!backfillStep(version, &cursor, &done, &error)) {
+        // 保留登记，下次启动从已提交的游标重试
+        qWarning() << "Schema backfill" << version << "failed:" << error;
+        m_pending.removeFirst();
+        m_cursors.remove(version);
+        emit backfillFinished(version, false);
+    } else if (done) {
+        qDebug() << "Schema backfill" << version << "finished";
+        m_pending.removeFirst();
+        m_cursors.remove(version);
+        emit backfillFinished(version, true);
+    } else {
+        m_cursors.insert(version, cursor);
+    }
+
+    if (!m_pending.isEmpty()) m_timer->start(kStepIntervalMs);
+}
+
+bool SchemaMigrator::backfillStep(int version, QString *cursor, bool *done, QString *error)
+{
+    switch (version) {
+    case 1:
+        return backfillMentions(cursor, done, error);
+    case 2:
+        return backfillDerived(cursor, done, error);
+    default:
+        // 未知版本（回退到旧代码后又升级等），直接移除登记
+        *done = true;
+        return saveCursor(version, QString(), true, error);
+    }
+}
+
+bool SchemaMigrator::backfillMentions(QString *cursor, bool *done, QString *error)
+{
+    // 游标为 "分片周期|已处理到的消息ID"，按 periodsNewestFirst 的顺序逐个分片处理
+    const QStringList periods = m_router->periodsNewestFirst();
+    int index = cursor->isEmpty() ? 0 : periods.indexOf(cursor->section('|', 0, 0));
+    qint64 lastId = cursor->section('|', 1, 1).toLongLong();
+    if (index < 0) {
+        // 分片已被删除，从头继续（写入为 INSERT OR IGNORE，重复处理无副作用）
+        index = 0;
+        lastId = 0;
+    }
+    const QString period = periods.value(index);
+
+    // ATTACH 不能在事务内执行，先路由
+    const QString table = m_router->tableForPeriod(period, DatabaseSchema::TABLE_MESSAGES);
+
+    if (!m_database->transaction()) {
+        if (error) *error = m_database->lastError().text();
+        return false;
+    }
+    auto fail = [&](const QString &reason) {
+        if (error) *error = reason;
+        m_database->rollback();
+        return false;
+    };
+
+    bool periodDone = true;
+    if (!table.isEmpty()) {
+        QSqlQuery query(*m_database);
+        if (!query.exec(QString("SELECT MAX(message_id) FROM %1").arg(table)))
+            return fail(query.lastError().text());
+        const qint64 maxId = query.next() ? query.value(0).toLongLong() : 0;
+
+        query.prepare(QString("SELECT m.message_id, m.conversation_id, m.sender_id, m.content, m.msg_time "
+                              "FROM %1 m JOIN %2 c ON c.conversation_id = m.conversation_id "
+                              "WHERE m.message_id > ? AND m.message_id <= ? AND m.type = ? AND c.type = 1 "
+                              "AND instr(m.content, '@') > 0")
+                          .arg(table, DatabaseSchema::TABLE_CONVERSATIONS));
+
+        QElapsedTimer timer;
+        timer.start();
+        while (lastId < maxId && timer.elapsed() < kStepBudgetMs) {
+            const qint64 windowEnd = qMin(lastId + kMentionScanWindow, maxId);
+            query.addBindValue(lastId);
+            query.addBindValue(windowEnd);
+            query.addBindValue(static_cast<int>(MessageType::TEXT));
+            if (!query.exec()) return fail(query.lastError().text());
+
+            while (query.next()) {
+                Message message;
+                message.messageId = query.value(0).toLongLong();
+                message.conversationId = query.value(1).toLongLong();
+                message.senderId = query.value(2).toLongLong();
+                message.type = MessageType::TEXT;
+                message.content = query.value(3).toString();
+                message.timestamp = query.value(4).toLongLong();
+
+                // 历史消息的提及不再提示
+                QString mentionError;
+                if (!m_mentions->index(message, true, &mentionError)) return fail(mentionError);
+            }
+            lastId = windowEnd;
+        }
+        periodDone = lastId >= maxId;
+    }
+
+    if (periodDone) {
+        if (index + 1 >= periods.size()) {
+            *done = true;
+        } else {
+            *cursor = periods.at(index + 1) + "|0";
+        }
+    } else {
+        *cursor = period + "|" + QString::number(lastId);
+    }
+
+    if (!saveCursor(1, *cursor, *done, error)) {
+        m_database->rollback();
+        return false;
+    }
+    if (!m_database->commit()) return fail(m_database->lastError().text());
+    return true;
+}
+
+bool SchemaMigrator::backfillDerived(QString *cursor, bool *done, QString *error)
+{
+    // 游标为 "分片周期|已处理到的会话ID"，每个分片的派生表只汇总本分片的消息
+    const QStringList periods = m_router->periodsNewestFirst();
+    int index = cursor->isEmpty() ? 0 : periods.indexOf(cursor->section('|', 0, 0));
+    qint64 lastId = cursor->section('|', 1, 1).toLongLong();
+    if (index < 0) {
+        // 分片已被删除，从头继续（按会话重建，重复处理无副作用）
+        index = 0;
+        lastId = 0;
+    }
+    const QString period = periods.value(index);
+
+    // ATTACH 不能在事务内执行，先路由
+    const QString table = m_router->tableForPeriod(period, DatabaseSchema::TABLE_MESSAGES);
+    const QString schema = period.isEmpty() ? QString() : table.section('.', 0, 0);
+
+    if (!m_database->transaction()) {
+        if (error) *error = m_database->lastError().text();
+        return false;
+    }
+    auto fail = [&](const QString &reason) {
+        if (error) *error = reason;
+        m_database->rollback();
+        return false;
+    };
+
+    bool periodDone = true;
+    if (!table.isEmpty()) {
+        QSqlQuery query(*m_database);
+        query.prepare(QString("SELECT DISTINCT conversation_id FROM %1 WHERE conversation_id > ? "
+                              "ORDER BY conversation_id LIMIT %2")
+                          .arg(table).arg(kDerivedRebuildConversations));
+
+        QElapsedTimer timer;
+        timer.start();
+        periodDone = false;
+        while (!periodDone && timer.elapsed() < kStepBudgetMs) {
+            query.addBindValue(lastId);
+            if (!query.exec()) return fail(query.lastError().text());
+            qint64 chunkEnd = lastId;
+            int count = 0;
+            while (query.next()) {
+                chunkEnd = query.value(0).toLongLong();
+                ++count;
+            }
+            if (count == 0) {
+                periodDone = true;
+                break;
+            }
+
+            // 整段删除后按消息重建，期间由触发器写入的部分数据一并被覆盖
+            QSqlQuery rebuild(*m_database);
+            for (const QString &sql : DatabaseSchema::getRebuildConversationRangeDerived(schema, lastId, chunkEnd)) {
+                if (!rebuild.exec(sql)) return fail(rebuild.lastError().text());
+            }
+            lastId = chunkEnd;
+            periodDone = count < kDerivedRebuildConversations;
+        }
+    }
+
+    if (periodDone) {
+        if (index + 1 >= periods.size()) {
+            *done = true;
+        } else {
+            *cursor = periods.at(index + 1) + "|0";
+        }
+    } else {
+        *cursor = period + "|" + QString::number(lastId);
+    }
+
+    if (!saveCursor(2, *cursor, *done, error)) {
+        m_database->rollback();
+        return false;
+    }
+    if (!m_database->commit()) return fail(m_database->lastError().text());
+    return true;
+}
+
+bool SchemaMigrator::saveCursor(int version, const QString &cursor, bool done, QString *error)
+{
+    QSqlQuery query(*m_database);
+    if (done) {
+        query.prepare(QString("DELETE FROM %1 WHERE key = ?").arg(DatabaseSchema::TABLE_SCHEMA_META));
+        query.addBindValue(kBackfillKeyPrefix + QString::number(version));
+    } else {
+        query.prepare(QString("INSERT OR REPLACE INTO %1 (key, value) VALUES (?, ?)")
+                          .arg(DatabaseSchema::TABLE_SCHEMA_META));
+        query.addBindValue(kBackfillKeyPrefix + QString::number(version));
+        query.addBindValue(cursor);
+    }
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,274 @@
+#include "StorageTuner.h"
+#include "DatabaseSchema.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QFileInfo>
+#include <QFile>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <algorithm>
+
+#if defined(Q_OS_WIN)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(Q_OS_MACOS)
+#include <sys/types.h>
+#include <sys/sysctl.h>
+#endif
+
+namespace {
+constexpr qint64 KiB = 1024;
+constexpr qint64 MiB = 1024 * KiB;
+constexpr qint64 GiB = 1024 * MiB;
+
+constexpr qint64 kTierBaseBytes = 16 * MiB;   // 第 0 档上限
+constexpr int kBenchmarkLookups = 200;        // 基准测试随机点查次数
+constexpr char kBenchmarkKey[] = "tuning_benchmark";
+}
+
+QMutex StorageTuner::s_mutex;
+StorageTuningProfile StorageTuner::s_current;
+QHash<QString, int> StorageTuner::s_appliedTiers;
+bool StorageTuner::s_mmapDisabledByBenchmark = false;
+
+QString StorageTuningProfile::toString() const
+{
+    return QString("tier=%1 db=%2MiB wal=%3MiB ram=%4MiB cache=%5KiB mmap=%6MiB "
+                   "wal_autocheckpoint=%7 soft_heap_limit=%8MiB")
+        .arg(tier)
+        .arg(dbBytes / MiB)
+        .arg(walBytes / MiB)
+        .arg(availableRamBytes / MiB)
+        .arg(cacheSizeKiB)
+        .arg(mmapSizeBytes / MiB)
+        .arg(walAutoCheckpoint)
+        .arg(softHeapLimitBytes / MiB);
+}
+
+StorageTuningProfile StorageTuner::chooseProfile(qint64 dbBytes, qint64 walBytes, qint64 availableRamBytes)
+{
+    StorageTuningProfile p;
+    p.dbBytes = dbBytes;
+    p.walBytes = walBytes;
+    p.availableRamBytes = availableRamBytes;
+
+    // 档位：16 MiB 以内为 0，此后每翻一倍加 1
+    int tier = 0;
+    for (qint64 bound = kTierBaseBytes; dbBytes > bound && tier < 16; bound *= 2) ++tier;
+    p.tier = tier;
+
+    // 页缓存
+    const qint64 cacheCap = std::max(8 * MiB, std::min(256 * MiB, availableRamBytes / 16));
+    const qint64 cacheBytes = std::clamp(dbBytes / 4, 8 * MiB, cacheCap);
+    p.cacheSizeKiB = cacheBytes / KiB;
+
+    // 内存映射（低内存主机或 32 位进程下关闭）
+    if (sizeof(void *) >= 8 && availableRamBytes >= 2 * GiB) {
+        const qint64 mmapCap = std::max(64 * MiB, std::min(1 * GiB, availableRamBytes / 8));
+        p.mmapSizeBytes = std::clamp(dbBytes * 2, 64 * MiB, mmapCap);
+    }
+
+    // WAL 检查点
+    if (walBytes > 64 * MiB) p.walAutoCheckpoint = 1000;
+    else if (dbBytes > 2 * GiB) p.walAutoCheckpoint = 8000;
+    else if (dbBytes > 256 * MiB) p.walAutoCheckpoint = 4000;
+    else p.walAutoCheckpoint = 1000;
+
+    // 进程级堆上限
+    p.softHeapLimitBytes = std::clamp(availableRamBytes / 8, 64 * MiB, 1 * GiB);
+
+    return p;
+}
+
+StorageTuningProfile StorageTuner::measure(const QString &dbPath)
+{
+    const qint64 dbBytes = QFileInfo(dbPath).size();
+    const qint64 walBytes = QFileInfo(dbPath + "-wal").size();
+    StorageTuningProfile p = chooseProfile(dbBytes, walBytes, availableMemoryBytes());
+
+    QMutexLocker lock(&s_mutex);
+    if (s_mmapDisabledByBenchmark) p.mmapSizeBytes = 0;
+    return p;
+}
+
+void StorageTuner::apply(QSqlDatabase &db, const StorageTuningProfile &profile)
+{
+    const QStringList pragmas = {
+        QString("PRAGMA cache_size = -%1").arg(profile.cacheSizeKiB),
+        QString("PRAGMA mmap_size = %1").arg(profile.mmapSizeBytes),
+        QString("PRAGMA wal_autocheckpoint = %1").arg(profile.walAutoCheckpoint),
+        QString("PRAGMA soft_heap_limit = %1").arg(profile.softHeapLimitBytes)
+    };
+    for (const QString &p : pragmas) {
+        QSqlQuery q(db);
+        if (!q.exec(p))
+            qWarning() << "Failed to set pragma" << p << q.lastError().text();
+    }
+
+    QMutexLocker lock(&s_mutex);
+    s_current = profile;
+    s_appliedTiers.insert(db.connectionName(), profile.tier);
+}
+
+bool StorageTuner::retuneIfNeeded(QSqlDatabase &db)
+{
+    if (!db.isOpen()) return false;
+
+    StorageTuningProfile profile = measure(db.databaseName());
+    {
+        QMutexLocker lock(&s_mutex);
+        if (s_appliedTiers.value(db.connectionName(), -1) == profile.tier) return false;
+    }
+
+    apply(db, profile);
+    qInfo() << "Storage profile retuned for" << db.connectionName() << ":" << profile.toString();
+    return true;
+}
+
+qint64 StorageTuner::benchmarkReads(QSqlDatabase &db)
+{
+    QSqlQuery range(db);
+    if (!range.exec("SELECT MIN(message_id), MAX(message_id) FROM messages") || !range.next())
+        return -1;
+    const qint64 minId = range.value(0).toLongLong();
+    const qint64 maxId = range.value(1).toLongLong();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    // 随机点查：覆盖主键 B 树的随机页访问
+    QSqlQuery lookup(db);
+    lookup.prepare("SELECT conversation_id, msg_time FROM messages WHERE message_id >= ? LIMIT 1");
+    for (int i = 0; i < kBenchmarkLookups && maxId > 0; ++i) {
+        lookup.addBindValue(minId + QRandomGenerator::global()->bounded(maxId - minId + 1));
+        if (lookup.exec()) lookup.next();
+    }
+
+    // 顺序扫描：模拟一页历史消息的索引范围读取
+    QSqlQuery scan(db);
+    scan.setForwardOnly(true);
+    if (scan.exec("SELECT message_id, content FROM messages ORDER BY msg_time DESC LIMIT 500")) {
+        while (scan.next()) {}
+    }
+
+    return timer.nsecsElapsed() / 1000;
+}
+
+bool StorageTuner::loadBenchmarkResult(QSqlDatabase &db, int *tier, bool *mmapDisabled)
+{
+    QSqlQuery q(db);
+    q.prepare(QString("SELECT value FROM %1 WHERE key = ?").arg(DatabaseSchema::TABLE_SCHEMA_META));
+    q.addBindValue(QString(kBenchmarkKey));
+    if (!q.exec() || !q.next()) return false;
+
+    const QStringList parts = q.value(0).toString().split(':');
+    bool tierOk = false;
+    if (parts.size() != 2) return false;
+    *tier = parts.at(0).toInt(&tierOk);
+    *mmapDisabled = parts.at(1) == "1";
+    return tierOk;
+}
+
+void StorageTuner::saveBenchmarkResult(QSqlDatabase &db, int tier, bool mmapDisabled)
+{
+    QSqlQuery q(db);
+    q.prepare(QString("INSERT OR REPLACE INTO %1 (key, value) VALUES (?, ?)").arg(DatabaseSchema::TABLE_SCHEMA_META));
+    q.addBindValue(QString(kBenchmarkKey));
+    q.addBindValue(QString("%1:%2").arg(tier).arg(mmapDisabled ? 1 : 0));
+    if (!q.exec()) qWarning() << "Save storage benchmark result failed:" << q.lastError().text();
+}
+
+void StorageTuner::benchmarkIfNeeded(QSqlDatabase &db)
+{
+    if (!db.isOpen()) return;
+
+    StorageTuningProfile profile = measure(db.databaseName());
+    const bool forced = qEnvironmentVariableIntValue("WECHAT_STORAGE_BENCHMARK") != 0;
+    int savedTier = -1;
+    bool savedMmapDisabled = false;
+    if (!forced && loadBenchmarkResult(db, &savedTier, &savedMmapDisabled) && savedTier == profile.tier) {
+        // 同一档位已测过：沿用结论，不再做随机读
+        if (savedMmapDisabled) {
+            QMutexLocker lock(&s_mutex);
+            s_mmapDisabledByBenchmark = true;
+            profile.mmapSizeBytes = 0;
+        }
+        apply(db, profile);
+        return;
+    }
+
+    {
+        QMutexLocker lock(&s_mutex);
+        s_mmapDisabledByBenchmark = false;
+    }
+    profile = measure(db.databaseName());
+    apply(db, profile);
+
+    benchmarkReads(db); // 预热，避免两轮对比受冷缓存影响
+    const qint64 tunedUs = benchmarkReads(db);
+    qint64 noMmapUs = -1;
+
+    // 数据库足够大且启用了 mmap 时，对比关闭 mmap 的耗时，mmap 明显更慢则关闭
+    if (tunedUs >= 0 && profile.mmapSizeBytes > 0 && profile.dbBytes > kTierBaseBytes) {
+        StorageTuningProfile noMmap = profile;
+        noMmap.mmapSizeBytes = 0;
+        apply(db, noMmap);
+        noMmapUs = benchmarkReads(db);
+
+        if (noMmapUs >= 0 && noMmapUs * 5 < tunedUs * 4) {
+            QMutexLocker lock(&s_mutex);
+            s_mmapDisabledByBenchmark = true;
+        } else {
+            apply(db, profile);
+        }
+    }
+
+    bool mmapDisabled = false;
+    QString report;
+    {
+        QMutexLocker lock(&s_mutex);
+        mmapDisabled = s_mmapDisabledByBenchmark;
+        report = QString("%1 | benchmark: tuned=%2us no_mmap=%3us%4")
+                     .arg(s_current.toString())
+                     .arg(tunedUs)
+                     .arg(noMmapUs)
+                     .arg(mmapDisabled ? " (mmap disabled)" : "");
+    }
+    if (tunedUs >= 0) saveBenchmarkResult(db, profile.tier, mmapDisabled);
+    qInfo() << "Storage tuning:" << report;
+}
+
+StorageTuningProfile StorageTuner::currentProfile()
+{
+    QMutexLocker lock(&s_mutex);
+    return s_current;
+}
+
+qint64 StorageTuner::availableMemoryBytes()
+{
+#if defined(Q_OS_WIN)
+    MEMORYSTATUSEX status;
+    status.dwLength = sizeof(status);
+    if (GlobalMemoryStatusEx(&status)) return static_cast<qint64>(status.ullAvailPhys);
+#elif defined(Q_OS_MACOS)
+    int64_t memSize = 0;
+    size_t len = sizeof(memSize);
+    // macOS 没有廉价的“可用内存”接口，取物理内存的一半作为估计
+    if (sysctlbyname("hw.memsize", &memSize, &len, nullptr, 0) == 0) return memSize / 2;
+#elif defined(Q_OS_LINUX)
+    QFile meminfo("/proc/meminfo");
+    if (meminfo.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        while (!meminfo.atEnd()) {
+            const QByteArray line = meminfo.readLine();
+            if (line.startsWith("MemAvailable:")) {
+                const QList<QByteArray> parts = line.simplified().split(' ');
+                if (parts.size() >= 2) return parts.at(1).toLongLong() * KiB;
+            }
+        }
+    }
+#endif
+    return 1 * GiB;
+}
@@ -43,7 +43,7 @@ void ContactTable::getCurrentUser(int reqId)
 }
 
 
-void ContactTable::saveContact(int reqId, Contact contact)
+void ContactTable::saveContact(int reqId, const Contact &contact)
 {
     if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
         emit contactSaved(reqId, false, "Database is not open");
@@ -77,7 +77,7 @@ void ContactTable::saveContact(int reqId, Contact contact)
     emit contactSaved(reqId, true, QString());
 }
 
-void ContactTable::updateContact(int reqId, Contact contact)
+void ContactTable::updateContact(int reqId, const Contact &contact)
 {
     if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
         emit contactUpdated(reqId, false, "Database not open");
@@ -173,7 +173,7 @@ void ContactTable::getAllContacts(int reqId)
             continue; // 跳过这个联系人，继续下一个
         }
         contact.user = User(q);
-        contacts.append(contact);
+        contacts.append(std::move(contact));
     }
     emit allContactsLoaded(reqId, contacts);
 }
@@ -253,7 +253,7 @@ void ContactTable::searchContacts(int reqId, const QString &keyword)
             continue; // 跳过这个联系人，继续下一个
         }
         contact.user = User(q);
-        contacts.append(contact);
+        contacts.append(std::move(contact));
     }
     emit searchContactsResult(reqId, contacts);
 }
@@ -325,7 +325,7 @@ void ContactTable::getStarredContacts(int reqId)
             continue; // 跳过这个联系人，继续下一个
         }
         contact.user = User(q);
-        contacts.append(contact);
+        contacts.append(std::move(contact));
     }
     emit starredContactsLoaded(reqId, contacts);
 }
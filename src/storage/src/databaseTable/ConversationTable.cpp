@@ -181,6 +181,65 @@ void ConversationTable::getAllConversations(int reqId)
     emit allConversationsLoaded(reqId, conversations);
 }
 
+void ConversationTable::getConversationsPage(int reqId, qint64 cursorConversationId, bool cursorIsTop,
+                                             qint64 cursorTime, int limit)
+{
+    QList<Conversation> conversations;
+    const bool firstPage = cursorConversationId <= 0;
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit dbError(reqId, "Database not open");
+        emit conversationsPageLoaded(reqId, firstPage, conversations, false);
+        return;
+    }
+
+    // 行值比较与 idx_conversations_list 的列顺序一致，游标之后的页直接从索引定位
+    QSqlQuery query(*m_database);
+    query.prepare(QString("SELECT * FROM conversations %1 "
+                          "ORDER BY is_top DESC, last_message_time DESC, conversation_id DESC LIMIT ?")
+                      .arg(firstPage ? QString()
+                                     : QString("WHERE (is_top, last_message_time, conversation_id) < (?, ?, ?)")));
+    if (!firstPage) {
+        query.addBindValue(cursorIsTop ? 1 : 0);
+        query.addBindValue(cursorTime);
+        query.addBindValue(cursorConversationId);
+    }
+    query.addBindValue(limit + 1); // 多取一行判断是否还有下一页
+    if (!query.exec()) {
+        emit dbError(reqId, query.lastError().text());
+        emit conversationsPageLoaded(reqId, firstPage, conversations, false);
+        return;
+    }
+
+    conversations.reserve(limit);
+    while (query.next()) conversations.append(Conversation(query));
+    const bool hasMore = conversations.size() > limit;
+    if (hasMore) conversations.removeLast();
+    emit conversationsPageLoaded(reqId, firstPage, conversations, hasMore);
+}
+
+void ConversationTable::locateConversation(int reqId, qint64 conversationId, qint64 userId)
+{
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit dbError(reqId, "Database not open");
+        emit conversationLocated(reqId, Conversation(), -1);
+        return;
+    }
+
+    QSqlQuery query(*m_database);
+    query.prepare("SELECT c.*, (SELECT COUNT(*) FROM conversations o "
+                  "WHERE (o.is_top, o.last_message_time, o.conversation_id) > (c.is_top, c.last_message_time, c.conversation_id)"
+                  ") AS row_index FROM conversations c "
+                  "WHERE c.conversation_id = ? OR (c.type = 0 AND c.user_id = ?) LIMIT 1");
+    query.addBindValue(conversationId);
+    query.addBindValue(userId);
+
+    if (!query.exec() || !query.next()) {
+        emit conversationLocated(reqId, Conversation(), -1);
+        return;
+    }
+    emit conversationLocated(reqId, Conversation(query), query.value("row_index").toInt());
+}
+
 void ConversationTable::getConversation(int reqId, qint64 conversationId)
 {
     if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
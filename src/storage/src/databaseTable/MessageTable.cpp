@@ -1,8 +1,113 @@
 #include "MessageTable.h"
 #include <QSqlQuery>
 #include <QSqlError>
+#include <QDateTime>
 #include "DbConnectionManager.h"
+#include "StorageTuner.h"
+#include "MessageShardRouter.h"
+#include "DatabaseSchema.h"
+#include "MediaFileReclaimer.h"
+#include "ConversationSummarizer.h"
+#include "MessageImporter.h"
+#include "MentionIndexer.h"
+#include "SchemaMigrator.h"
+#include "NativeSqlite.h"
+#include "StringPool.h"
 #include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace {
+constexpr int kRetuneIntervalMs = 10 * 60 * 1000; // 存储调优复查间隔
+constexpr int kPurgeChunkSize = 2000;              // 批量清空每个事务删除的行数
+
+// 联表查询的列：messages 的各列，加上发送者显示名（有联系人记录则用备注名，否则用用户昵称）与头像本地路径。
+// 会话分页索引 idx_messages_conversation_keys 只含定位与过滤用的窄列，一页的索引项落在相邻页上；
+// content 与媒体列在同一次按 rowid 回表时一并读出。列序固定，QtSql 与原生路径都按序号读取
+const QString kJoinedColumns = QStringLiteral(
+    "m.message_id, m.conversation_id, m.sender_id, m.consignee_id, m.type, m.content, m.msg_time, "
+    "CASE WHEN c.user_id IS NOT NULL THEN c.remark_name ELSE u.nickname END AS senderName, "
+    "u.avatar_local_path AS avatar, "
+    "m.file_path, m.file_url, m.file_size, m.duration, m.thumbnail_path");
+
+// 联表查询SQL：关联users（必选）和contacts（可选），一次性获取senderName和avatar
+QString joinedSelectSql(const QString &table)
+{
+    return QString(R"(
+        SELECT %2
+        FROM %1 m
+        -- 必联users表（sender_id必然存在于users中）
+        INNER JOIN users u ON m.sender_id = u.user_id
+        -- 左联contacts表（仅联系人有记录）
+        LEFT JOIN contacts c ON m.sender_id = c.user_id
+        WHERE m.conversation_id = ?
+        ORDER BY m.msg_time DESC
+        LIMIT ? OFFSET ?
+    )").arg(table, kJoinedColumns);
+}
+
+// 游标分页的联表查询：从 (msg_time, message_id) 游标沿一个方向读取，结果按读取方向排列
+QString joinedKeysetSql(const QString &table, bool older, bool inclusive)
+{
+    const QString cmp = older ? "<" : ">";
+    const QString order = older ? "DESC" : "ASC";
+    return QString(R"(
+        SELECT %5
+        FROM %1 m
+        INNER JOIN users u ON m.sender_id = u.user_id
+        LEFT JOIN contacts c ON m.sender_id = c.user_id
+        WHERE m.conversation_id = ?
+          AND m.msg_time %2= ? AND (m.msg_time %2 ? OR m.message_id %3 ?)
+        ORDER BY m.msg_time %4, m.message_id %4
+        LIMIT ?
+    )").arg(table, cmp, cmp + (inclusive ? "=" : ""), order, kJoinedColumns);
+}
+
+Message messageFromJoinedRow(const QSqlQuery &query)
+{
+    Message message;
+    // 按 kJoinedColumns 的列序读取，避免逐行按列名查找
+    message.messageId = query.value(0).toLongLong();
+    message.conversationId = query.value(1).toLongLong();
+    message.senderId = query.value(2).toLongLong();
+    message.consigneeId = query.value(3).toLongLong();
+    message.type = static_cast<MessageType>(query.value(4).toInt());
+    message.content = query.value(5).toString();
+    message.timestamp = query.value(6).toLongLong();
+
+    // 在联表结果中读取senderName和avatar（同一发送者的各行共用一份）
+    message.senderName = internString(query.value(7).toString());
+    message.avatar = internString(query.value(8).toString());
+
+    message.filePath = query.value(9).toString();
+    message.fileUrl = query.value(10).toString();
+    message.fileSize = query.value(11).toLongLong();
+    message.duration = query.value(12).toInt();
+    message.thumbnailPath = query.value(13).toString();
+    return message;
+}
+
+// 原生路径的行读取：整数列直接取值，只有文本列做 UTF-8 转换
+Message messageFromNativeRow(const NativeStatement &stmt)
+{
+    Message message;
+    message.messageId = stmt.int64At(0);
+    message.conversationId = stmt.int64At(1);
+    message.senderId = stmt.int64At(2);
+    message.consigneeId = stmt.int64At(3);
+    message.type = static_cast<MessageType>(stmt.intAt(4));
+    message.content = stmt.textAt(5);
+    message.timestamp = stmt.int64At(6);
+    message.senderName = internString(stmt.textAt(7));
+    message.avatar = internString(stmt.textAt(8));
+    message.filePath = stmt.textAt(9);
+    message.fileUrl = stmt.textAt(10);
+    message.fileSize = stmt.int64At(11);
+    message.duration = stmt.intAt(12);
+    message.thumbnailPath = stmt.textAt(13);
+    return message;
+}
+}
 
 MessageTable::MessageTable(QObject *parent)
     : QObject(parent)
@@ -22,6 +127,35 @@ void MessageTable::init()
         emit dbError(-1, QString("Open DB failed: %1").arg(errorText));
         return;
     }
+
+    m_native.reset(new NativeStatementCache(m_database));
+    m_router.reset(new MessageShardRouter(m_database));
+    m_summarizer.reset(new ConversationSummarizer(m_database, m_router.data()));
+    m_summarizer->setNativeCache(m_native.data());
+    m_mentions.reset(new MentionIndexer(m_database));
+
+    // 计时器在数据库线程创建，超时槽与查询同线程执行
+    m_retuneTimer = new QTimer(this);
+    m_retuneTimer->setInterval(kRetuneIntervalMs);
+    connect(m_retuneTimer, &QTimer::timeout, this, &MessageTable::onRetuneTimeout);
+    m_retuneTimer->start();
+
+    m_reclaimer = new MediaFileReclaimer(this);
+
+    m_importer = new MessageImporter(m_database, m_router.data(), m_summarizer.data(), m_mentions.data(), this);
+    connect(m_importer, &MessageImporter::importProgress, this, &MessageTable::importProgress);
+    connect(m_importer, &MessageImporter::importFinished, this, &MessageTable::importFinished);
+    m_importer->recoverInterrupted();
+
+    // 迁移登记的回填在界面启动后分块执行
+    m_migrator = new SchemaMigrator(m_database, m_router.data(), m_mentions.data(), this);
+    m_migrator->start();
+}
+
+void MessageTable::onRetuneTimeout()
+{
+    if (!m_database || !m_database->isOpen()) return;
+    StorageTuner::retuneIfNeeded(*m_database);
 }
 
 void MessageTable::saveMessage(int reqId, Message message)
@@ -36,64 +170,144 @@ void MessageTable::saveMessage(int reqId, Message message)
         return;
     }
 
-    QSqlQuery query(*m_database);
-    query.prepare("INSERT INTO messages ("
-                  "conversation_id, sender_id, consignee_id, type, content, "
-                  "file_path, file_url, file_size, duration, thumbnail_path, msg_time"
-                  ") VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)");
-
-    query.addBindValue(message.conversationId);
-    query.addBindValue(message.senderId);
-    query.addBindValue(message.consigneeId);
-    query.addBindValue(static_cast<int>(message.type));
-    query.addBindValue(message.content);
-    query.addBindValue(message.filePath);
-    query.addBindValue(message.fileUrl);
-    query.addBindValue(message.fileSize);
-    query.addBindValue(message.duration);
-    query.addBindValue(message.thumbnailPath);
-    query.addBindValue(message.timestamp);
+    QString routeError;
+    const QString table = m_router->tableForWrite(message.timestamp, &routeError);
+    if (table.isEmpty()) {
+        emit messageSaved(reqId, false, routeError);
+        return;
+    }
 
-    if (!query.exec()) {
-        emit messageSaved(reqId, false, query.lastError().text());
+    if (!m_database->transaction()) {
+        emit messageSaved(reqId, false, m_database->lastError().text());
+        return;
+    }
+
+    // 分片模式下ID取自主库序列，否则为 NULL 由表自增分配
+    QString error;
+    const qint64 messageId = m_router->allocateMessageIds(1, &error);
+    if (messageId < 0) {
+        m_database->rollback();
+        emit messageSaved(reqId, false, error);
         return;
     }
-    emit messageSaved(reqId, true, QString());
+
+    const QString insertSql = QString("INSERT INTO %1 ("
+                                      "message_id, conversation_id, sender_id, consignee_id, type, content, "
+                                      "file_path, file_url, file_size, duration, thumbnail_path, msg_time"
+                                      ") VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)").arg(table);
+
+    bool inserted = false;
+    if (m_native->isAvailable()) {
+        NativeStatement insert = m_native->prepare(insertSql, &error);
+        if (insert) {
+            if (messageId > 0) insert.bindInt64(1, messageId);
+            else insert.bindNull(1);
+            insert.bindInt64(2, message.conversationId);
+            insert.bindInt64(3, message.senderId);
+            insert.bindInt64(4, message.consigneeId);
+            insert.bindInt64(5, static_cast<int>(message.type));
+            insert.bindText(6, message.content);
+            insert.bindText(7, message.filePath);
+            insert.bindText(8, message.fileUrl);
+            insert.bindInt64(9, message.fileSize);
+            insert.bindInt64(10, message.duration);
+            insert.bindText(11, message.thumbnailPath);
+            insert.bindInt64(12, message.timestamp);
+            inserted = insert.exec();
+            if (inserted) message.messageId = m_native->lastInsertId();
+            else error = insert.errorString();
+        }
+    } else {
+        QSqlQuery query(*m_database);
+        query.prepare(insertSql);
+        query.addBindValue(messageId > 0 ? QVariant(messageId) : QVariant());
+        query.addBindValue(message.conversationId);
+        query.addBindValue(message.senderId);
+        query.addBindValue(message.consigneeId);
+        query.addBindValue(static_cast<int>(message.type));
+        query.addBindValue(message.content);
+        query.addBindValue(message.filePath);
+        query.addBindValue(message.fileUrl);
+        query.addBindValue(message.fileSize);
+        query.addBindValue(message.duration);
+        query.addBindValue(message.thumbnailPath);
+        query.addBindValue(message.timestamp);
+        inserted = query.exec();
+        if (inserted) message.messageId = query.lastInsertId().toLongLong();
+        else error = query.lastError().text();
+    }
+
+    if (inserted) {
+        // 会话摘要、@ 提及索引与消息在同一事务内提交
+        m_summarizer->recordInsert(message.conversationId, message.content, message.timestamp);
+        if (m_mentions->index(message, false, &error) && m_summarizer->flush(&error) && m_database->commit()) {
+            // 收到的消息不带发送者显示信息，补齐后界面可直接追加到窗口
+            if (message.senderName.isEmpty()) {
+                QSqlQuery sender(*m_database);
+                sender.prepare("SELECT CASE WHEN c.user_id IS NOT NULL THEN c.remark_name ELSE u.nickname END, "
+                               "u.avatar_local_path FROM users u LEFT JOIN contacts c ON c.user_id = u.user_id "
+                               "WHERE u.user_id = ?");
+                sender.addBindValue(message.senderId);
+                if (sender.exec() && sender.next()) {
+                    message.senderName = internString(sender.value(0).toString());
+                    message.avatar = internString(sender.value(1).toString());
+                }
+            }
+            emit messageInserted(reqId, message);
+            emit messageSaved(reqId, true, QString());
+            return;
+        }
+        if (error.isEmpty()) error = m_database->lastError().text();
+    }
+
+    m_database->rollback();
+    m_summarizer->discard();
+    emit messageSaved(reqId, false, error);
 }
 
-void MessageTable::updateMessage(int reqId, Message message)
+void MessageTable::updateMessage(int reqId, const Message &message)
 {
     if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
         emit messageUpdated(reqId, false, "Database is not open");
         return;
     }
 
-    QSqlQuery query(*m_database);
-    query.prepare("UPDATE messages SET "
-                  "conversation_id = ?, sender_id = ?, consignee_id = ?, type = ?, content = ?, "
-                  "file_path = ?, file_url = ?, file_size = ?, duration = ?, "
-                  "thumbnail_path = ?, msg_time = ? "
-                  "WHERE message_id = ?");
-
-    query.addBindValue(message.conversationId);
-    query.addBindValue(message.senderId);
-    query.addBindValue(message.consigneeId);
-    query.addBindValue(static_cast<int>(message.type));
-    query.addBindValue(message.content);
-    query.addBindValue(message.filePath);
-    query.addBindValue(message.fileUrl);
-    query.addBindValue(message.fileSize);
-    query.addBindValue(message.duration);
-    query.addBindValue(message.thumbnailPath);
-    query.addBindValue(message.timestamp);
-    query.addBindValue(message.messageId);
+    const QStringList periods = m_router->periodsNewestFirst();
+    for (const QString &period : periods) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
 
-    if (!query.exec()) {
-        emit messageUpdated(reqId, false, query.lastError().text());
-        return;
+        QSqlQuery query(*m_database);
+        query.prepare(QString("UPDATE %1 SET "
+                              "conversation_id = ?, sender_id = ?, consignee_id = ?, type = ?, content = ?, "
+                              "file_path = ?, file_url = ?, file_size = ?, duration = ?, "
+                              "thumbnail_path = ?, msg_time = ? "
+                              "WHERE message_id = ?").arg(table));
+
+        query.addBindValue(message.conversationId);
+        query.addBindValue(message.senderId);
+        query.addBindValue(message.consigneeId);
+        query.addBindValue(static_cast<int>(message.type));
+        query.addBindValue(message.content);
+        query.addBindValue(message.filePath);
+        query.addBindValue(message.fileUrl);
+        query.addBindValue(message.fileSize);
+        query.addBindValue(message.duration);
+        query.addBindValue(message.thumbnailPath);
+        query.addBindValue(message.timestamp);
+        query.addBindValue(message.messageId);
+
+        if (!query.exec()) {
+            emit messageUpdated(reqId, false, query.lastError().text());
+            return;
+        }
+        if (query.numRowsAffected() > 0) {
+            emit messageUpdated(reqId, true, QString());
+            return;
+        }
     }
 
-    emit messageUpdated(reqId, query.numRowsAffected() > 0, QString());
+    emit messageUpdated(reqId, false, QString());
 }
 
 void MessageTable::deleteMessage(int reqId, qint64 messageId)
@@ -103,19 +317,50 @@ void MessageTable::deleteMessage(int reqId, qint64 messageId)
         return;
     }
 
-    QSqlQuery query(*m_database);
-    query.prepare("DELETE FROM messages WHERE message_id = ?");
-    query.addBindValue(messageId);
+    // 消息ID不携带时间信息，逐个分片查找（未分片时只有主库一张表）
+    const QStringList periods = m_router->periodsNewestFirst();
+    for (const QString &period : periods) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
 
-    if (!query.exec()) {
-        emit messageDeleted(reqId, false, query.lastError().text());
+        QSqlQuery lookup(*m_database);
+        lookup.prepare(QString("SELECT conversation_id, msg_time FROM %1 WHERE message_id = ?").arg(table));
+        lookup.addBindValue(messageId);
+        if (!lookup.exec() || !lookup.next()) continue;
+        const qint64 conversationId = lookup.value(0).toLongLong();
+        const qint64 msgTime = lookup.value(1).toLongLong();
+
+        if (!m_database->transaction()) {
+            emit messageDeleted(reqId, false, m_database->lastError().text());
+            return;
+        }
+
+        QSqlQuery query(*m_database);
+        query.prepare(QString("DELETE FROM %1 WHERE message_id = ?").arg(table));
+        query.addBindValue(messageId);
+
+        QString error;
+        if (query.exec()) {
+            m_summarizer->recordDelete(conversationId, msgTime);
+            if (m_mentions->removeMessage(conversationId, messageId, &error)
+                && m_summarizer->flush(&error) && m_database->commit()) {
+                emit messageDeleted(reqId, true, QString());
+                return;
+            }
+            if (error.isEmpty()) error = m_database->lastError().text();
+        } else {
+            error = query.lastError().text();
+        }
+
+        m_database->rollback();
+        m_summarizer->discard();
+        emit messageDeleted(reqId, false, error);
         return;
     }
 
-    emit messageDeleted(reqId, query.numRowsAffected() > 0, QString());
+    emit messageDeleted(reqId, false, QString());
 }
 
-
 void MessageTable::getMessages(int reqId, qint64 conversationId, int limit, int offset)
 {
     QVector<Message> messages;
@@ -125,77 +370,148 @@ void MessageTable::getMessages(int reqId, qint64 conversationId, int limit, int
         return;
     }
 
-    QSqlQuery query(*m_database);
-    // 联表查询SQL：关联users（必选）和contacts（可选），一次性获取senderName和avatar
-    query.prepare(R"(
-        SELECT
-            m.*,
-            -- 若存在联系人记录则用备注名，否则用用户昵称
-            CASE WHEN c.user_id IS NOT NULL THEN c.remark_name ELSE u.nickname END AS senderName,
-            -- 头像直接取自users表的本地路径
-            u.avatar_local_path AS avatar
-        FROM messages m
-        -- 必联users表（sender_id必然存在于users中）
-        INNER JOIN users u ON m.sender_id = u.user_id
-        -- 左联contacts表（仅联系人有记录）
-        LEFT JOIN contacts c ON m.sender_id = c.user_id
-        WHERE m.conversation_id = ?
-        ORDER BY m.msg_time DESC
-        LIMIT ? OFFSET ?
-    )");
-    query.addBindValue(conversationId);
-    query.addBindValue(limit);
-    query.addBindValue(offset);
+    // 跨分片分页：从最新分片开始，整片跳过 offset，取满 limit 即停止
+    const QStringList periods = m_router->periodsNewestFirst();
+    const bool multiShard = periods.size() > 1;
+    int remaining = limit;
+    int skip = offset;
 
-    if (!query.exec()) {
-        emit dbError(reqId, query.lastError().text());
-        emit messagesLoaded(reqId, messages);
+    for (const QString &period : periods) {
+        if (remaining <= 0) break;
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
+
+        if (multiShard && skip > 0) {
+            QSqlQuery count(*m_database);
+            count.prepare(QString("SELECT COUNT(*) FROM %1 WHERE conversation_id = ?").arg(table));
+            count.addBindValue(conversationId);
+            if (count.exec() && count.next()) {
+                const int rows = count.value(0).toInt();
+                if (rows <= skip) {
+                    skip -= rows;
+                    continue;
+                }
+            }
+        }
+
+        // 各分片结果按时间倒序依次追加（越往后的分片越旧），最后整体翻转一次为升序
+        const int before = messages.size();
+        QString error;
+        if (!appendJoinedRows(joinedSelectSql(table), {conversationId, remaining, skip}, &messages, &error)) {
+            std::reverse(messages.begin(), messages.end());
+            emit dbError(reqId, error);
+            emit messagesLoaded(reqId, messages);
+            return;
+        }
+
+        remaining -= messages.size() - before;
+        skip = 0;
+    }
+    std::reverse(messages.begin(), messages.end());
+    emit messagesLoaded(reqId, messages);
+}
+
+void MessageTable::getMessagesAround(int reqId, qint64 conversationId, qint64 anchorMessageId,
+                                     int before, int after)
+{
+    QVector<Message> messages;
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit dbError(reqId, "Database is not open");
+        emit messagesAroundLoaded(reqId, anchorMessageId, messages, false, false);
         return;
     }
 
-    while (query.next()){
-        Message message;
-        // 读取messages表的字段
-        message.messageId = query.value("message_id").toLongLong();
-        message.conversationId = query.value("conversation_id").toLongLong();
-        message.senderId = query.value("sender_id").toLongLong();
-        message.consigneeId = query.value("consignee_id").toLongLong();
-        message.type = static_cast<MessageType>(query.value("type").toInt());
-        message.content = query.value("content").toString();
-        message.filePath = query.value("file_path").toString();
-        message.fileUrl = query.value("file_url").toString();
-        message.fileSize = query.value("file_size").toLongLong();
-        message.duration = query.value("duration").toInt();
-        message.thumbnailPath = query.value("thumbnail_path").toString();
-        message.timestamp = query.value("msg_time").toLongLong();
+    // 定位锚点时间；锚点不存在时按最新消息处理
+    qint64 anchorTime = std::numeric_limits<qint64>::max();
+    qint64 anchorId = std::numeric_limits<qint64>::max();
+    const QStringList periods = m_router->periodsNewestFirst();
+    for (const QString &period : periods) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
 
-        // 在联表结果中读取senderName和avatar
-        message.senderName = query.value("senderName").toString();
-        message.avatar = query.value("avatar").toString();
+        QSqlQuery query(*m_database);
+        query.prepare(QString("SELECT msg_time FROM %1 WHERE message_id = ? AND conversation_id = ?").arg(table));
+        query.addBindValue(anchorMessageId);
+        query.addBindValue(conversationId);
+        if (query.exec() && query.next()) {
+            anchorTime = query.value(0).toLongLong();
+            anchorId = anchorMessageId;
+            break;
+        }
+    }
 
-        messages.insert(0, message);
+    // 锚点及其后 after 条（多取一条判断是否还有更新的），锚点之前 before 条
+    QVector<Message> newer;
+    QVector<Message> older;
+    QString error;
+    if (!fetchMessagePage(conversationId, anchorTime, anchorId, false, true, after + 2, &newer, &error)
+        || !fetchMessagePage(conversationId, anchorTime, anchorId, true, false, before + 1, &older, &error)) {
+        emit dbError(reqId, error);
+        emit messagesAroundLoaded(reqId, anchorMessageId, messages, false, false);
+        return;
     }
-    emit messagesLoaded(reqId, messages);
+
+    const bool hasNewer = newer.size() > after + 1;
+    const bool hasOlder = older.size() > before;
+    if (hasNewer) newer.removeLast();
+    if (hasOlder) older.removeLast();
+
+    messages.reserve(older.size() + newer.size());
+    for (auto it = older.crbegin(); it != older.crend(); ++it) messages.append(*it);
+    messages.append(newer);
+
+    emit messagesAroundLoaded(reqId, anchorMessageId, messages, hasOlder, hasNewer);
 }
 
-void MessageTable::getMessage(int reqId, qint64 messageId)
+void MessageTable::getMessagesFrom(int reqId, qint64 conversationId, qint64 cursorTime,
+                                   qint64 cursorMessageId, bool older, int limit)
 {
+    QVector<Message> messages;
     if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
         emit dbError(reqId, "Database is not open");
-        emit messageLoaded(reqId, Message());
+        emit messagesPageLoaded(reqId, older, messages, false);
         return;
     }
 
-    QSqlQuery query(*m_database);
-    query.prepare("SELECT * FROM messages WHERE message_id = ?");
-    query.addBindValue(messageId);
+    QString error;
+    if (!fetchMessagePage(conversationId, cursorTime, cursorMessageId, older, false, limit + 1, &messages, &error)) {
+        emit dbError(reqId, error);
+        emit messagesPageLoaded(reqId, older, QVector<Message>(), false);
+        return;
+    }
+
+    const bool hasMore = messages.size() > limit;
+    if (hasMore) messages.removeLast();
+    // 结果统一按时间升序
+    if (older) std::reverse(messages.begin(), messages.end());
 
-    if (!query.exec() || !query.next()) {
+    emit messagesPageLoaded(reqId, older, messages, hasMore);
+}
+
+void MessageTable::getMessage(int reqId, qint64 messageId)
+{
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit dbError(reqId, "Database is not open");
         emit messageLoaded(reqId, Message());
         return;
     }
 
-    emit messageLoaded(reqId, Message(query));
+    const QStringList periods = m_router->periodsNewestFirst();
+    for (const QString &period : periods) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
+
+        QSqlQuery query(*m_database);
+        query.prepare(QString("SELECT * FROM %1 WHERE message_id = ?").arg(table));
+        query.addBindValue(messageId);
+
+        if (query.exec() && query.next()) {
+            emit messageLoaded(reqId, Message(query));
+            return;
+        }
+    }
+
+    emit messageLoaded(reqId, Message());
 }
 
 void MessageTable::getLastMessage(int reqId, qint64 conversationId)
@@ -206,17 +522,23 @@ void MessageTable::getLastMessage(int reqId, qint64 conversationId)
         return;
     }
 
-    QSqlQuery query(*m_database);
-    query.prepare("SELECT * FROM messages WHERE conversation_id = ? "
-                  "ORDER BY msg_time DESC LIMIT 1");
-    query.addBindValue(conversationId);
+    const QStringList periods = m_router->periodsNewestFirst();
+    for (const QString &period : periods) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
 
-    if (!query.exec() || !query.next()) {
-        emit lastMessageLoaded(reqId, Message());
-        return;
+        QSqlQuery query(*m_database);
+        query.prepare(QString("SELECT * FROM %1 WHERE conversation_id = ? "
+                              "ORDER BY msg_time DESC LIMIT 1").arg(table));
+        query.addBindValue(conversationId);
+
+        if (query.exec() && query.next()) {
+            emit lastMessageLoaded(reqId, Message(query));
+            return;
+        }
     }
 
-    emit lastMessageLoaded(reqId, Message(query));
+    emit lastMessageLoaded(reqId, Message());
 }
 
 void MessageTable::clearMessages(int reqId)
@@ -226,13 +548,7 @@ void MessageTable::clearMessages(int reqId)
         return;
     }
 
-    QSqlQuery query("DELETE FROM messages", *m_database);
-    if (!query.exec()) {
-        emit messagesCleared(reqId, false, query.lastError().text());
-        return;
-    }
-
-    emit messagesCleared(reqId, true, QString());
+    enqueuePurge(reqId, 0);
 }
 
 void MessageTable::clearConversationMessages(int reqId, qint64 conversationId)
@@ -242,16 +558,7 @@ void MessageTable::clearConversationMessages(int reqId, qint64 conversationId)
         return;
     }
 
-    QSqlQuery query(*m_database);
-    query.prepare("DELETE FROM messages WHERE conversation_id = ?");
-    query.addBindValue(conversationId);
-
-    if (!query.exec()) {
-        emit conversationMessagesCleared(reqId, false, query.lastError().text());
-        return;
-    }
-
-    emit conversationMessagesCleared(reqId, true, QString());
+    enqueuePurge(reqId, conversationId);
 }
 
 void MessageTable::getMessagesByTimeRange(int reqId, qint64 conversationId, qint64 startTime, qint64 endTime)
@@ -263,20 +570,27 @@ void MessageTable::getMessagesByTimeRange(int reqId, qint64 conversationId, qint
         return;
     }
 
-    QSqlQuery query(*m_database);
-    query.prepare("SELECT * FROM messages WHERE conversation_id = ? "
-                  "AND msg_time BETWEEN ? AND ? ORDER BY msg_time ASC");
-    query.addBindValue(conversationId);
-    query.addBindValue(startTime);
-    query.addBindValue(endTime);
+    // 只访问与时间范围有交集的分片（从旧到新），结果天然有序
+    const QStringList periods = m_router->periodsInRange(startTime, endTime);
+    for (const QString &period : periods) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
 
-    if (!query.exec()) {
-        emit dbError(reqId, query.lastError().text());
-        emit messagesByTimeRangeLoaded(reqId, messages);
-        return;
-    }
+        QSqlQuery query(*m_database);
+        query.prepare(QString("SELECT * FROM %1 WHERE conversation_id = ? "
+                              "AND msg_time BETWEEN ? AND ? ORDER BY msg_time ASC").arg(table));
+        query.addBindValue(conversationId);
+        query.addBindValue(startTime);
+        query.addBindValue(endTime);
+
+        if (!query.exec()) {
+            emit dbError(reqId, query.lastError().text());
+            emit messagesByTimeRangeLoaded(reqId, messages);
+            return;
+        }
 
-    while (query.next()) messages.append(Message(query));
+        while (query.next()) messages.append(Message(query));
+    }
     emit messagesByTimeRangeLoaded(reqId, messages);
 }
 
@@ -288,17 +602,32 @@ void MessageTable::getMessageCount(int reqId, qint64 conversationId)
         return;
     }
 
-    QSqlQuery query(*m_database);
-    query.prepare("SELECT COUNT(*) FROM messages WHERE conversation_id = ?");
-    query.addBindValue(conversationId);
-
-    if (!query.exec() || !query.next()) {
-        emit dbError(reqId, query.lastError().text());
+    ConversationStats stats;
+    QString error;
+    if (!loadConversationStats(conversationId, &stats, &error)) {
+        emit dbError(reqId, error);
         emit messageCountLoaded(reqId, -1);
         return;
     }
 
-    emit messageCountLoaded(reqId, query.value(0).toInt());
+    emit messageCountLoaded(reqId, stats.messageCount);
+}
+
+void MessageTable::getConversationStats(int reqId, qint64 conversationId)
+{
+    ConversationStats stats;
+    stats.conversationId = conversationId;
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit dbError(reqId, "Database is not open");
+        emit conversationStatsLoaded(reqId, stats);
+        return;
+    }
+
+    QString error;
+    if (!loadConversationStats(conversationId, &stats, &error))
+        emit dbError(reqId, error);
+
+    emit conversationStatsLoaded(reqId, stats);
 }
 
 void MessageTable::getMediaItems(int reqId, qint64 conversationId)
@@ -310,24 +639,669 @@ void MessageTable::getMediaItems(int reqId, qint64 conversationId)
         return;
     }
 
-    QSqlQuery query(*m_database);
-    query.prepare("SELECT * FROM messages WHERE conversation_id = ? "
-                  "AND type IN (1, 2) "
-                  "AND (file_path IS NOT NULL OR file_url IS NOT NULL) "
-                  "ORDER BY msg_time ASC");
-    query.addBindValue(conversationId);
+    // 按时间升序：从最旧的分片（主库表）开始
+    QStringList periods = m_router->periodsNewestFirst();
+    std::reverse(periods.begin(), periods.end());
+    for (const QString &period : std::as_const(periods)) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
+
+        QSqlQuery query(*m_database);
+        query.prepare(QString("SELECT * FROM %1 WHERE conversation_id = ? "
+                              "AND type IN (1, 2) "
+                              "AND (file_path IS NOT NULL OR file_url IS NOT NULL) "
+                              "ORDER BY msg_time ASC").arg(table));
+        query.addBindValue(conversationId);
+
+        if (!query.exec()) {
+            emit dbError(reqId, query.lastError().text());
+            emit mediaItemsLoaded(reqId, mediaItems);
+            return;
+        }
+
+        while (query.next()) {
+            MediaItem media = MediaItem::fromSqlQuery(query);
+            if (media.isValid()) mediaItems.append(std::move(media));
+        }
+    }
+
+    emit mediaItemsLoaded(reqId, mediaItems);
+}
+
+void MessageTable::getMediaWindow(int reqId, qint64 conversationId, qint64 anchorMessageId, int radius)
+{
+    QList<MediaItem> items;
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit dbError(reqId, "Database is not open");
+        emit mediaWindowLoaded(reqId, anchorMessageId, items, false, false);
+        return;
+    }
+
+    // 定位锚点消息时间；找不到时从最新的媒体开始向前取
+    qint64 anchorTime = std::numeric_limits<qint64>::max();
+    qint64 anchorId = std::numeric_limits<qint64>::max();
+    const QStringList periods = m_router->periodsNewestFirst();
+    for (const QString &period : periods) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
+
+        QSqlQuery query(*m_database);
+        query.prepare(QString("SELECT msg_time FROM %1 WHERE message_id = ?").arg(table));
+        query.addBindValue(anchorMessageId);
+        if (query.exec() && query.next()) {
+            anchorTime = query.value(0).toLongLong();
+            anchorId = anchorMessageId;
+            break;
+        }
+    }
+
+    // 锚点及其之后的 radius 条（多取一条用于判断是否还有更新的），锚点之前的 radius 条
+    QList<MediaItem> newer;
+    QList<MediaItem> older;
+    QString error;
+    if (!fetchMediaPage(conversationId, anchorTime, anchorId, false, true, radius + 2, &newer, &error)
+        || !fetchMediaPage(conversationId, anchorTime, anchorId, true, false, radius + 1, &older, &error)) {
+        emit dbError(reqId, error);
+        emit mediaWindowLoaded(reqId, anchorMessageId, items, false, false);
+        return;
+    }
+
+    const bool hasNewer = newer.size() > radius + 1;
+    const bool hasOlder = older.size() > radius;
+    if (hasNewer) newer.removeLast();
+    if (hasOlder) older.removeLast();
 
+    items.reserve(older.size() + newer.size());
+    for (auto it = older.crbegin(); it != older.crend(); ++it) items.append(*it);
+    items.append(newer);
+
+    emit mediaWindowLoaded(reqId, anchorMessageId, items, hasOlder, hasNewer);
+}
+
+void MessageTable::getMediaPage(int reqId, qint64 conversationId, qint64 cursorTime,
+                                qint64 cursorMessageId, bool older, int limit)
+{
+    QList<MediaItem> items;
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit dbError(reqId, "Database is not open");
+        emit mediaPageLoaded(reqId, older, items, false);
+        return;
+    }
+
+    QString error;
+    if (!fetchMediaPage(conversationId, cursorTime, cursorMessageId, older, false, limit + 1, &items, &error)) {
+        emit dbError(reqId, error);
+        emit mediaPageLoaded(reqId, older, QList<MediaItem>(), false);
+        return;
+    }
+
+    const bool hasMore = items.size() > limit;
+    if (hasMore) items.removeLast();
+    // 结果统一按时间升序返回，便于模型直接前插/追加
+    if (older) std::reverse(items.begin(), items.end());
+
+    emit mediaPageLoaded(reqId, older, items, hasMore);
+}
+
+void MessageTable::getDaySummaries(int reqId, qint64 conversationId)
+{
+    QList<MessageDaySummary> summaries;
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit dbError(reqId, "Database is not open");
+        emit daySummariesLoaded(reqId, summaries);
+        return;
+    }
+
+    // 主库表最旧，其后分片按月份升序，拼接结果天然按天升序
+    QStringList periods = m_router->periodsNewestFirst();
+    std::reverse(periods.begin(), periods.end());
+    for (const QString &period : std::as_const(periods)) {
+        const QString table = m_router->tableForPeriod(period, DatabaseSchema::TABLE_MESSAGE_DAY_SUMMARY);
+        if (table.isEmpty()) continue;
+
+        QSqlQuery query(*m_database);
+        query.prepare(QString("SELECT * FROM %1 WHERE conversation_id = ? ORDER BY day ASC").arg(table));
+        query.addBindValue(conversationId);
+
+        if (!query.exec()) {
+            emit dbError(reqId, query.lastError().text());
+            emit daySummariesLoaded(reqId, summaries);
+            return;
+        }
+        while (query.next()) summaries.append(MessageDaySummary(query));
+    }
+    emit daySummariesLoaded(reqId, summaries);
+}
+
+void MessageTable::getMessagesAtDate(int reqId, qint64 conversationId, int dayKey, int limit)
+{
+    QVector<Message> messages;
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit dbError(reqId, "Database is not open");
+        emit messagesAtDateLoaded(reqId, 0, messages, false);
+        return;
+    }
+
+    QStringList periods = m_router->periodsNewestFirst();
+    std::reverse(periods.begin(), periods.end());
+
+    // 日期键按本地时间，分片周期按 UTC：取本地当天零点所在的 UTC 月份，
+    // 东时区月初那天的前几个小时仍落在上一个分片中
+    const qint64 dayStartUtc = MessageDaySummary::dateForKey(dayKey).startOfDay().toSecsSinceEpoch();
+    const QString targetPeriod = MessageShardRouter::periodForTime(dayStartUtc);
+
+    // 1. 汇总表主键查找：目标日期当天或之后最近一天的第一条消息
+    int anchorDay = 0;
+    qint64 anchorId = 0;
+    qint64 anchorTime = 0;
+    for (const QString &period : std::as_const(periods)) {
+        if (!period.isEmpty() && period < targetPeriod) continue; // 整个分片都早于目标日期
+        const QString table = m_router->tableForPeriod(period, DatabaseSchema::TABLE_MESSAGE_DAY_SUMMARY);
+        if (table.isEmpty()) continue;
+
+        QSqlQuery query(*m_database);
+        query.prepare(QString("SELECT day, first_message_id, first_msg_time FROM %1 "
+                              "WHERE conversation_id = ? AND day >= ? ORDER BY day ASC LIMIT 1").arg(table));
+        query.addBindValue(conversationId);
+        query.addBindValue(dayKey);
+        if (query.exec() && query.next()) {
+            const int day = query.value(0).toInt();
+            if (anchorDay == 0 || day < anchorDay) {
+                anchorDay = day;
+                anchorId = query.value(1).toLongLong();
+                anchorTime = query.value(2).toLongLong();
+            }
+            if (!period.isEmpty()) break; // 分片按月份升序，第一个命中的分片即最近
+        }
+    }
+
+    if (anchorDay == 0) {
+        emit messagesAtDateLoaded(reqId, 0, messages, false);
+        return;
+    }
+
+    // 2. 从锚点开始加载一页（按时间升序，可能跨越分片），多取一条判断是否还有更新的
+    for (const QString &period : std::as_const(periods)) {
+        if (messages.size() > limit) break;
+        if (!period.isEmpty() && period < targetPeriod) continue;
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
+
+        const QString sql = QString(R"(
+            SELECT %2
+            FROM %1 m
+            INNER JOIN users u ON m.sender_id = u.user_id
+            LEFT JOIN contacts c ON m.sender_id = c.user_id
+            WHERE m.conversation_id = ? AND m.msg_time >= ?
+            ORDER BY m.msg_time ASC, m.message_id ASC
+            LIMIT ?
+        )").arg(table, kJoinedColumns);
+
+        QString error;
+        if (!appendJoinedRows(sql, {conversationId, anchorTime, int(limit + 1 - messages.size())},
+                              &messages, &error)) {
+            emit dbError(reqId, error);
+            emit messagesAtDateLoaded(reqId, 0, QVector<Message>(), false);
+            return;
+        }
+    }
+
+    const bool hasNewer = messages.size() > limit;
+    if (hasNewer) messages.removeLast();
+    emit messagesAtDateLoaded(reqId, anchorId, messages, hasNewer);
+}
+
+void MessageTable::dropMessageShardsBefore(int reqId, qint64 beforeTime)
+{
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit messageShardsDropped(reqId, 0);
+        return;
+    }
+
+    const QStringList dropped = m_router->dropShardsBefore(MessageShardRouter::periodForTime(beforeTime));
+    if (!dropped.isEmpty()) {
+        for (const QString &period : dropped) {
+            qint64 startTime = 0;
+            qint64 endTime = 0;
+            MessageShardRouter::periodTimeRange(period, &startTime, &endTime);
+            QString mentionError;
+            if (!m_mentions->removeOrphansBetween(startTime, endTime, &mentionError))
+                qWarning() << "Clean mention index failed:" << period << mentionError;
+        }
+
+        // 会话摘要可能指向已删除的分片，统一重算
+        QSqlQuery query(*m_database);
+        if (query.exec("SELECT conversation_id FROM conversations")) {
+            while (query.next()) m_summarizer->markStale(query.value(0).toLongLong());
+        }
+        QString error;
+        if (!m_summarizer->flush(&error)) {
+            qWarning() << "Refresh conversation summaries failed:" << error;
+            m_summarizer->discard();
+        }
+    }
+    emit messageShardsDropped(reqId, dropped.size());
+}
+
+void MessageTable::getUnreadMentions(int reqId, qint64 userId)
+{
+    QList<MentionSummary> mentions;
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) {
+        emit dbError(reqId, "Database is not open");
+        emit unreadMentionsLoaded(reqId, mentions);
+        return;
+    }
+
+    // 只扫描部分索引中该用户的未读行；MIN() 聚合时裸列 message_id 取自最早的那一行
+    QSqlQuery query(*m_database);
+    query.prepare(QString("SELECT conversation_id, COUNT(*) AS unread_count, message_id, MIN(msg_time) AS first_msg_time "
+                          "FROM %1 WHERE user_id = ? AND is_read = 0 GROUP BY conversation_id")
+                      .arg(DatabaseSchema::TABLE_MESSAGE_MENTIONS));
+    query.addBindValue(userId);
     if (!query.exec()) {
         emit dbError(reqId, query.lastError().text());
-        emit mediaItemsLoaded(reqId, mediaItems);
+    } else {
+        while (query.next()) mentions.append(MentionSummary(query));
+    }
+    emit unreadMentionsLoaded(reqId, mentions);
+}
+
+void MessageTable::markMentionsRead(int reqId, qint64 userId, qint64 conversationId)
+{
+    if (!m_database || !m_database->isValid() || !m_database->isOpen()) return;
+
+    QSqlQuery query(*m_database);
+    query.prepare(QString("UPDATE %1 SET is_read = 1 WHERE user_id = ? AND conversation_id = ? AND is_read = 0")
+                      .arg(DatabaseSchema::TABLE_MESSAGE_MENTIONS));
+    query.addBindValue(userId);
+    query.addBindValue(conversationId);
+    if (!query.exec()) emit dbError(reqId, query.lastError().text());
+}
+
+void MessageTable::importMessages(int reqId, QString archivePath)
+{
+    if (!m_importer) {
+        emit importFinished(reqId, false, "Database is not open", 0, 0);
         return;
     }
+    m_importer->start(reqId, archivePath);
+}
+
+void MessageTable::cancelImport(int reqId)
+{
+    if (m_importer) m_importer->cancel(reqId);
+}
+
+void MessageTable::getPendingImports(int reqId)
+{
+    emit pendingImportsLoaded(reqId, m_importer ? m_importer->pendingArchives() : QStringList());
+}
+
+bool MessageTable::loadConversationStats(qint64 conversationId, ConversationStats *stats, QString *error)
+{
+    stats->conversationId = conversationId;
 
+    // 每个分片各自维护一行统计，按主键读取后合并
+    const QStringList periods = m_router->periodsNewestFirst();
+    for (const QString &period : periods) {
+        const QString table = m_router->tableForPeriod(period, DatabaseSchema::TABLE_CONVERSATION_STATS);
+        if (table.isEmpty()) continue;
+
+        QSqlQuery query(*m_database);
+        query.prepare(QString("SELECT * FROM %1 WHERE conversation_id = ?").arg(table));
+        query.addBindValue(conversationId);
+
+        if (!query.exec()) {
+            if (error) *error = query.lastError().text();
+            return false;
+        }
+        if (query.next()) stats->merge(ConversationStats(query));
+    }
+    return true;
+}
+
+bool MessageTable::fetchMediaPage(qint64 conversationId, qint64 cursorTime, qint64 cursorMessageId,
+                                  bool older, bool inclusive, int limit,
+                                  QList<MediaItem> *items, QString *error)
+{
+    // 游标条件写成 msg_time 范围 + 同一时间内按 message_id 决胜，范围部分可直接走部分索引
+    const QString cmp = older ? "<" : ">";
+    const QString tieCmp = cmp + (inclusive ? "=" : "");
+    const QString order = older ? "DESC" : "ASC";
+    const QString sql = QString("SELECT message_id, msg_time, type, thumbnail_path, file_path, file_url "
+                                "FROM %1 WHERE conversation_id = ? AND type IN (1, 2) "
+                                "AND (file_path IS NOT NULL OR file_url IS NOT NULL) "
+                                "AND msg_time %2= ? AND (msg_time %2 ? OR message_id %3 ?) "
+                                "ORDER BY msg_time %4, message_id %4 LIMIT ?");
+
+    // 向前取从最新的分片开始，向后取从最旧的分片（主库表）开始
+    QStringList periods = m_router->periodsNewestFirst();
+    if (!older) std::reverse(periods.begin(), periods.end());
+
+    for (const QString &period : std::as_const(periods)) {
+        if (items->size() >= limit) break;
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
+
+        QSqlQuery query(*m_database);
+        query.prepare(sql.arg(table, cmp, tieCmp, order));
+        query.addBindValue(conversationId);
+        query.addBindValue(cursorTime);
+        query.addBindValue(cursorTime);
+        query.addBindValue(cursorMessageId);
+        query.addBindValue(limit - items->size());
+
+        if (!query.exec()) {
+            if (error) *error = query.lastError().text();
+            return false;
+        }
+        while (query.next()) {
+            MediaItem media = MediaItem::fromSqlQuery(query);
+            if (media.isValid()) items->append(std::move(media));
+        }
+    }
+    return true;
+}
+
+void MessageTable::enqueuePurge(int reqId, qint64 conversationId)
+{
+    PurgeJob job;
+    job.reqId = reqId;
+    job.conversationId = conversationId;
+    job.periods = m_router->periodsNewestFirst();
+
+    // 记下清空范围的上界：排队等待或分块执行期间保存的新消息不会被删除
+    for (const QString &period : std::as_const(job.periods)) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
+        QSqlQuery query(*m_database);
+        if (query.exec(QString("SELECT COALESCE(MAX(message_id), 0) FROM %1").arg(table)) && query.next())
+            job.maxIds.insert(period, query.value(0).toLongLong());
+    }
+    m_purgeJobs.append(job);
+
+    if (m_purgeJobs.size() == 1)
+        QMetaObject::invokeMethod(this, &MessageTable::runPurgeStep, Qt::QueuedConnection);
+}
+
+void MessageTable::runPurgeStep()
+{
+    if (m_purgeJobs.isEmpty()) return;
+    PurgeJob &job = m_purgeJobs.first();
+
+    bool ok = true;
+    QString error;
+    while (!job.periods.isEmpty()) {
+        const QString period = job.periods.first();
+
+        // 整表清空时分片直接删除文件，删除前只读出其中的媒体路径；
+        // 请求之后分片中又写入了消息时改为分块删除，保留新消息
+        const QString table = m_router->tableForPeriod(period);
+        QSqlQuery query(*m_database);
+        if (job.conversationId == 0 && !period.isEmpty() && !table.isEmpty()
+            && query.exec(QString("SELECT COALESCE(MAX(message_id), 0) FROM %1").arg(table)) && query.next()
+            && query.value(0).toLongLong() <= job.maxIds.value(period)) {
+            QStringList paths;
+            if (query.exec(QString("SELECT file_path, thumbnail_path FROM %1 WHERE type <> 0").arg(table))) {
+                while (query.next()) paths << query.value(0).toString() << query.value(1).toString();
+            }
+            if (!m_router->dropShard(period, &error)) {
+                ok = false;
+                break;
+            }
+            for (const QString &path : std::as_const(paths)) {
+                if (!path.isEmpty()) job.mediaPaths.insert(path);
+            }
+            job.periods.removeFirst();
+            continue;
+        }
+
+        bool done = false;
+        if (!purgeChunk(job, period, &done, &error)) {
+            ok = false;
+            break;
+        }
+        if (done) {
+            job.periods.removeFirst();
+            continue;
+        }
+
+        // 本块完成，让出事件循环后继续
+        emit purgeProgress(job.reqId, job.deleted);
+        QMetaObject::invokeMethod(this, &MessageTable::runPurgeStep, Qt::QueuedConnection);
+        return;
+    }
+
+    const PurgeJob finished = m_purgeJobs.takeFirst();
+    finishPurge(finished, ok, error);
+
+    if (!m_purgeJobs.isEmpty())
+        QMetaObject::invokeMethod(this, &MessageTable::runPurgeStep, Qt::QueuedConnection);
+}
+
+bool MessageTable::purgeChunk(PurgeJob &job, const QString &period, bool *done, QString *error)
+{
+    const QString table = m_router->tableForPeriod(period);
+    if (table.isEmpty()) {
+        *done = true;
+        return true;
+    }
+
+    QSqlQuery query(*m_database);
+
+    // 首次处理该分片时写入清空标记，删除触发器据此跳过逐行维护
+    if (!job.marked.contains(period)) {
+        query.prepare(QString("INSERT OR IGNORE INTO %1 (conversation_id) VALUES (?)")
+                          .arg(m_router->tableForPeriod(period, DatabaseSchema::TABLE_MESSAGE_PURGES)));
+        query.addBindValue(job.conversationId);
+        if (!query.exec()) {
+            *error = query.lastError().text();
+            return false;
+        }
+        job.marked << period;
+    }
+
+    // 只删除请求清空时已存在的消息（message_id 不超过当时的最大值）
+    const qint64 maxId = job.maxIds.value(period);
+    const QString where = job.conversationId > 0
+                              ? QString("WHERE conversation_id = %1 AND message_id <= %2").arg(job.conversationId).arg(maxId)
+                              : QString("WHERE message_id <= %1").arg(maxId);
+    if (!query.exec(QString("SELECT message_id, file_path, thumbnail_path FROM %1 %2 ORDER BY message_id LIMIT %3")
+                        .arg(table, where).arg(kPurgeChunkSize))) {
+        *error = query.lastError().text();
+        return false;
+    }
+
+    QStringList ids;
+    QStringList paths;
     while (query.next()) {
-        MediaItem media = MediaItem::fromSqlQuery(query);
-        if (media.isValid()) mediaItems.append(media);
+        ids << query.value(0).toString();
+        for (int column : {1, 2}) {
+            const QString path = query.value(column).toString();
+            if (!path.isEmpty()) paths << path;
+        }
+    }
+    if (ids.isEmpty()) {
+        *done = true;
+        return true;
     }
 
-    emit mediaItemsLoaded(reqId, mediaItems);
+    if (!m_database->transaction()) {
+        *error = m_database->lastError().text();
+        return false;
+    }
+    if (!query.exec(QString("DELETE FROM %1 WHERE message_id IN (%2) AND message_id <= %3")
+                        .arg(table, ids.join(',')).arg(maxId))) {
+        *error = query.lastError().text();
+        m_database->rollback();
+        return false;
+    }
+    if (!m_database->commit()) {
+        *error = m_database->lastError().text();
+        m_database->rollback();
+        return false;
+    }
+
+    job.deleted += ids.size();
+    for (const QString &path : std::as_const(paths)) job.mediaPaths.insert(path);
+    *done = ids.size() < kPurgeChunkSize;
+    return true;
 }
 
+QStringList MessageTable::unreferencedMediaPaths(const QSet<QString> &paths)
+{
+    // 候选路径写入临时表，每张消息表只扫描一遍媒体消息，删去仍被引用的路径。
+    // 检查失败时一个文件也不回收：宁可留下孤立文件，也不误删其他会话仍在显示的媒体
+    QSqlQuery query(*m_database);
+    if (!query.exec("CREATE TEMP TABLE IF NOT EXISTS purge_media_paths (path TEXT PRIMARY KEY) WITHOUT ROWID")
+        || !query.exec("DELETE FROM temp.purge_media_paths")) {
+        qWarning() << "Check media references failed:" << query.lastError().text();
+        return {};
+    }
+
+    if (!m_database->transaction()) {
+        qWarning() << "Check media references failed:" << m_database->lastError().text();
+        return {};
+    }
+    query.prepare("INSERT OR IGNORE INTO temp.purge_media_paths (path) VALUES (?)");
+    for (const QString &path : paths) {
+        query.addBindValue(path);
+        if (!query.exec()) {
+            qWarning() << "Check media references failed:" << query.lastError().text();
+            m_database->rollback();
+            return {};
+        }
+    }
+    if (!m_database->commit()) {
+        qWarning() << "Check media references failed:" << m_database->lastError().text();
+        m_database->rollback();
+        return {};
+    }
+
+    QStringList unreferenced;
+    bool ok = true;
+    const QStringList periods = m_router->periodsNewestFirst();
+    for (const QString &period : periods) {
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
+        ok = query.exec(QString("DELETE FROM temp.purge_media_paths WHERE path IN ("
+                                "SELECT file_path FROM %1 WHERE type <> 0 "
+                                "UNION SELECT thumbnail_path FROM %1 WHERE type <> 0)").arg(table));
+        if (!ok) break;
+    }
+    if (ok && query.exec("SELECT path FROM temp.purge_media_paths")) {
+        while (query.next()) unreferenced << query.value(0).toString();
+    } else {
+        qWarning() << "Check media references failed:" << query.lastError().text();
+    }
+    query.finish();
+    if (!query.exec("DELETE FROM temp.purge_media_paths"))
+        qWarning() << "Clear media reference candidates failed:" << query.lastError().text();
+    return unreferenced;
+}
+
+void MessageTable::finishPurge(const PurgeJob &job, bool ok, const QString &reason)
+{
+    // 一次性修正派生表并移除清空标记（失败时同样移除，避免触发器长期被跳过）。
+    // 按剩余消息重建：既覆盖中途失败时未删除的行，也计入清空期间新写入的消息
+    for (const QString &period : job.marked) {
+        const QString purges = m_router->tableForPeriod(period, DatabaseSchema::TABLE_MESSAGE_PURGES);
+        if (purges.isEmpty()) continue;
+
+        QSqlQuery query(*m_database);
+        const QString schema = period.isEmpty() ? QString() : purges.section('.', 0, 0);
+        const bool inTransaction = m_database->transaction();
+        const QStringList rebuild = DatabaseSchema::getRebuildConversationDerived(schema, job.conversationId);
+        for (const QString &sql : rebuild) {
+            if (!query.exec(sql)) qWarning() << "Rebuild derived tables failed:" << query.lastError().text();
+        }
+        query.prepare(QString("DELETE FROM %1 WHERE conversation_id = ?").arg(purges));
+        query.addBindValue(job.conversationId);
+        if (!query.exec())
+            qWarning() << "Clear purge marker failed:" << query.lastError().text();
+        if (inTransaction && !m_database->commit()) {
+            qWarning() << "Commit purge cleanup failed:" << m_database->lastError().text();
+            m_database->rollback();
+        }
+    }
+
+    qint64 maxId = 0;
+    for (qint64 id : job.maxIds) maxId = std::max(maxId, id);
+    QString mentionError;
+    if (!m_mentions->removeConversation(job.conversationId, maxId, &mentionError))
+        qWarning() << "Clear mention index failed:" << mentionError;
+
+    // 会话摘要按剩余消息重算（清空期间可能写入了新消息）
+    if (job.conversationId > 0) {
+        m_summarizer->markStale(job.conversationId);
+    } else {
+        QSqlQuery query(*m_database);
+        if (query.exec("SELECT conversation_id FROM conversations")) {
+            while (query.next()) m_summarizer->markStale(query.value(0).toLongLong());
+        }
+    }
+    QString error;
+    if (!m_summarizer->flush(&error)) {
+        qWarning() << "Refresh conversation summary failed:" << error;
+        m_summarizer->discard();
+    }
+
+    // 媒体文件在全部分块结束后统一检查引用再回收：清空期间写入的消息与未删除的行同样计入
+    if (!job.mediaPaths.isEmpty()) m_reclaimer->enqueue(unreferencedMediaPaths(job.mediaPaths));
+
+    qDebug() << "Purged" << job.deleted << "messages"
+             << (job.conversationId > 0 ? QString("of conversation %1").arg(job.conversationId) : QString("in total"));
+
+    if (job.conversationId > 0)
+        emit conversationMessagesCleared(job.reqId, ok, reason);
+    else
+        emit messagesCleared(job.reqId, ok, reason);
+}
+
+bool MessageTable::fetchMessagePage(qint64 conversationId, qint64 cursorTime, qint64 cursorMessageId,
+                                    bool older, bool inclusive, int limit,
+                                    QVector<Message> *messages, QString *error)
+{
+    // 向前取从最新的分片开始，向后取从最旧的分片（主库表）开始
+    QStringList periods = m_router->periodsNewestFirst();
+    if (!older) std::reverse(periods.begin(), periods.end());
+
+    for (const QString &period : std::as_const(periods)) {
+        if (messages->size() >= limit) break;
+        const QString table = m_router->tableForPeriod(period);
+        if (table.isEmpty()) continue;
+
+        const QVariantList binds = {conversationId, cursorTime, cursorTime, cursorMessageId,
+                                    int(limit - messages->size())};
+        if (!appendJoinedRows(joinedKeysetSql(table, older, inclusive), binds, messages, error))
+            return false;
+    }
+    return true;
+}
+
+bool MessageTable::appendJoinedRows(const QString &sql, const QVariantList &binds,
+                                    QVector<Message> *messages, QString *error)
+{
+    if (m_native->isAvailable()) {
+        NativeStatement stmt = m_native->prepare(sql, error);
+        if (!stmt) return false;
+        for (int i = 0; i < binds.size(); ++i) stmt.bind(i + 1, binds.at(i));
+        while (stmt.next()) messages->append(messageFromNativeRow(stmt));
+        if (stmt.hasError()) {
+            if (error) *error = stmt.errorString();
+            return false;
+        }
+        return true;
+    }
+
+    QSqlQuery query(*m_database);
+    query.setForwardOnly(true);
+    query.prepare(sql);
+    for (const QVariant &value : binds) query.addBindValue(value);
+    if (!query.exec()) {
+        if (error) *error = query.lastError().text();
+        return false;
+    }
+    while (query.next()) messages->append(messageFromJoinedRow(query));
+    return true;
+}
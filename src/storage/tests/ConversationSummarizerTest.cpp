@@ -0,0 +1,463 @@
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QDateTime>
+#include <QDir>
+#include "ConversationSummarizer.h"
+#include "MessageShardRouter.h"
+#include "DatabaseSchema.h"
+
+/**
+ * @brief ConversationSummarizer 与原逐行触发器的对照测试
+ *
+ * 同一组插入/删除/清空操作分别作用于两个数据库：
+ *  - 被测库：当前结构（可启用月度分片），会话摘要由 ConversationSummarizer 在提交前批量写入；
+ *  - 参照库：单张 messages 表，挂着原来的 trigger_conversation_insert / trigger_conversation_delete。
+ * 每步之后比较两边 conversations 的 last_message_content / last_message_time / unread_count。
+ */
+class ConversationSummarizerTest : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanup();
+
+    void singleInserts();
+    void outOfOrderInsert();
+    void batchedInserts();
+    void deleteLatestAndOlder();
+    void batchedDeletes();
+    void insertThenDeleteInOneTransaction();
+    void clearConversation();
+    void acrossShards();
+    void clearAcrossShards();
+
+private:
+    struct Row {
+        qint64 conversationId;
+        QString content;
+        qint64 msgTime;
+    };
+
+    static qint64 utc(int year, int month, int day, int hour = 12);
+    void openDatabases();
+    void closeDatabases();
+    void exec(QSqlDatabase &db, const QString &sql);
+
+    // 在一个事务内写入 rows，返回分配的消息ID
+    QList<qint64> insertMessages(const QList<Row> &rows);
+    // 在一个事务内删除消息
+    void deleteMessages(const QList<qint64> &messageIds);
+    // 清空会话：逐表删除后整体重算摘要（与批量清空结束时的处理一致）
+    void clearConversationMessages(qint64 conversationId);
+    void compareSummaries();
+
+    QTemporaryDir m_dir;
+    QSharedPointer<QSqlDatabase> m_db;
+    QSqlDatabase m_reference;
+    QScopedPointer<MessageShardRouter> m_router;
+    QScopedPointer<ConversationSummarizer> m_summarizer;
+};
+
+namespace {
+// 原 DatabaseSchema::getCreateTriggers() 中的会话摘要触发器
+// （删除触发器在没有剩余消息时改为写 0，与 ConversationSummarizer 一致）
+const char *kLegacyInsertTrigger = R"(
+    CREATE TRIGGER IF NOT EXISTS trigger_conversation_insert
+    AFTER INSERT ON messages
+    FOR EACH ROW
+    BEGIN
+        UPDATE conversations
+        SET last_message_content = NEW.content,
+            last_message_time = NEW.msg_time,
+            unread_count = unread_count + 1
+        WHERE conversation_id = NEW.conversation_id;
+    END
+)";
+
+const char *kLegacyDeleteTrigger = R"(
+    CREATE TRIGGER IF NOT EXISTS trigger_conversation_delete
+    AFTER DELETE ON messages
+    FOR EACH ROW
+    BEGIN
+        UPDATE conversations
+        SET last_message_content = (
+            SELECT content FROM messages
+            WHERE conversation_id = OLD.conversation_id
+            ORDER BY msg_time DESC, message_id DESC
+            LIMIT 1
+        ),
+        last_message_time = COALESCE((
+            SELECT msg_time FROM messages
+            WHERE conversation_id = OLD.conversation_id
+            ORDER BY msg_time DESC, message_id DESC
+            LIMIT 1
+        ), 0)
+        WHERE conversation_id = OLD.conversation_id
+        AND last_message_time <= OLD.msg_time;
+    END
+)";
+
+constexpr qint64 kConversationA = 1;
+constexpr qint64 kConversationB = 2;
+constexpr qint64 kSender = 10;
+constexpr qint64 kConsignee = 11;
+}
+
+qint64 ConversationSummarizerTest::utc(int year, int month, int day, int hour)
+{
+    return QDateTime(QDate(year, month, day), QTime(hour, 0), Qt::UTC).toSecsSinceEpoch();
+}
+
+void ConversationSummarizerTest::initTestCase()
+{
+    // 分片目录位于数据库默认路径旁，测试模式下指向独立的测试目录
+    QStandardPaths::setTestModeEnabled(true);
+    QVERIFY(m_dir.isValid());
+}
+
+void ConversationSummarizerTest::init()
+{
+    MessageShardRouter::setEnabled(false);
+    QDir(MessageShardRouter::shardDirectory()).removeRecursively();
+    openDatabases();
+}
+
+void ConversationSummarizerTest::cleanup()
+{
+    closeDatabases();
+    MessageShardRouter::setEnabled(false);
+    QDir(MessageShardRouter::shardDirectory()).removeRecursively();
+}
+
+void ConversationSummarizerTest::openDatabases()
+{
+    const QString testName = QString::fromLatin1(QTest::currentTestFunction());
+
+    m_db = QSharedPointer<QSqlDatabase>::create(QSqlDatabase::addDatabase("QSQLITE", "summarizer"));
+    m_db->setDatabaseName(m_dir.filePath(testName + "_summarizer.db"));
+    QVERIFY2(m_db->open(), qPrintable(m_db->lastError().text()));
+    for (const QString &sql : DatabaseSchema::getCreateTables()) exec(*m_db, sql);
+    for (const QString &sql : DatabaseSchema::getCreateTriggers()) exec(*m_db, sql);
+
+    m_reference = QSqlDatabase::addDatabase("QSQLITE", "reference");
+    m_reference.setDatabaseName(m_dir.filePath(testName + "_reference.db"));
+    QVERIFY2(m_reference.open(), qPrintable(m_reference.lastError().text()));
+    exec(m_reference, DatabaseSchema::getCreateTableConversations());
+    exec(m_reference, DatabaseSchema::getCreateTableMessages());
+    exec(m_reference, kLegacyInsertTrigger);
+    exec(m_reference, kLegacyDeleteTrigger);
+
+    for (QSqlDatabase *db : {m_db.data(), &m_reference}) {
+        exec(*db, QString("INSERT INTO conversations (conversation_id, user_id, type) VALUES (%1, %2, 0)")
+                      .arg(kConversationA).arg(kConsignee));
+        exec(*db, QString("INSERT INTO conversations (conversation_id, group_id, type) VALUES (%1, 100, 1)")
+                      .arg(kConversationB));
+    }
+
+    m_router.reset(new MessageShardRouter(m_db));
+    m_summarizer.reset(new ConversationSummarizer(m_db, m_router.data()));
+}
+
+void ConversationSummarizerTest::closeDatabases()
+{
+    // 分片路由析构时 DETACH，必须在连接关闭前
+    m_summarizer.reset();
+    m_router.reset();
+    if (m_db) {
+        m_db->close();
+        m_db.reset();
+    }
+    m_reference.close();
+    m_reference = QSqlDatabase();
+    QSqlDatabase::removeDatabase("summarizer");
+    QSqlDatabase::removeDatabase("reference");
+}
+
+void ConversationSummarizerTest::exec(QSqlDatabase &db, const QString &sql)
+{
+    QSqlQuery query(db);
+    QVERIFY2(query.exec(sql), qPrintable(query.lastError().text() + "\n" + sql));
+}
+
+QList<qint64> ConversationSummarizerTest::insertMessages(const QList<Row> &rows)
+{
+    QList<qint64> ids;
+    QString error;
+
+    // 挂载分片不能在事务内进行，先解析好每行的目标表
+    QStringList tables;
+    for (const Row &row : rows) {
+        const QString table = m_router->tableForWrite(row.msgTime, &error);
+        if (table.isEmpty()) qFatal("Route message failed: %s", qPrintable(error));
+        tables << table;
+    }
+
+    if (!m_db->transaction()) qFatal("Begin transaction failed");
+    QSqlQuery insert(*m_db);
+    for (int i = 0; i < rows.size(); ++i) {
+        const Row &row = rows.at(i);
+        const qint64 allocated = m_router->allocateMessageIds(1, &error);
+        if (allocated < 0) qFatal("Allocate message id failed: %s", qPrintable(error));
+
+        insert.prepare(QString("INSERT INTO %1 (message_id, conversation_id, sender_id, consignee_id, type, content, msg_time) "
+                               "VALUES (?, ?, ?, ?, 0, ?, ?)").arg(tables.at(i)));
+        insert.addBindValue(allocated > 0 ? QVariant(allocated) : QVariant());
+        insert.addBindValue(row.conversationId);
+        insert.addBindValue(kSender);
+        insert.addBindValue(kConsignee);
+        insert.addBindValue(row.content);
+        insert.addBindValue(row.msgTime);
+        if (!insert.exec()) qFatal("Insert failed: %s", qPrintable(insert.lastError().text()));
+        ids << insert.lastInsertId().toLongLong();
+        m_summarizer->recordInsert(row.conversationId, row.content, row.msgTime);
+    }
+    if (!m_summarizer->flush(&error)) qFatal("Flush failed: %s", qPrintable(error));
+    if (!m_db->commit()) qFatal("Commit failed");
+
+    // 参照库使用相同的消息ID，删除时两边可按ID对应
+    m_reference.transaction();
+    QSqlQuery reference(m_reference);
+    for (int i = 0; i < rows.size(); ++i) {
+        const Row &row = rows.at(i);
+        reference.prepare("INSERT INTO messages (message_id, conversation_id, sender_id, consignee_id, type, content, msg_time) "
+                          "VALUES (?, ?, ?, ?, 0, ?, ?)");
+        reference.addBindValue(ids.at(i));
+        reference.addBindValue(row.conversationId);
+        reference.addBindValue(kSender);
+        reference.addBindValue(kConsignee);
+        reference.addBindValue(row.content);
+        reference.addBindValue(row.msgTime);
+        if (!reference.exec()) qFatal("Reference insert failed: %s", qPrintable(reference.lastError().text()));
+    }
+    m_reference.commit();
+    return ids;
+}
+
+void ConversationSummarizerTest::deleteMessages(const QList<qint64> &messageIds)
+{
+    QStringList tables;
+    for (const QString &period : m_router->periodsNewestFirst()) {
+        const QString table = m_router->tableForPeriod(period);
+        if (!table.isEmpty()) tables << table;
+    }
+
+    if (!m_db->transaction()) qFatal("Begin transaction failed");
+    QSqlQuery query(*m_db);
+    for (qint64 messageId : messageIds) {
+        for (const QString &table : std::as_const(tables)) {
+            query.prepare(QString("SELECT conversation_id, msg_time FROM %1 WHERE message_id = ?").arg(table));
+            query.addBindValue(messageId);
+            if (!query.exec() || !query.next()) continue;
+            const qint64 conversationId = query.value(0).toLongLong();
+            const qint64 msgTime = query.value(1).toLongLong();
+
+            query.prepare(QString("DELETE FROM %1 WHERE message_id = ?").arg(table));
+            query.addBindValue(messageId);
+            if (!query.exec()) qFatal("Delete failed: %s", qPrintable(query.lastError().text()));
+            m_summarizer->recordDelete(conversationId, msgTime);
+            break;
+        }
+    }
+    QString error;
+    if (!m_summarizer->flush(&error)) qFatal("Flush failed: %s", qPrintable(error));
+    if (!m_db->commit()) qFatal("Commit failed");
+
+    m_reference.transaction();
+    QSqlQuery reference(m_reference);
+    for (qint64 messageId : messageIds) {
+        reference.prepare("DELETE FROM messages WHERE message_id = ?");
+        reference.addBindValue(messageId);
+        if (!reference.exec()) qFatal("Reference delete failed: %s", qPrintable(reference.lastError().text()));
+    }
+    m_reference.commit();
+}
+
+void ConversationSummarizerTest::clearConversationMessages(qint64 conversationId)
+{
+    QStringList tables;
+    for (const QString &period : m_router->periodsNewestFirst()) {
+        const QString table = m_router->tableForPeriod(period);
+        if (!table.isEmpty()) tables << table;
+    }
+
+    if (!m_db->transaction()) qFatal("Begin transaction failed");
+    QSqlQuery query(*m_db);
+    for (const QString &table : std::as_const(tables)) {
+        query.prepare(QString("DELETE FROM %1 WHERE conversation_id = ?").arg(table));
+        query.addBindValue(conversationId);
+        if (!query.exec()) qFatal("Clear failed: %s", qPrintable(query.lastError().text()));
+    }
+    m_summarizer->markStale(conversationId);
+    QString error;
+    if (!m_summarizer->flush(&error)) qFatal("Flush failed: %s", qPrintable(error));
+    if (!m_db->commit()) qFatal("Commit failed");
+
+    QSqlQuery reference(m_reference);
+    reference.prepare("DELETE FROM messages WHERE conversation_id = ?");
+    reference.addBindValue(conversationId);
+    if (!reference.exec()) qFatal("Reference clear failed: %s", qPrintable(reference.lastError().text()));
+}
+
+void ConversationSummarizerTest::compareSummaries()
+{
+    const QString sql = QStringLiteral("SELECT conversation_id, last_message_content, last_message_time, unread_count "
+                                       "FROM conversations ORDER BY conversation_id");
+    QSqlQuery actual(*m_db);
+    QSqlQuery expected(m_reference);
+    QVERIFY(actual.exec(sql));
+    QVERIFY(expected.exec(sql));
+
+    while (expected.next()) {
+        QVERIFY(actual.next());
+        QCOMPARE(actual.value(0).toLongLong(), expected.value(0).toLongLong());
+        QCOMPARE(actual.value(1).isNull(), expected.value(1).isNull());
+        QCOMPARE(actual.value(1).toString(), expected.value(1).toString());
+        QCOMPARE(actual.value(2).isNull(), expected.value(2).isNull());
+        QCOMPARE(actual.value(2).toLongLong(), expected.value(2).toLongLong());
+        QCOMPARE(actual.value(3).toInt(), expected.value(3).toInt());
+    }
+    QVERIFY(!actual.next());
+}
+
+void ConversationSummarizerTest::singleInserts()
+{
+    insertMessages({{kConversationA, "a1", utc(2024, 1, 1)}});
+    compareSummaries();
+    insertMessages({{kConversationB, "b1", utc(2024, 1, 2)}});
+    compareSummaries();
+    insertMessages({{kConversationA, "a2", utc(2024, 1, 3)}});
+    compareSummaries();
+}
+
+void ConversationSummarizerTest::outOfOrderInsert()
+{
+    // 原插入触发器不比较时间：后插入的旧消息同样成为摘要
+    insertMessages({{kConversationA, "new", utc(2024, 1, 5)}});
+    insertMessages({{kConversationA, "old", utc(2024, 1, 1)}});
+    compareSummaries();
+}
+
+void ConversationSummarizerTest::batchedInserts()
+{
+    insertMessages({{kConversationA, "a1", utc(2024, 1, 1)},
+                    {kConversationB, "b1", utc(2024, 1, 1, 13)},
+                    {kConversationA, "a2", utc(2024, 1, 2)},
+                    {kConversationA, "a3", utc(2024, 1, 1, 18)}});
+    compareSummaries();
+}
+
+void ConversationSummarizerTest::deleteLatestAndOlder()
+{
+    const QList<qint64> ids = insertMessages({{kConversationA, "a1", utc(2024, 1, 1)},
+                                              {kConversationA, "a2", utc(2024, 1, 2)},
+                                              {kConversationA, "a3", utc(2024, 1, 3)}});
+    deleteMessages({ids.at(0)}); // 早于摘要：不变
+    compareSummaries();
+    deleteMessages({ids.at(2)}); // 最新一条：回退到 a2
+    compareSummaries();
+    deleteMessages({ids.at(1)}); // 最后一条：摘要清空
+    compareSummaries();
+}
+
+void ConversationSummarizerTest::batchedDeletes()
+{
+    const QList<qint64> ids = insertMessages({{kConversationA, "a1", utc(2024, 1, 1)},
+                                              {kConversationA, "a2", utc(2024, 1, 2)},
+                                              {kConversationB, "b1", utc(2024, 1, 2)},
+                                              {kConversationA, "a3", utc(2024, 1, 3)},
+                                              {kConversationB, "b2", utc(2024, 1, 4)}});
+    deleteMessages({ids.at(3), ids.at(1), ids.at(2)});
+    compareSummaries();
+}
+
+void ConversationSummarizerTest::insertThenDeleteInOneTransaction()
+{
+    const QList<qint64> ids = insertMessages({{kConversationA, "a1", utc(2024, 1, 1)},
+                                              {kConversationA, "a2", utc(2024, 1, 2)}});
+
+    // 同一事务内先插入更新的消息，再删除更早的消息：摘要保持为新插入的一条
+    const QString table = m_router->tableForWrite(utc(2024, 1, 3));
+    QVERIFY(m_db->transaction());
+    QSqlQuery query(*m_db);
+    query.prepare(QString("INSERT INTO %1 (message_id, conversation_id, sender_id, consignee_id, type, content, msg_time) "
+                          "VALUES (?, ?, ?, ?, 0, 'a3', ?)").arg(table));
+    query.addBindValue(ids.last() + 1);
+    query.addBindValue(kConversationA);
+    query.addBindValue(kSender);
+    query.addBindValue(kConsignee);
+    query.addBindValue(utc(2024, 1, 3));
+    QVERIFY(query.exec());
+    m_summarizer->recordInsert(kConversationA, "a3", utc(2024, 1, 3));
+    query.prepare(QString("DELETE FROM %1 WHERE message_id = ?").arg(table));
+    query.addBindValue(ids.at(1));
+    QVERIFY(query.exec());
+    m_summarizer->recordDelete(kConversationA, utc(2024, 1, 2));
+    QVERIFY(m_summarizer->flush());
+    QVERIFY(m_db->commit());
+
+    exec(m_reference, QString("INSERT INTO messages (message_id, conversation_id, sender_id, consignee_id, type, content, msg_time) "
+                              "VALUES (%1, %2, %3, %4, 0, 'a3', %5)")
+                          .arg(ids.last() + 1).arg(kConversationA).arg(kSender).arg(kConsignee).arg(utc(2024, 1, 3)));
+    exec(m_reference, QString("DELETE FROM messages WHERE message_id = %1").arg(ids.at(1)));
+    compareSummaries();
+}
+
+void ConversationSummarizerTest::clearConversation()
+{
+    insertMessages({{kConversationA, "a1", utc(2024, 1, 1)},
+                    {kConversationB, "b1", utc(2024, 1, 2)},
+                    {kConversationA, "a2", utc(2024, 1, 3)}});
+    clearConversationMessages(kConversationA);
+    compareSummaries();
+
+    insertMessages({{kConversationA, "a3", utc(2024, 1, 4)}});
+    compareSummaries();
+}
+
+void ConversationSummarizerTest::acrossShards()
+{
+    MessageShardRouter::setEnabled(true);
+
+    const QList<qint64> ids = insertMessages({{kConversationA, "jan", utc(2024, 1, 20)},
+                                              {kConversationA, "feb", utc(2024, 2, 10)},
+                                              {kConversationB, "b-feb", utc(2024, 2, 11)},
+                                              {kConversationA, "mar", utc(2024, 3, 5)}});
+    compareSummaries();
+
+    // 分片之间ID不重复
+    QCOMPARE(QSet<qint64>(ids.cbegin(), ids.cend()).size(), ids.size());
+
+    // 删除最新分片中的最后一条，摘要回退到上一个分片中的消息
+    deleteMessages({ids.at(3)});
+    compareSummaries();
+    deleteMessages({ids.at(1)});
+    compareSummaries();
+
+    // 新消息写入更早的月份（离线补收）：与原触发器一样直接成为摘要
+    insertMessages({{kConversationA, "dec", utc(2023, 12, 31)}});
+    compareSummaries();
+    deleteMessages({ids.at(0)});
+    compareSummaries();
+}
+
+void ConversationSummarizerTest::clearAcrossShards()
+{
+    MessageShardRouter::setEnabled(true);
+
+    insertMessages({{kConversationA, "jan", utc(2024, 1, 20)},
+                    {kConversationB, "b-jan", utc(2024, 1, 21)},
+                    {kConversationA, "feb", utc(2024, 2, 10)},
+                    {kConversationB, "b-mar", utc(2024, 3, 1)}});
+    clearConversationMessages(kConversationB);
+    compareSummaries();
+    clearConversationMessages(kConversationA);
+    compareSummaries();
+}
+
+QTEST_GUILESS_MAIN(ConversationSummarizerTest)
+#include "ConversationSummarizerTest.moc"
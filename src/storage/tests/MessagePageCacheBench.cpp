@@ -0,0 +1,209 @@
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTemporaryDir>
+#include <QFile>
+#include "DatabaseSchema.h"
+#include "NativeSqlite.h"
+
+/**
+ * @brief 会话分页索引的页读取对照（手动运行的基准，不注册到 ctest）
+ *
+ * 同一份消息数据分别建两种会话分页索引：
+ *  - 原索引：idx_messages_conversation_page，带 content 的覆盖索引；
+ *  - 现索引：idx_messages_conversation_keys，只含定位与过滤用的窄列，content 与媒体列按 rowid 回表。
+ * 每次读取前重新打开连接（页缓存为空），读一页 getMessages 的联表查询，输出页缓存命中/未命中次数与库文件页数。
+ * 页缓存计数通过原生 sqlite3 句柄读取，原生路径不可用的构建跳过。
+ */
+class MessagePageCacheBench : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void pageReads_data();
+    void pageReads();
+
+private:
+    void exec(QSqlDatabase &db, const QString &sql);
+    void populate(const QString &path);
+    // 清零页缓存计数后读一页，返回这一页的命中/未命中次数
+    void measurePage(QSqlDatabase &db, NativeStatementCache *native, int offset,
+                     int *pageCount, int *hits, int *misses, int *rows);
+
+    QTemporaryDir m_dir;
+};
+
+namespace {
+constexpr int kConversations = 50;
+constexpr int kMessagesPerConversation = 2000;
+constexpr int kPageSize = 50;
+constexpr qint64 kFirstSender = 1000;
+constexpr qint64 kStartTime = 1704067200; // 2024-01-01 00:00:00 UTC
+
+const char *kContentIndex =
+    "CREATE INDEX idx_messages_conversation_page ON messages(conversation_id, msg_time, message_id, "
+    "sender_id, consignee_id, type, content)";
+const char *kKeysIndex =
+    "CREATE INDEX idx_messages_conversation_keys ON messages(conversation_id, msg_time, message_id, "
+    "sender_id, consignee_id, type)";
+
+// 与 MessageTable::getMessages 的联表分页查询一致（见 MessageTable.cpp 中的 joinedSelectSql / kJoinedColumns）
+const char *kPageSql = R"(
+    SELECT m.message_id, m.conversation_id, m.sender_id, m.consignee_id, m.type, m.content, m.msg_time,
+           CASE WHEN c.user_id IS NOT NULL THEN c.remark_name ELSE u.nickname END AS senderName,
+           u.avatar_local_path AS avatar,
+           m.file_path, m.file_url, m.file_size, m.duration, m.thumbnail_path
+    FROM messages m
+    INNER JOIN users u ON m.sender_id = u.user_id
+    LEFT JOIN contacts c ON m.sender_id = c.user_id
+    WHERE m.conversation_id = ?
+    ORDER BY m.msg_time DESC
+    LIMIT ? OFFSET ?
+)";
+}
+
+void MessagePageCacheBench::exec(QSqlDatabase &db, const QString &sql)
+{
+    QSqlQuery query(db);
+    QVERIFY2(query.exec(sql), qPrintable(query.lastError().text() + "\n" + sql));
+}
+
+void MessagePageCacheBench::populate(const QString &path)
+{
+    QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "populate");
+    db.setDatabaseName(path);
+    QVERIFY2(db.open(), qPrintable(db.lastError().text()));
+    exec(db, DatabaseSchema::getCreateTableUser());
+    exec(db, DatabaseSchema::getCreateTableContacts());
+    exec(db, DatabaseSchema::getCreateTableConversations());
+    exec(db, DatabaseSchema::getCreateTableMessages());
+
+    QVERIFY(db.transaction());
+    QSqlQuery query(db);
+    for (int i = 0; i < kConversations; ++i) {
+        exec(db, QString("INSERT INTO users (user_id, account, nickname) VALUES (%1, 'u%1', 'user %1')")
+                     .arg(kFirstSender + i));
+        exec(db, QString("INSERT INTO conversations (conversation_id, user_id, type) VALUES (%1, %2, 0)")
+                     .arg(i + 1).arg(kFirstSender + i));
+    }
+
+    // 各会话的消息按时间交错写入，同一会话的行在表中分散，接近真实库的布局
+    query.prepare("INSERT INTO messages (conversation_id, sender_id, consignee_id, type, content, "
+                  "file_path, thumbnail_path, msg_time) VALUES (?, ?, ?, ?, ?, ?, ?, ?)");
+    qint64 msgTime = kStartTime;
+    for (int n = 0; n < kMessagesPerConversation; ++n) {
+        for (int i = 0; i < kConversations; ++i) {
+            const bool image = (n + i) % 10 == 0;
+            const QString content = image ? QStringLiteral("[图片]")
+                                          : QString("消息 %1 ").arg(n).repeated(1 + (n * 7 + i) % 40);
+            query.addBindValue(i + 1);
+            query.addBindValue(kFirstSender + i);
+            query.addBindValue(kFirstSender + (i + 1) % kConversations);
+            query.addBindValue(image ? 1 : 0);
+            query.addBindValue(content);
+            query.addBindValue(image ? QVariant(QString("/data/media/%1_%2.jpg").arg(i).arg(n)) : QVariant());
+            query.addBindValue(image ? QVariant(QString("/data/thumb/%1_%2.jpg").arg(i).arg(n)) : QVariant());
+            query.addBindValue(msgTime++);
+            QVERIFY2(query.exec(), qPrintable(query.lastError().text()));
+        }
+    }
+    QVERIFY(db.commit());
+    query.finish();
+    db.close();
+    db = QSqlDatabase();
+    QSqlDatabase::removeDatabase("populate");
+}
+
+void MessagePageCacheBench::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+
+    const QString base = m_dir.filePath("base.db");
+    populate(base);
+    if (QTest::currentTestFailed()) return;
+
+    const QList<QPair<QString, const char *>> variants = {{"content_index.db", kContentIndex},
+                                                           {"keys_index.db", kKeysIndex}};
+    for (const auto &variant : variants) {
+        const QString path = m_dir.filePath(variant.first);
+        QVERIFY(QFile::copy(base, path));
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "index");
+        db.setDatabaseName(path);
+        QVERIFY2(db.open(), qPrintable(db.lastError().text()));
+        exec(db, variant.second);
+        exec(db, "VACUUM");
+        db.close();
+        db = QSqlDatabase();
+        QSqlDatabase::removeDatabase("index");
+    }
+}
+
+void MessagePageCacheBench::pageReads_data()
+{
+    QTest::addColumn<QString>("file");
+    QTest::addColumn<int>("offset");
+
+    QTest::newRow("content index, newest page") << "content_index.db" << 0;
+    QTest::newRow("keys index, newest page") << "keys_index.db" << 0;
+    QTest::newRow("content index, deep page") << "content_index.db" << kMessagesPerConversation / 2;
+    QTest::newRow("keys index, deep page") << "keys_index.db" << kMessagesPerConversation / 2;
+}
+
+void MessagePageCacheBench::pageReads()
+{
+    QFETCH(QString, file);
+    QFETCH(int, offset);
+
+    // 每行新开连接：页缓存从空开始，未命中次数即这一页需要从文件读取的页数
+    auto db = QSharedPointer<QSqlDatabase>::create(QSqlDatabase::addDatabase("QSQLITE", "bench"));
+    db->setDatabaseName(m_dir.filePath(file));
+    QVERIFY2(db->open(), qPrintable(db->lastError().text()));
+
+    int pageCount = 0;
+    int hits = 0;
+    int misses = 0;
+    int rows = 0;
+    bool available = false;
+    {
+        // 语句缓存须在连接关闭前析构
+        NativeStatementCache native(db);
+        available = native.isAvailable();
+        if (available) measurePage(*db, &native, offset, &pageCount, &hits, &misses, &rows);
+    }
+    db->close();
+    db.reset();
+    QSqlDatabase::removeDatabase("bench");
+
+    if (!available) QSKIP("Native SQLite handle unavailable: page cache counters cannot be read");
+    QCOMPARE(rows, kPageSize);
+    qInfo().nospace() << QTest::currentDataTag() << ": " << rows << " rows, page cache hits " << hits
+                      << ", misses " << misses << " (database " << pageCount << " pages)";
+}
+
+void MessagePageCacheBench::measurePage(QSqlDatabase &db, NativeStatementCache *native, int offset,
+                                        int *pageCount, int *hits, int *misses, int *rows)
+{
+    QSqlQuery query(db);
+    QVERIFY(query.exec("PRAGMA page_count") && query.next());
+    *pageCount = query.value(0).toInt();
+    query.finish();
+
+    const qint64 conversationId = kConversations / 2;
+    native->takePageCacheStats(hits, misses);
+    query.setForwardOnly(true);
+    query.prepare(kPageSql);
+    query.addBindValue(conversationId);
+    query.addBindValue(kPageSize);
+    query.addBindValue(offset);
+    QVERIFY2(query.exec(), qPrintable(query.lastError().text()));
+    while (query.next()) {
+        for (int column = 0; column < 14; ++column) query.value(column);
+        ++*rows;
+    }
+    query.finish();
+    native->takePageCacheStats(hits, misses);
+}
+
+QTEST_GUILESS_MAIN(MessagePageCacheBench)
+#include "MessagePageCacheBench.moc"
@@ -0,0 +1,269 @@
+#include <QtTest>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QTemporaryDir>
+#include "DatabaseSchema.h"
+#include "NativeSqlite.h"
+#include "models/Message.h"
+
+/**
+ * @brief 消息读写的 QtSql 与原生 sqlite3 路径对照（手动运行的基准，不注册到 ctest）
+ *
+ * 同一连接上分别用 QSqlQuery 与 NativeStatement 执行 MessageTable 的两条热点语句：
+ *  - getMessages：一页联表查询，逐行转换为 Message；
+ *  - saveMessage：一条消息的插入，单独一个事务。
+ * 耗时由 QBENCHMARK 报告（可用 -iterations / -minimumvalue 等 Qt Test 参数调整）。
+ * 原生路径不可用的构建（未链接 SQLite3，或 Qt 驱动使用自带的 SQLite）跳过 native 行。
+ */
+class MessageReadBench : public QObject {
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void cleanupTestCase();
+
+    void getMessagesPage_data();
+    void getMessagesPage();
+    void saveMessage_data();
+    void saveMessage();
+
+private:
+    void exec(const QString &sql);
+    void populate();
+
+    QTemporaryDir m_dir;
+    QSharedPointer<QSqlDatabase> m_db;
+    QScopedPointer<NativeStatementCache> m_native;
+};
+
+namespace {
+constexpr int kConversations = 20;
+constexpr int kMessagesPerConversation = 2000;
+constexpr int kPageSize = 50;
+constexpr qint64 kFirstSender = 1000;
+constexpr qint64 kStartTime = 1704067200; // 2024-01-01 00:00:00 UTC
+
+// 与 MessageTable::getMessages 的联表分页查询一致（见 MessageTable.cpp 中的 joinedSelectSql / kJoinedColumns）
+const char *kPageSql = R"(
+    SELECT m.message_id, m.conversation_id, m.sender_id, m.consignee_id, m.type, m.content, m.msg_time,
+           CASE WHEN c.user_id IS NOT NULL THEN c.remark_name ELSE u.nickname END AS senderName,
+           u.avatar_local_path AS avatar,
+           m.file_path, m.file_url, m.file_size, m.duration, m.thumbnail_path
+    FROM messages m
+    INNER JOIN users u ON m.sender_id = u.user_id
+    LEFT JOIN contacts c ON m.sender_id = c.user_id
+    WHERE m.conversation_id = ?
+    ORDER BY m.msg_time DESC
+    LIMIT ? OFFSET ?
+)";
+
+// 与 MessageTable::saveMessage 的插入语句一致
+const char *kInsertSql =
+    "INSERT INTO messages (message_id, conversation_id, sender_id, consignee_id, type, content, "
+    "file_path, file_url, file_size, duration, thumbnail_path, msg_time) "
+    "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?)";
+}
+
+void MessageReadBench::exec(const QString &sql)
+{
+    QSqlQuery query(*m_db);
+    QVERIFY2(query.exec(sql), qPrintable(query.lastError().text() + "\n" + sql));
+}
+
+void MessageReadBench::populate()
+{
+    exec(DatabaseSchema::getCreateTableUser());
+    exec(DatabaseSchema::getCreateTableContacts());
+    exec(DatabaseSchema::getCreateTableConversations());
+    exec(DatabaseSchema::getCreateTableMessages());
+    exec("CREATE INDEX idx_messages_conversation_keys ON messages(conversation_id, msg_time, message_id, "
+         "sender_id, consignee_id, type)");
+
+    QVERIFY(m_db->transaction());
+    for (int i = 0; i < kConversations; ++i) {
+        exec(QString("INSERT INTO users (user_id, account, nickname) VALUES (%1, 'u%1', 'user %1')")
+                 .arg(kFirstSender + i));
+        exec(QString("INSERT INTO conversations (conversation_id, user_id, type) VALUES (%1, %2, 0)")
+                 .arg(i + 1).arg(kFirstSender + i));
+    }
+
+    QSqlQuery insert(*m_db);
+    insert.prepare("INSERT INTO messages (conversation_id, sender_id, consignee_id, type, content, msg_time) "
+                   "VALUES (?, ?, ?, 0, ?, ?)");
+    qint64 msgTime = kStartTime;
+    for (int n = 0; n < kMessagesPerConversation; ++n) {
+        for (int i = 0; i < kConversations; ++i) {
+            insert.addBindValue(i + 1);
+            insert.addBindValue(kFirstSender + i);
+            insert.addBindValue(kFirstSender + (i + 1) % kConversations);
+            insert.addBindValue(QString("消息 %1 ").arg(n).repeated(1 + (n * 7 + i) % 20));
+            insert.addBindValue(msgTime++);
+            QVERIFY2(insert.exec(), qPrintable(insert.lastError().text()));
+        }
+    }
+    insert.finish();
+    QVERIFY(m_db->commit());
+}
+
+void MessageReadBench::initTestCase()
+{
+    QVERIFY(m_dir.isValid());
+    m_db = QSharedPointer<QSqlDatabase>::create(QSqlDatabase::addDatabase("QSQLITE", "bench"));
+    m_db->setDatabaseName(m_dir.filePath("bench.db"));
+    QVERIFY2(m_db->open(), qPrintable(m_db->lastError().text()));
+    populate();
+    m_native.reset(new NativeStatementCache(m_db));
+}
+
+void MessageReadBench::cleanupTestCase()
+{
+    // 语句缓存须在连接关闭前析构
+    m_native.reset();
+    if (m_db) {
+        m_db->close();
+        m_db.reset();
+    }
+    QSqlDatabase::removeDatabase("bench");
+}
+
+void MessageReadBench::getMessagesPage_data()
+{
+    QTest::addColumn<bool>("native");
+    QTest::newRow("QtSql") << false;
+    QTest::newRow("native") << true;
+}
+
+void MessageReadBench::getMessagesPage()
+{
+    QFETCH(bool, native);
+    if (native && !m_native->isAvailable()) QSKIP("Native SQLite fast path unavailable in this build");
+
+    const qint64 conversationId = kConversations / 2;
+    QVector<Message> messages;
+    messages.reserve(kPageSize);
+
+    QBENCHMARK {
+        messages.clear();
+        if (native) {
+            NativeStatement stmt = m_native->prepare(kPageSql);
+            QVERIFY(stmt);
+            stmt.bindInt64(1, conversationId);
+            stmt.bindInt64(2, kPageSize);
+            stmt.bindInt64(3, 0);
+            while (stmt.next()) {
+                Message message;
+                message.messageId = stmt.int64At(0);
+                message.conversationId = stmt.int64At(1);
+                message.senderId = stmt.int64At(2);
+                message.consigneeId = stmt.int64At(3);
+                message.type = static_cast<MessageType>(stmt.intAt(4));
+                message.content = stmt.textAt(5);
+                message.timestamp = stmt.int64At(6);
+                message.senderName = stmt.textAt(7);
+                message.avatar = stmt.textAt(8);
+                message.filePath = stmt.textAt(9);
+                message.fileUrl = stmt.textAt(10);
+                message.fileSize = stmt.int64At(11);
+                message.duration = stmt.intAt(12);
+                message.thumbnailPath = stmt.textAt(13);
+                messages.append(message);
+            }
+            QVERIFY2(!stmt.hasError(), qPrintable(stmt.errorString()));
+        } else {
+            QSqlQuery query(*m_db);
+            query.setForwardOnly(true);
+            query.prepare(kPageSql);
+            query.addBindValue(conversationId);
+            query.addBindValue(kPageSize);
+            query.addBindValue(0);
+            QVERIFY2(query.exec(), qPrintable(query.lastError().text()));
+            while (query.next()) {
+                Message message;
+                message.messageId = query.value(0).toLongLong();
+                message.conversationId = query.value(1).toLongLong();
+                message.senderId = query.value(2).toLongLong();
+                message.consigneeId = query.value(3).toLongLong();
+                message.type = static_cast<MessageType>(query.value(4).toInt());
+                message.content = query.value(5).toString();
+                message.timestamp = query.value(6).toLongLong();
+                message.senderName = query.value(7).toString();
+                message.avatar = query.value(8).toString();
+                message.filePath = query.value(9).toString();
+                message.fileUrl = query.value(10).toString();
+                message.fileSize = query.value(11).toLongLong();
+                message.duration = query.value(12).toInt();
+                message.thumbnailPath = query.value(13).toString();
+                messages.append(message);
+            }
+        }
+    }
+    QCOMPARE(messages.size(), kPageSize);
+}
+
+void MessageReadBench::saveMessage_data()
+{
+    QTest::addColumn<bool>("native");
+    QTest::newRow("QtSql") << false;
+    QTest::newRow("native") << true;
+}
+
+void MessageReadBench::saveMessage()
+{
+    QFETCH(bool, native);
+    if (native && !m_native->isAvailable()) QSKIP("Native SQLite fast path unavailable in this build");
+
+    Message message;
+    message.conversationId = 1;
+    message.senderId = kFirstSender;
+    message.consigneeId = kFirstSender + 1;
+    message.type = MessageType::TEXT;
+    message.content = QStringLiteral("基准消息");
+    qint64 msgTime = kStartTime + qint64(kConversations) * kMessagesPerConversation;
+
+    // 与 saveMessage 一样每条消息一个事务
+    QBENCHMARK {
+        message.timestamp = msgTime++;
+        QVERIFY(m_db->transaction());
+        if (native) {
+            NativeStatement insert = m_native->prepare(kInsertSql);
+            QVERIFY(insert);
+            insert.bindNull(1);
+            insert.bindInt64(2, message.conversationId);
+            insert.bindInt64(3, message.senderId);
+            insert.bindInt64(4, message.consigneeId);
+            insert.bindInt64(5, static_cast<int>(message.type));
+            insert.bindText(6, message.content);
+            insert.bindText(7, message.filePath);
+            insert.bindText(8, message.fileUrl);
+            insert.bindInt64(9, message.fileSize);
+            insert.bindInt64(10, message.duration);
+            insert.bindText(11, message.thumbnailPath);
+            insert.bindInt64(12, message.timestamp);
+            QVERIFY2(insert.exec(), qPrintable(insert.errorString()));
+            message.messageId = m_native->lastInsertId();
+        } else {
+            QSqlQuery query(*m_db);
+            query.prepare(kInsertSql);
+            query.addBindValue(QVariant());
+            query.addBindValue(message.conversationId);
+            query.addBindValue(message.senderId);
+            query.addBindValue(message.consigneeId);
+            query.addBindValue(static_cast<int>(message.type));
+            query.addBindValue(message.content);
+            query.addBindValue(message.filePath);
+            query.addBindValue(message.fileUrl);
+            query.addBindValue(message.fileSize);
+            query.addBindValue(message.duration);
+            query.addBindValue(message.thumbnailPath);
+            query.addBindValue(message.timestamp);
+            QVERIFY2(query.exec(), qPrintable(query.lastError().text()));
+            message.messageId = query.lastInsertId().toLongLong();
+        }
+        QVERIFY(m_db->commit());
+    }
+    QVERIFY(message.messageId > 0);
+}
+
+QTEST_GUILESS_MAIN(MessageReadBench)
+#include "MessageReadBench.moc"
@@ -6,6 +6,10 @@
 #include <QMouseEvent>
 #include "ThumbnailResourceManager.h"
 #include "Message.h"
+#include "MessageRenderRecord.h"
+
+class TextLayoutCache;
+class ModelUpdateScheduler;
 
 
 class ChatMessageDelegate : public QStyledItemDelegate
@@ -38,36 +42,58 @@ private slots:
 
 
 private:
-    // 不同类型消息的绘制方法
+    // 由视图字体派生的各处字体，视图字体不变时复用
+    struct Fonts {
+        QFont base;          // 派生时的 option.font
+        QFont content;       // 文本消息
+        QFont time;
+        int timeHeight = 0;
+        QFont fileName;
+        int fileNameHeight = 0;
+        QFont fileSize;
+        QFont source;        // 文件气泡底部来源标识
+        QFont warning;       // 文件已过期提示
+        QFont videoDuration;
+        QFont voiceDuration;
+        QFont initial;       // 默认头像首字母
+        QFont iconLarge;     // 文件图标类型文字（1~2 个字符）
+        int iconLargeHeight = 0;
+        QFont iconSmall;     // 文件图标类型文字（3 个字符）
+        int iconSmallHeight = 0;
+    };
+
+    // 不同类型消息的绘制方法（记录来自模型的 RenderRecordRole，绘制时不复制消息）
     void paintTextMessage(QPainter *painter, const QStyleOptionViewItem &option,
-                          const Message &message, bool isOwn) const;
+                          const MessageRenderRecord &message) const;
     void paintImageMessage(QPainter *painter, const QStyleOptionViewItem &option,
-                           const Message &message, bool isOwn) const;
+                           const MessageRenderRecord &message) const;
     void paintVideoMessage(QPainter *painter, const QStyleOptionViewItem &option,
-                           const Message &message, bool isOwn) const;
+                           const MessageRenderRecord &message) const;
     void paintFileMessage(QPainter *painter, const QStyleOptionViewItem &option,
-                          const Message &message, bool isOwn) const;
+                          const MessageRenderRecord &message) const;
     void paintVoiceMessage(QPainter *painter, const QStyleOptionViewItem &option,
-                           const Message &message, bool isOwn) const;
+                           const MessageRenderRecord &message) const;
 
     // 辅助绘制方法
-    void paintAvatar(QPainter *painter, const QRect &avatarRect,
-                     const Message &message) const;
+    void paintAvatar(QPainter *painter, const QRect &avatarRect, const QStyleOptionViewItem &option,
+                     const MessageRenderRecord &message) const;
     void paintTime(QPainter *painter, const QRect &rect, const QStyleOptionViewItem &option,
-                   const Message &message, bool isOwnMessage) const;
+                   const QString &timeText, bool isOwnMessage) const;
     void paintFileIcon(QPainter *painter, const QRect &fileRect,
-                       const QString &extension) const;
+                       const QString &extension, const Fonts &fonts) const;
     void paintPlayButtonAndWaveform(QPainter *painter, const QRect &bubbleRect,
                                     bool isOwnMessage) const;
     void paintVoiceWaveform(QPainter *painter, const QRect &rect,
                             bool isOwnMessage) const;
     void paintDurationText(QPainter *painter, const QRect &bubbleRect,
-                           int duration, bool isOwnMessage) const;
+                           const QString &durationStr, const QFont &font, bool isOwnMessage) const;
 
     // 工具方法
-    QSize calculateTextSize(const QString &text, const QFont &font, int maxWidth) const;
-    QRect getClickableRect(const QStyleOptionViewItem &option, const Message &message,
-                           const bool &isOwn) const;
+    const Fonts &fontsFor(const QStyleOptionViewItem &option) const;
+    // 文本最大宽度与排版结果（排版从缓存取）
+    int maxTextWidth(const QStyleOptionViewItem &option) const;
+    QSize textSize(const QStyleOptionViewItem &option, const MessageRenderRecord &message) const;
+    QRect getClickableRect(const QStyleOptionViewItem &option, const MessageRenderRecord &message) const;
     bool handleLeftClick(QMouseEvent *mouseEvent, const QStyleOptionViewItem &option,
                          const QModelIndex &index);
 
@@ -88,6 +114,10 @@ private:
     static const int ICON_HEIGHT = 40;
 
     ThumbnailResourceManager *thumbnailManager;
+    TextLayoutCache *textLayouts;
+    ModelUpdateScheduler *modelUpdates; // 缩略图加载完成后的刷新按帧合并
+    mutable Fonts m_fonts;
+    mutable bool m_fontsValid = false;
 };
 
 #endif // CHATMESSAGEDELEGATE_H
@@ -0,0 +1,70 @@
+#ifndef TEXTLAYOUTCACHE_H
+#define TEXTLAYOUTCACHE_H
+
+#include <QObject>
+#include <QCache>
+#include <QFont>
+#include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QTextLayout>
+#include <QThreadPool>
+
+/**
+ * @class TextLayoutCache
+ * @brief 文本消息气泡的排版缓存（按消息ID与宽度档位）
+ *
+ * 排版结果（已断行的 QTextLayout 与文本尺寸）按消息ID缓存，记录排版时的宽度档位。
+ * sizeHint、绘制与点击判定都从缓存取，只有首次出现的消息在界面线程同步排版。
+ * 宽度档位变化（视图缩放）后，旧档位的结果先作为临时结果返回，整批在工作线程按新档位重排，
+ * 完成后替换并发出 layoutsReady，由视图重新布局。
+ */
+class TextLayoutCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct TextLayout {
+        QSharedPointer<QTextLayout> layout; // 只在界面线程绘制
+        QSize size;                         // 文本占用尺寸（不含气泡内边距）
+    };
+
+    explicit TextLayoutCache(QObject *parent = nullptr);
+    ~TextLayoutCache() override;
+
+    // 字体变化时清空缓存
+    void setFont(const QFont &font);
+    // 取消息文本在 maxWidth 下的排版；messageId <= 0（尚未入库）时不缓存
+    TextLayout layoutFor(qint64 messageId, const QString &text, int maxWidth);
+
+    static constexpr int kWidthBucket = 16;  // 宽度档位（像素），档位内的宽度共用一份排版
+    static constexpr int kMaxEntries = 4000; // 缓存条数上限
+
+signals:
+    // 工作线程的重排结果已替换临时结果
+    void layoutsReady();
+
+private:
+    struct Entry {
+        QString text;
+        int width = 0; // 排版时的宽度档位
+        TextLayout layout;
+    };
+
+    static int bucketWidth(int maxWidth);
+    static TextLayout build(const QString &text, const QFont &font, int width);
+
+    void schedule(qint64 messageId, const QString &text);
+    void flushQueue();
+
+    QFont m_font;
+    int m_width = 0;                  // 当前宽度档位
+    QCache<qint64, Entry> m_cache;
+    QHash<qint64, QString> m_queued;  // 等待提交给工作线程的消息
+    QSet<qint64> m_inFlight;          // 已提交、尚未返回的消息
+    quint64 m_generation = 0;         // 字体或宽度变化后递增，丢弃过期的重排结果
+    bool m_flushScheduled = false;
+    QThreadPool m_pool;
+};
+
+#endif // TEXTLAYOUTCACHE_H
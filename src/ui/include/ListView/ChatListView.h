@@ -30,12 +30,19 @@ signals:
     void conversationToggleMute(qint64 conversationId);
     void conversationOpenInWindow(qint64 conversationId);
     void conversationDelete(qint64 conversationId);
+    void conversationExport(qint64 conversationId);
 
     // 选中会话
     void conversationChanged(const Conversation &conversation);
 
+    // 鼠标悬停或键盘选择时，提前预取可能打开的会话消息
+    void conversationPrefetchRequested(qint64 conversationId);
+
 protected:
     void contextMenuEvent(QContextMenuEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void leaveEvent(QEvent *event) override;
+    void currentChanged(const QModelIndex &current, const QModelIndex &previous) override;
 
 
 
@@ -44,6 +51,7 @@ private:
     void createConversationContextMenu();
     void showDeleteConfirmationDialog();
     Conversation getConversationFromIndex(const QModelIndex &index)const;
+    void requestPrefetch(const QModelIndex &index);
 
     // 会话列表菜单
     QMenu *m_conversationMenu;
@@ -51,9 +59,15 @@ private:
     QAction *m_markAsUnreadAction;
     QAction *m_toggleMuteAction;
     QAction *m_openInWindowAction;
+    QAction *m_exportAction;
     QAction *m_deleteAction;
 
     qint64 m_currentConversationId;
+
+    // 悬停预取：停留一小段时间后才发出，避免划过列表时频繁查询
+    QTimer *m_hoverPrefetchTimer;
+    QPersistentModelIndex m_hoverIndex;
+    static constexpr int kHoverPrefetchDelayMs = 150;
 };
 
 #endif //CUSTOMLISTVIEW_H
@@ -9,6 +9,7 @@
 #include <QMenu>
 #include <QAction>
 #include "Message.h"
+#include "MessageDaySummary.h"
 #include "CustomListView.h"
 
 class ChatMessageListView: public CustomListView
@@ -23,6 +24,9 @@ public:
     // 显示消息列表菜单
     void execMessageListMenu(const QPoint& globalPos, const Message &message);
 
+    // 设置右侧时间轴（按天消息密度），点击时间轴跳转到对应日期
+    void setTimeline(const QList<MessageDaySummary> &summaries);
+
 signals:
 
     // 消息列表菜单信号
@@ -39,11 +43,37 @@ signals:
 
     // 鼠标滚动加载更多消息
     void loadmoreMsg(int count);
+    // 窗口不含最新消息时，向下滚动到底部附近加载更新的消息
+    void loadNewerMsg(int count);
+
+    // 点击时间轴请求跳转到日期
+    void jumpToDateRequested(const QDate &date);
+
+    // 可见行范围变化（滚动、布局变化后），模型据此决定窗口超出上限时淘汰哪一端；无可见行时为 -1
+    void visibleRowsChanged(int first, int last);
 
 protected:
     void wheelEvent(QWheelEvent *event)override;
+    void paintEvent(QPaintEvent *event)override;
+    void mousePressEvent(QMouseEvent *event)override;
+
+public:
+    void setModel(QAbstractItemModel *model)override;
 
 private:
+    // 首个可见行之上插入/删除行（加载更早的历史、淘汰窗口头部）时保持视口内容不动：
+    // 变更前记录首个可见消息及其位置，变更后按其新位置回调滚动条
+    void captureScrollAnchor(const QModelIndex &parent, int start, int end, bool removing);
+    void restoreScrollAnchor();
+
+    void reportVisibleRows();
+    int m_reportedFirst = -1;
+    int m_reportedLast = -1;
+
+    QPersistentModelIndex m_scrollAnchor;
+    int m_scrollAnchorTop = 0;
+    QList<QMetaObject::Connection> m_anchorConnections;
+
     void createMessageContextMenu();
     void showDeleteConfirmationDialog();
 
@@ -62,6 +92,12 @@ private:
 
     Message currentMsg;
 
+    // 时间轴
+    QRect timelineRect() const;
+    QList<MessageDaySummary> m_timeline;
+    int m_timelineTotal = 0;
+    int m_timelineMaxCount = 0;
+
 };
 
 #endif //CUSTOMLISTVIEW_H
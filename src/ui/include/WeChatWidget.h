@@ -21,6 +21,7 @@ class MoreDialog;
 class FloatingDialog;
 class CurrentUserInfoDialog;
 class MediaDialog;
+class QProgressDialog;
 class ChatMessageListView;
 class ChatListDelegate;
 class ChatMessageDelegate;
@@ -88,7 +89,7 @@ private slots:
 
     void on_recordVoiceButton_clicked();
 
-    bool on_switchtoMessageInterface(Contact contact);
+    bool on_switchtoMessageInterface(const Contact &contact);
 private:
     //自定义窗口相关
     bool m_isOnTop; // 记录当前是否置顶
@@ -107,6 +108,8 @@ private:
     void updateCursorShape(const QPoint &pos);
     void handleResize(const QPoint &currentGlobalPos);// 处理拉伸（参数为当前鼠标全局坐标）
     void handleDrag(const QPoint &currentGlobalPos);// 处理移动（参数为当前鼠标全局坐标）
+    void exportConversation(qint64 conversationId); // 选择导出位置并在后台导出会话
+    void importHistory(const QString &archivePath = QString()); // 导入聊天记录（路径为空时弹出文件选择）
 
 
     Ui::WeChatWidget *ui;
@@ -117,6 +120,8 @@ private:
     QPointer<FloatingDialog> floatingDialog;
     QPointer<CurrentUserInfoDialog> currentUserInfoDialog;
     QPointer<MediaDialog> mediaDialog;
+    QPointer<QProgressDialog> exportProgressDialog;
+    QPointer<QProgressDialog> importProgressDialog;
 
     UserInfoWidget *userInfoWidget;
 
@@ -15,6 +15,9 @@ public:
     explicit MoreDialog(QWidget *parent = nullptr);
     ~MoreDialog();
 
+signals:
+    void chatHistoryManageRequested(); // 聊天记录管理（导入聊天记录）
+
 private:
     Ui::MoreDialog *ui;
 };
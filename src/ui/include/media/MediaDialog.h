@@ -6,6 +6,7 @@
 #include <QGraphicsPixmapItem>
 #include <QStackedWidget>
 #include <QSplitter>
+#include "MediaItem.h"
 
 namespace Ui {
 class MediaDialog;
@@ -15,7 +16,6 @@ class VideoPlayer;
 class ThumbnailDelegate;
 class ThumbnailPreviewModel;
 class ThumbnailListView;
-struct MediaItem;
 class ThumbnailResourceManager;
 enum class MediaType;
 
@@ -35,6 +35,14 @@ public:
     void setMediaItems(const QList<MediaItem>& items);
     void selectMediaByMessageId(qint64 messageId);
 
+    // 窗口化加载：先加载以点击消息为中心的窗口，浏览到边缘附近时再向该侧扩展
+    void setMediaWindow(const QList<MediaItem>& items, bool hasOlder, bool hasNewer);
+    void extendMediaWindow(bool older, const QList<MediaItem>& items, bool hasMore);
+
+signals:
+    // 需要更早（older=true）或更新的媒体，edge 为当前窗口该侧边缘的媒体项
+    void moreMediaRequested(bool older, const MediaItem &edge);
+
 protected:
     void paintEvent(QPaintEvent *event) override;
     void mousePressEvent(QMouseEvent *event) override;
@@ -103,6 +111,13 @@ private:
 
     QString currentImgPath;
 
+    // 媒体窗口状态
+    bool m_hasOlderMedia = false;
+    bool m_hasNewerMedia = false;
+    bool m_loadingOlderMedia = false;
+    bool m_loadingNewerMedia = false;
+    void requestMoreMediaIfNeeded(int row);
+
 };
 
 #endif // MEDIADIALOG_H
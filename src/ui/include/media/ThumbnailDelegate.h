@@ -5,6 +5,8 @@
 #include <QSize>
 #include "ThumbnailResourceManager.h"
 
+class ModelUpdateScheduler;
+
 class ThumbnailDelegate : public QStyledItemDelegate
 {
     Q_OBJECT
@@ -34,6 +36,7 @@ private:
     int m_cornerRadius;            // 圆角半径
     int m_videoIndicatorSize;      // 视频指示器大小
     ThumbnailResourceManager *mediaManager;
+    ModelUpdateScheduler *modelUpdates; // 缩略图加载完成后的刷新按帧合并
 
 };
 
@@ -34,6 +34,10 @@ public:
     void addMediaItem(const MediaItem& item);
     void clearAllMediaItems();
     void setMediaItems(const QList<MediaItem>& items);
+    // 窗口扩展：items 均按时间升序
+    void prependMediaItems(const QList<MediaItem>& items);
+    void appendMediaItems(const QList<MediaItem>& items);
+    MediaItem mediaItemAt(int row) const;
 
     QModelIndex indexFromMessageId(qint64 messageId) const;
     int rowFromMessageId(qint64 messageId) const;
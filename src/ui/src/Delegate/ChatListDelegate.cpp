@@ -77,9 +77,18 @@ void ChatListDelegate::paint(QPainter *painter, const QStyleOptionViewItem
     msgFont.setPointSizeF(8);
     msgFont.setFamily(QStringLiteral("微软雅黑"));
     painter->setFont(msgFont);
+    QRect lastMsgRect = msgRect;
+    // 有未读 @ 提及时在最后一条消息前加红色提示
+    if(index.data(UnreadMentionCountRole).toInt() > 0){
+        const QString mentionText = QStringLiteral("[有人@我]");
+        int mentionW = QFontMetrics(msgFont).horizontalAdvance(mentionText);
+        painter->setPen(QColor(249,81,81));
+        painter->drawText(lastMsgRect, Qt::AlignLeft|Qt::AlignVCenter, mentionText);
+        lastMsgRect.setLeft(lastMsgRect.left()+mentionW);
+    }
     painter->setPen(QColor(150,150,150));
-    QString elidedMsg = QFontMetrics(msgFont).elidedText(lastMsg, Qt::ElideRight, msgRect.width());
-    painter->drawText(msgRect, Qt::AlignLeft|Qt::AlignVCenter,elidedMsg);
+    QString elidedMsg = QFontMetrics(msgFont).elidedText(lastMsg, Qt::ElideRight, lastMsgRect.width());
+    painter->drawText(lastMsgRect, Qt::AlignLeft|Qt::AlignVCenter,elidedMsg);
 
     // 画-lastTime
     painter->setFont(timeFont);
@@ -1,13 +1,20 @@
 #include "ChatMessageDelegate.h"
-#include "FormatTime.h"
 #include <QFontMetrics>
-#include <QFileInfo>
-#include <QDateTime>
 #include <QDebug>
 #include <QPainterPath>
 #include <QAbstractItemView>
 #include "ChatMessagesModel.h"
 #include "ChatMessageListView.h"
+#include "TextLayoutCache.h"
+#include "ModelUpdateScheduler.h"
+
+namespace {
+// 模型内的绘制记录；指针只在当次调用内有效
+const MessageRenderRecord *renderRecord(const QModelIndex &index)
+{
+    return index.data(ChatMessagesModel::RenderRecordRole).value<const MessageRenderRecord *>();
+}
+}
 
 ChatMessageDelegate::ChatMessageDelegate(QObject *parent)
     : QStyledItemDelegate(parent)
@@ -15,6 +22,16 @@ ChatMessageDelegate::ChatMessageDelegate(QObject *parent)
     thumbnailManager = ThumbnailResourceManager::instance();
     connect(thumbnailManager, &ThumbnailResourceManager::mediaLoaded,
             this, &ChatMessageDelegate::onMediaLoaded);
+    modelUpdates = new ModelUpdateScheduler(nullptr, this);
+
+    // 缩放后工作线程重排完成，按新尺寸重新布局
+    textLayouts = new TextLayoutCache(this);
+    connect(textLayouts, &TextLayoutCache::layoutsReady, this, [this]() {
+        if (ChatMessageListView *view = qobject_cast<ChatMessageListView *>(parent())) {
+            if (QAbstractItemModel *model = view->model(); model && model->rowCount() > 0)
+                emit sizeHintChanged(model->index(0, 0));
+        }
+    });
 }
 
 void ChatMessageDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
@@ -32,25 +49,28 @@ void ChatMessageDelegate::paint(QPainter *painter, const QStyleOptionViewItem &o
         painter->fillRect(option.rect, selectedColor);
     }
 
-    Message message = index.data(ChatMessagesModel::FullMessageRole).value<Message>();
-    bool isOwn = index.data(ChatMessagesModel::IsOwnRole).toBool();
+    const MessageRenderRecord *record = renderRecord(index);
+    if (!record) {
+        painter->restore();
+        return;
+    }
 
     // 根据消息类型调用不同的绘制方法
-    switch (message.type) {
+    switch (record->type) {
     case MessageType::TEXT:
-        paintTextMessage(painter, option, message, isOwn);
+        paintTextMessage(painter, option, *record);
         break;
     case MessageType::IMAGE:
-        paintImageMessage(painter, option, message, isOwn);
+        paintImageMessage(painter, option, *record);
         break;
     case MessageType::VIDEO:
-        paintVideoMessage(painter, option, message, isOwn);
+        paintVideoMessage(painter, option, *record);
         break;
     case MessageType::FILE:
-        paintFileMessage(painter, option, message ,isOwn);
+        paintFileMessage(painter, option, *record);
         break;
     case MessageType::VOICE:
-        paintVoiceMessage(painter, option, message, isOwn);
+        paintVoiceMessage(painter, option, *record);
         break;
     }
 
@@ -62,28 +82,22 @@ QSize ChatMessageDelegate::sizeHint(const QStyleOptionViewItem &option,
 {
     if (!index.isValid()) return QSize(100, 30);
 
-    Message message = index.data(ChatMessagesModel::FullMessageRole).value<Message>();
+    const MessageRenderRecord *record = renderRecord(index);
+    if (!record) return QSize(100, 30);
+    const MessageRenderRecord &message = *record;
     int width = option.rect.width();
 
     const int margin = MARGIN;
     const int bubblePadding = BUBBLE_PADDING;
     const int avatarSize = AVATAR_SIZE;
 
-    // 计算时间戳高度
-    QFont timeFont = option.font;
-    timeFont.setPointSizeF(7.5);
-    QFontMetrics timeMetrics(timeFont);
-    int timeHeight = timeMetrics.height();
+    // 时间戳高度
+    const int timeHeight = fontsFor(option).timeHeight;
 
     switch (message.type) {
     case MessageType::TEXT: {
-        // 计算文本内容所需尺寸
-        int maxBubbleWidth = width * 0.6;
-        QFont font = option.font;
-        font.setPointSizeF(10.5);
-        font.setFamily(QStringLiteral("微软雅黑"));
-        QSize textSize = calculateTextSize(message.content, font, maxBubbleWidth - 2 * bubblePadding);
-        int bubbleHeight = textSize.height() + 2 * bubblePadding;
+        // 文本内容所需尺寸（排版缓存）
+        int bubbleHeight = textSize(option, message).height() + 2 * bubblePadding;
         int avatarAreaHeight = avatarSize + 2 * margin;
         int contentAreaHeight = bubbleHeight + timeHeight + 2 * margin;
         return QSize(width, qMax(avatarAreaHeight, contentAreaHeight));
@@ -124,11 +138,10 @@ bool ChatMessageDelegate::editorEvent(QEvent *event, QAbstractItemModel *model,
 
         // 只处理右键点击
         if (mouseEvent->button() == Qt::RightButton) {
-            Message message = index.data(ChatMessagesModel::FullMessageRole).value<Message>();
-            bool isOwn = index.data(ChatMessagesModel::IsOwnRole).toBool();
-
-            QRect clickableRect = getClickableRect(option, message, isOwn);
-            if (clickableRect.contains(mouseEvent->pos())) {
+            const MessageRenderRecord *record = renderRecord(index);
+            if (record && getClickableRect(option, *record).contains(mouseEvent->pos())) {
+                // 菜单需要完整消息，只在这里取一次
+                const Message message = index.data(ChatMessagesModel::FullMessageRole).value<Message>();
                 QPoint globalPos = option.widget->mapToGlobal(mouseEvent->pos());
                 emit rightClicked(globalPos, message);
                 return true;
@@ -144,10 +157,11 @@ bool ChatMessageDelegate::editorEvent(QEvent *event, QAbstractItemModel *model,
 
 bool ChatMessageDelegate::handleLeftClick(QMouseEvent *mouseEvent, const QStyleOptionViewItem &option, const QModelIndex &index)
 {
-    Message message = index.data(ChatMessagesModel::FullMessageRole).value<Message>();
-    bool isOwn = index.data(ChatMessagesModel::IsOwnRole).toBool();
+    const MessageRenderRecord *record = renderRecord(index);
+    if (!record) return false;
+    const MessageRenderRecord &message = *record;
 
-    QRect clickableRect = getClickableRect(option, message, isOwn);
+    QRect clickableRect = getClickableRect(option, message);
     if (!clickableRect.contains(mouseEvent->pos())) {
         return false;
     }
@@ -174,7 +188,7 @@ bool ChatMessageDelegate::handleLeftClick(QMouseEvent *mouseEvent, const QStyleO
 }
 
 void ChatMessageDelegate::paintTextMessage(QPainter *painter, const QStyleOptionViewItem &option,
-                                           const Message &message, bool isOwn) const
+                                           const MessageRenderRecord &message) const
 {
     painter->save();
     painter->setRenderHint(QPainter::Antialiasing, true);
@@ -185,7 +199,7 @@ void ChatMessageDelegate::paintTextMessage(QPainter *painter, const QStyleOption
     const int bubblePadding = BUBBLE_PADDING;
     const int maxBubbleWidth = option.rect.width() * 0.6;
     const int timeSpacing = TIME_SPACING;
-    bool isOwnMessage = isOwn; // 需要根据实际情况调整
+    bool isOwnMessage = message.isOwn;
 
     // 计算头像位置绘制头像
     QRect avatarRect;
@@ -198,18 +212,15 @@ void ChatMessageDelegate::paintTextMessage(QPainter *painter, const QStyleOption
                            option.rect.top() + margin,
                            avatarSize, avatarSize);
     }
-    paintAvatar(painter, avatarRect, message);
+    paintAvatar(painter, avatarRect, option, message);
 
-    // 计算文本尺寸
-    QFont contentFont = option.font;
-    contentFont.setPointSizeF(10.5);
-    contentFont.setFamily(QStringLiteral("微软雅黑"));
-    QFontMetrics contentMetrics(contentFont);
-    QRect textRect = contentMetrics.boundingRect(QRect(0, 0, maxBubbleWidth - 2 * bubblePadding, 10000),
-                                                 Qt::TextWordWrap, message.content);
+    // 取已断行的排版
+    textLayouts->setFont(fontsFor(option).content);
+    const TextLayoutCache::TextLayout text = textLayouts->layoutFor(message.messageId, message.content,
+                                                                    maxTextWidth(option));
     // 计算气泡尺寸
-    int bubbleWidth = qMin(textRect.width() + 2 * bubblePadding, maxBubbleWidth);
-    int bubbleHeight = textRect.height() + 2 * bubblePadding;
+    int bubbleWidth = qMin(text.size.width() + 2 * bubblePadding, maxBubbleWidth);
+    int bubbleHeight = text.size.height() + 2 * bubblePadding;
 
     // 计算气泡位置
     QRect bubbleRect;
@@ -249,19 +260,18 @@ void ChatMessageDelegate::paintTextMessage(QPainter *painter, const QStyleOption
 
     // 绘制消息内容
     painter->setPen(Qt::black);
-    painter->setFont(contentFont);
-    painter->drawText(contentRect, Qt::AlignLeft | Qt::TextWordWrap, message.content);
+    text.layout->draw(painter, contentRect.topLeft());
 
     // 绘制时间戳
     QRect timeRect(bubbleRect.left(), bubbleRect.bottom() + timeSpacing,
                    bubbleRect.width(), 0);
-    paintTime(painter, timeRect, option, message, isOwnMessage);
+    paintTime(painter, timeRect, option, message.timeText, isOwnMessage);
 
     painter->restore();
 }
 
 void ChatMessageDelegate::paintImageMessage(QPainter *painter, const QStyleOptionViewItem &option,
-                                            const Message &message, bool isOwn) const
+                                            const MessageRenderRecord &message) const
 {
     QPixmap  thumbnail = thumbnailManager->getThumbnail(message.filePath, QSize(200, 300),
                                         MediaType::ImageThumb,0, message.thumbnailPath);
@@ -271,7 +281,7 @@ void ChatMessageDelegate::paintImageMessage(QPainter *painter, const QStyleOptio
 
     int avatarSize = AVATAR_SIZE;
     const int margin = MARGIN;
-    bool isOwnMessage = isOwn;
+    bool isOwnMessage = message.isOwn;
 
     QRect avatarRect;
     if (isOwnMessage) {
@@ -283,7 +293,7 @@ void ChatMessageDelegate::paintImageMessage(QPainter *painter, const QStyleOptio
                            option.rect.top() + margin,
                            avatarSize, avatarSize);
     }
-    paintAvatar(painter, avatarRect, message);
+    paintAvatar(painter, avatarRect, option, message);
 
     // 绘制缩略图
     QRect imageRect;
@@ -301,13 +311,13 @@ void ChatMessageDelegate::paintImageMessage(QPainter *painter, const QStyleOptio
     // 时间
     QRect timeRect(imageRect.left(), imageRect.bottom() + margin,
                    imageRect.width(), 0);
-    paintTime(painter, timeRect, option, message, isOwnMessage);
+    paintTime(painter, timeRect, option, message.timeText, isOwnMessage);
 
     painter->restore();
 }
 
 void ChatMessageDelegate::paintVideoMessage(QPainter *painter, const QStyleOptionViewItem &option,
-                                            const Message &message,bool isOwn) const
+                                            const MessageRenderRecord &message) const
 {
     QPixmap thumbnail = thumbnailManager->getThumbnail(message.filePath, QSize(200, 300),
                                           MediaType::VideoThumb, 0 , message.thumbnailPath);
@@ -317,7 +327,7 @@ void ChatMessageDelegate::paintVideoMessage(QPainter *painter, const QStyleOptio
 
     const int margin = MARGIN;
     const int avatarSize = AVATAR_SIZE;
-    bool isOwnMessage = isOwn;
+    bool isOwnMessage = message.isOwn;
 
     QRect avatarRect;
     if (isOwnMessage) {
@@ -329,7 +339,7 @@ void ChatMessageDelegate::paintVideoMessage(QPainter *painter, const QStyleOptio
                            option.rect.top() + margin,
                            avatarSize, avatarSize);
     }
-    paintAvatar(painter, avatarRect, message);
+    paintAvatar(painter, avatarRect, option, message);
 
     QRect videoRect;
 
@@ -346,24 +356,21 @@ void ChatMessageDelegate::paintVideoMessage(QPainter *painter, const QStyleOptio
     if (message.duration > 0) {
         painter->setPen(Qt::white);
         painter->setBrush(QColor(200, 200, 200, 150));
-        QFont durationFont = option.font;
-        durationFont.setPointSize(8);
-        painter->setFont(durationFont);
-        QString durationText = message.formattedDuration();
+        painter->setFont(fontsFor(option).videoDuration);
         QRect durationRect(videoRect.left() + 10, videoRect.bottom() - 20,
                            videoRect.width() - 10, 15);
-        painter->drawText(durationRect, Qt::AlignLeft | Qt::AlignVCenter, durationText);
+        painter->drawText(durationRect, Qt::AlignLeft | Qt::AlignVCenter, message.durationText);
     }
 
     // 时间
     QRect timeRect(videoRect.left(), videoRect.bottom() + margin, videoRect.width(), 0);
-    paintTime(painter, timeRect, option, message, isOwnMessage);
+    paintTime(painter, timeRect, option, message.timeText, isOwnMessage);
 
     painter->restore();
 }
 
 void ChatMessageDelegate::paintFileMessage(QPainter *painter, const QStyleOptionViewItem &option,
-                                           const Message &message, bool isOwn) const
+                                           const MessageRenderRecord &message) const
 {
     painter->save();
     painter->setRenderHint(QPainter::Antialiasing, true);
@@ -377,7 +384,7 @@ void ChatMessageDelegate::paintFileMessage(QPainter *painter, const QStyleOption
     const int iconWidth = ICON_WIDTH;
     const int iconHeight = ICON_HEIGHT;
 
-    bool isOwnMessage = isOwn;
+    bool isOwnMessage = message.isOwn;
 
     // 计算头像位置
     QRect avatarRect;
@@ -390,7 +397,7 @@ void ChatMessageDelegate::paintFileMessage(QPainter *painter, const QStyleOption
                            option.rect.top() + margin,
                            avatarSize, avatarSize);
     }
-    paintAvatar(painter, avatarRect, message);
+    paintAvatar(painter, avatarRect, option, message);
 
     // 计算文件气泡位置
     QRect fileBubbleRect;
@@ -404,8 +411,7 @@ void ChatMessageDelegate::paintFileMessage(QPainter *painter, const QStyleOption
                                fileBubbleWidth, fileBubbleHeight);
     }
 
-    // 检查文件是否存在
-    bool fileExists = QFileInfo::exists(message.filePath);
+    const Fonts &fonts = fontsFor(option);
 
     // 绘制文件气泡背景
     painter->setPen(Qt::NoPen);
@@ -432,13 +438,7 @@ void ChatMessageDelegate::paintFileMessage(QPainter *painter, const QStyleOption
                    iconWidth, iconHeight);
 
     // 绘制文件类型图标
-    QFileInfo fileInfo(message.filePath);
-    QString fileName = fileInfo.fileName();
-    if (fileName.isEmpty()) {
-        fileName = message.content;
-    }
-    QString fileExtension = fileInfo.suffix().toLower();
-    paintFileIcon(painter, iconRect, fileExtension);
+    paintFileIcon(painter, iconRect, message.fileExtension, fonts);
 
     // 文本区域
     QRect textRect(fileBubbleRect.left() + bubblePadding,
@@ -448,35 +448,26 @@ void ChatMessageDelegate::paintFileMessage(QPainter *painter, const QStyleOption
 
     // 绘制文件名
     painter->setPen(Qt::black);
-    QFont fileNameFont = option.font;
-    fileNameFont.setPointSizeF(10.2);
-    fileNameFont.setFamily("微软雅黑");
-    painter->setFont(fileNameFont);
+    painter->setFont(fonts.fileName);
 
     // 文件名省略处理
-    QString displayName = fileName;
-    QFontMetrics nameMetrics(fileNameFont);
-    if (nameMetrics.horizontalAdvance(fileName) > textRect.width()) {
-        displayName = nameMetrics.elidedText(fileName, Qt::ElideRight, textRect.width());
+    QFontMetrics nameMetrics(fonts.fileName);
+    if (nameMetrics.horizontalAdvance(message.fileName) > textRect.width()) {
+        painter->drawText(textRect, Qt::AlignLeft | Qt::AlignTop,
+                          nameMetrics.elidedText(message.fileName, Qt::ElideRight, textRect.width()));
+    } else {
+        painter->drawText(textRect, Qt::AlignLeft | Qt::AlignTop, message.fileName);
     }
-    painter->drawText(textRect, Qt::AlignLeft | Qt::AlignTop, displayName);
 
     // 绘制文件大小
-    QString sizeStr = message.formattedFileSize();
-
-    QFont sizeFont = option.font;
-    sizeFont.setPointSizeF(9);
-    painter->setFont(sizeFont);
+    painter->setFont(fonts.fileSize);
     painter->setPen(QColor(150, 150, 150));
 
-    QRect sizeRect = textRect.adjusted(0, nameMetrics.height() + bubblePadding/2, 0, 0);
-    painter->drawText(sizeRect, Qt::AlignLeft | Qt::AlignTop, sizeStr);
+    QRect sizeRect = textRect.adjusted(0, fonts.fileNameHeight + bubblePadding/2, 0, 0);
+    painter->drawText(sizeRect, Qt::AlignLeft | Qt::AlignTop, message.fileSizeText);
 
     // 绘制底部横线和来源标识
-    QFont sourceFont = option.font;
-    sourceFont.setPointSizeF(8.5);
-    sourceFont.setFamily("微软雅黑");
-    painter->setFont(sourceFont);
+    painter->setFont(fonts.source);
     painter->setPen(QColor(200, 200, 200));
 
     // 横线
@@ -488,10 +479,10 @@ void ChatMessageDelegate::paintFileMessage(QPainter *painter, const QStyleOption
     painter->setPen(QColor(150, 150, 150));
     painter->drawText(QRect(textRect.left(), fileBubbleRect.bottom() - 20,
                             textRect.width(), 15),
-                      Qt::AlignLeft | Qt::AlignVCenter, "微信电脑版");
+                      Qt::AlignLeft | Qt::AlignVCenter, QStringLiteral("微信电脑版"));
 
     // 如果文件不存在，绘制暗色遮罩和提示文字
-    if (!fileExists) {
+    if (!message.fileExists) {
         painter->save();
 
         // 绘制暗色遮罩（半透明黑色）
@@ -499,22 +490,10 @@ void ChatMessageDelegate::paintFileMessage(QPainter *painter, const QStyleOption
         painter->setBrush(QColor(0, 0, 0, 128)); // 半透明黑色
         painter->drawRoundedRect(fileBubbleRect, 5, 5);
 
-        // 绘制提示文字
-        QFont warningFont = option.font;
-        warningFont.setPointSizeF(9);
-        warningFont.setFamily("微软雅黑");
-        warningFont.setBold(true);
-        painter->setFont(warningFont);
+        // 绘制提示文字（居中于气泡）
+        painter->setFont(fonts.warning);
         painter->setPen(Qt::white);
-
-        QString warningText = "文件已过期或删除";
-        QFontMetrics warningMetrics(warningFont);
-        int warningWidth = warningMetrics.horizontalAdvance(warningText);
-        QRect warningRect(fileBubbleRect.center().x() - warningWidth / 2,
-                          fileBubbleRect.center().y() - warningMetrics.height() / 2,
-                          warningWidth, warningMetrics.height());
-
-        painter->drawText(warningRect, Qt::AlignCenter, warningText);
+        painter->drawText(fileBubbleRect, Qt::AlignCenter, QStringLiteral("文件已过期或删除"));
 
         // 恢复 painter 状态
         painter->restore();
@@ -523,13 +502,13 @@ void ChatMessageDelegate::paintFileMessage(QPainter *painter, const QStyleOption
     // 绘制时间戳
     QRect timeRect = QRect(fileBubbleRect.left(), fileBubbleRect.bottom() + margin,
                            fileBubbleRect.width(), 0);
-    paintTime(painter, timeRect, option, message, isOwnMessage);
+    paintTime(painter, timeRect, option, message.timeText, isOwnMessage);
 
     painter->restore();
 }
 
 void ChatMessageDelegate::paintVoiceMessage(QPainter *painter, const QStyleOptionViewItem &option,
-                                            const Message &message, bool isOwn) const
+                                            const MessageRenderRecord &message) const
 {
     painter->save();
     painter->setRenderHint(QPainter::Antialiasing, true);
@@ -544,7 +523,7 @@ void ChatMessageDelegate::paintVoiceMessage(QPainter *painter, const QStyleOptio
     const int playButtonSize = PLAY_BUTTON_SIZE;
     const int waveformHeight = WAVEFORM_HEIGHT;
 
-    bool isOwnMessage = isOwn;
+    bool isOwnMessage = message.isOwn;
     int duration = message.duration; // 秒数
 
     // 计算头像位置
@@ -558,7 +537,7 @@ void ChatMessageDelegate::paintVoiceMessage(QPainter *painter, const QStyleOptio
                            option.rect.top() + margin,
                            avatarSize, avatarSize);
     }
-    paintAvatar(painter, avatarRect, message);
+    paintAvatar(painter, avatarRect, option, message);
 
     // 根据时长计算气泡宽度
     int voiceBubbleWidth = qMin(maxVoiceBubbleWidth,
@@ -602,24 +581,26 @@ void ChatMessageDelegate::paintVoiceMessage(QPainter *painter, const QStyleOptio
 
     // 绘制播放按钮和波形
     paintPlayButtonAndWaveform(painter, voiceBubbleRect, isOwnMessage);
-    paintDurationText(painter, voiceBubbleRect, duration, isOwnMessage);
+    paintDurationText(painter, voiceBubbleRect, message.durationText, fontsFor(option).voiceDuration,
+                      isOwnMessage);
 
     // 绘制时间戳
     QRect timeRect = QRect(voiceBubbleRect.left(), voiceBubbleRect.bottom() + margin,
                            voiceBubbleRect.width(), 0);
-    paintTime(painter, timeRect, option, message, isOwnMessage);
+    paintTime(painter, timeRect, option, message.timeText, isOwnMessage);
 
     painter->restore();
 }
 
 void ChatMessageDelegate::paintAvatar(QPainter *painter, const QRect &avatarRect,
-                                      const Message &message) const
+                                      const QStyleOptionViewItem &option,
+                                      const MessageRenderRecord &message) const
 {
     painter->save();
     painter->setRenderHint(QPainter::Antialiasing, true);
 
     QPixmap avatarPixmap = QPixmap();
-    if(QFileInfo::exists(message.avatar)){
+    if(message.avatarExists){
         avatarPixmap = thumbnailManager->getThumbnail(message.avatar,
                                                  avatarRect.size(), 
                                                  MediaType::Avatar, 5);
@@ -635,31 +616,24 @@ void ChatMessageDelegate::paintAvatar(QPainter *painter, const QRect &avatarRect
         painter->setBrush(QColor(210, 210, 210));
         painter->drawPath(path);
 
-        QFont iniFont = painter->font();
-        iniFont.setBold(true);
-        iniFont.setPointSize(15);
-        painter->setFont(iniFont);
+        painter->setFont(fontsFor(option).initial);
         painter->setPen(QColor(100, 100, 100));
-        QString initial = message.senderName.isEmpty() ? "U" : message.senderName.left(1);
-        painter->drawText(avatarRect, Qt::AlignCenter, initial.toUpper());
+        painter->drawText(avatarRect, Qt::AlignCenter, message.senderInitial);
     }
 
     painter->restore();
 }
 
 void ChatMessageDelegate::paintTime(QPainter *painter, const QRect &rect, const QStyleOptionViewItem &option,
-                                    const Message &message, bool isOwnMessage) const
+                                    const QString &timeText, bool isOwnMessage) const
 {
     painter->save();
     painter->setRenderHint(QPainter::Antialiasing, true);
 
     // 绘制时间戳
-    QString timeText = FormatTime(message.timestamp);
-    QFont timeFont = option.font;
-    timeFont.setPointSizeF(7.5);
-    painter->setFont(timeFont);
-    QFontMetrics timeMetrics(timeFont);
-    int timeHeight = timeMetrics.height();
+    const Fonts &fonts = fontsFor(option);
+    painter->setFont(fonts.time);
+    int timeHeight = fonts.timeHeight;
     painter->setPen(QColor(150, 150, 150));
     QRect timeRect(rect.left(), rect.top(), rect.width(), timeHeight);
 
@@ -673,7 +647,7 @@ void ChatMessageDelegate::paintTime(QPainter *painter, const QRect &rect, const
 }
 
 void ChatMessageDelegate::paintFileIcon(QPainter *painter, const QRect &fileRect,
-                                        const QString &extension) const
+                                        const QString &extension, const Fonts &fonts) const
 {
     painter->save();
     painter->setRenderHint(QPainter::Antialiasing, true);
@@ -684,22 +658,22 @@ void ChatMessageDelegate::paintFileIcon(QPainter *painter, const QRect &fileRect
     QColor iconColor;
     if (extension == "pdf") {
         iconColor = QColor(230, 67, 64);
-        typeText = "PDF";
+        typeText = QStringLiteral("PDF");
     } else if (extension == "doc" || extension == "docx") {
         iconColor = QColor(44, 86, 154);
-        typeText = "W";
+        typeText = QStringLiteral("W");
     } else if (extension == "xls" || extension == "xlsx") {
         iconColor = QColor(32, 115, 70);
-        typeText = "X";
+        typeText = QStringLiteral("X");
     } else if (extension == "ppt" || extension == "pptx") {
         iconColor = QColor(242, 97, 63);
-        typeText = "P";
+        typeText = QStringLiteral("P");
     } else if (extension == "txt") {
         iconColor = QColor(250, 157, 59);
-        typeText = "txt";
+        typeText = QStringLiteral("txt");
     } else {
         iconColor = QColor(237, 237, 237);
-        typeText = "*";
+        typeText = QStringLiteral("*");
         unknownType = true;
     }
 
@@ -744,22 +718,15 @@ void ChatMessageDelegate::paintFileIcon(QPainter *painter, const QRect &fileRect
         painter->setPen(Qt::white);
     }
 
-    QFont iconFont = painter->font();
-
     // 根据文字长度调整字体大小
-    if (typeText.length() <= 2) {
-        iconFont.setPointSize(12);
-    } else {
-        iconFont.setPointSize(8);
-    }
-
-    QFontMetrics metrics(iconFont);
-    painter->setFont(iconFont);
+    const bool shortText = typeText.size() <= 2;
+    painter->setFont(shortText ? fonts.iconLarge : fonts.iconSmall);
+    const int textHeight = shortText ? fonts.iconLargeHeight : fonts.iconSmallHeight;
 
     // 调整文字区域
     QRect textRect = fileRect;
     textRect.setBottom(textRect.bottom() - 3);
-    textRect.setTop(textRect.bottom() - metrics.height() - 3);
+    textRect.setTop(textRect.bottom() - textHeight - 3);
 
     painter->drawText(textRect, Qt::AlignHCenter, typeText);
 
@@ -855,11 +822,11 @@ void ChatMessageDelegate::paintVoiceWaveform(QPainter *painter, const QRect &rec
 }
 
 void ChatMessageDelegate::paintDurationText(QPainter *painter, const QRect &bubbleRect,
-                                            int duration, bool isOwnMessage) const
+                                            const QString &durationStr, const QFont &font,
+                                            bool isOwnMessage) const
 {
     const int playButtonSize = PLAY_BUTTON_SIZE;
-    QString durationStr = QString("%1\"") .arg(duration);
-    painter->setFont(QFont("微软雅黑", 9));
+    painter->setFont(font);
 
     if (isOwnMessage) {
         painter->setPen(Qt::white);
@@ -872,27 +839,78 @@ void ChatMessageDelegate::paintDurationText(QPainter *painter, const QRect &bubb
     }
 }
 
-QSize ChatMessageDelegate::calculateTextSize(const QString &text, const QFont &font,
-                                             int maxWidth) const
+const ChatMessageDelegate::Fonts &ChatMessageDelegate::fontsFor(const QStyleOptionViewItem &option) const
+{
+    if (m_fontsValid && option.font == m_fonts.base) return m_fonts;
+
+    // 视图字体变化时重新派生；绘制时只取引用
+    const QString family = QStringLiteral("微软雅黑");
+    m_fonts.base = option.font;
+
+    m_fonts.content = option.font;
+    m_fonts.content.setPointSizeF(10.5);
+    m_fonts.content.setFamily(family);
+
+    m_fonts.time = option.font;
+    m_fonts.time.setPointSizeF(7.5);
+    m_fonts.timeHeight = QFontMetrics(m_fonts.time).height();
+
+    m_fonts.fileName = option.font;
+    m_fonts.fileName.setPointSizeF(10.2);
+    m_fonts.fileName.setFamily(family);
+    m_fonts.fileNameHeight = QFontMetrics(m_fonts.fileName).height();
+
+    m_fonts.fileSize = option.font;
+    m_fonts.fileSize.setPointSizeF(9);
+
+    m_fonts.source = option.font;
+    m_fonts.source.setPointSizeF(8.5);
+    m_fonts.source.setFamily(family);
+
+    m_fonts.warning = option.font;
+    m_fonts.warning.setPointSizeF(9);
+    m_fonts.warning.setFamily(family);
+    m_fonts.warning.setBold(true);
+
+    m_fonts.videoDuration = option.font;
+    m_fonts.videoDuration.setPointSize(8);
+
+    m_fonts.voiceDuration = QFont(family, 9);
+
+    m_fonts.initial = option.font;
+    m_fonts.initial.setBold(true);
+    m_fonts.initial.setPointSize(15);
+
+    m_fonts.iconLarge = option.font;
+    m_fonts.iconLarge.setPointSize(12);
+    m_fonts.iconLargeHeight = QFontMetrics(m_fonts.iconLarge).height();
+    m_fonts.iconSmall = option.font;
+    m_fonts.iconSmall.setPointSize(8);
+    m_fonts.iconSmallHeight = QFontMetrics(m_fonts.iconSmall).height();
+
+    m_fontsValid = true;
+    return m_fonts;
+}
+
+int ChatMessageDelegate::maxTextWidth(const QStyleOptionViewItem &option) const
 {
-    if (text.isEmpty()) return QSize(0, 0);
-
-    QFontMetrics metrics(font);
-    QRect textRect = metrics.boundingRect(
-        QRect(0, 0, maxWidth, 0),
-        Qt::TextWordWrap | Qt::AlignLeft,
-        text
-        );
-    return textRect.size();
+    const int maxBubbleWidth = option.rect.width() * 0.6;
+    return maxBubbleWidth - 2 * BUBBLE_PADDING;
+}
+
+QSize ChatMessageDelegate::textSize(const QStyleOptionViewItem &option, const MessageRenderRecord &message) const
+{
+    textLayouts->setFont(fontsFor(option).content);
+    return textLayouts->layoutFor(message.messageId, message.content, maxTextWidth(option)).size;
 }
 
 
 QRect ChatMessageDelegate::getClickableRect(const QStyleOptionViewItem &option,
-                                            const Message &message, const bool &isOwn) const
+                                            const MessageRenderRecord &message) const
 {
     const int avatarSize = AVATAR_SIZE;
     const int margin = MARGIN;
-    bool isOwnMessage = isOwn;
+    bool isOwnMessage = message.isOwn;
 
     switch (message.type) {
     case MessageType::IMAGE:
@@ -944,15 +962,12 @@ QRect ChatMessageDelegate::getClickableRect(const QStyleOptionViewItem &option,
         const int maxBubbleWidth = option.rect.width() * 0.6;
         const int bubblePadding = BUBBLE_PADDING;
 
-        // 计算文本尺寸
-        QFont contentFont;
-        contentFont.setPointSizeF(10.5);
-        contentFont.setFamily(QStringLiteral("微软雅黑"));
-        QSize textSize = calculateTextSize(message.content, contentFont, maxBubbleWidth - 2 * bubblePadding);
+        // 文本尺寸（排版缓存）
+        const QSize size = textSize(option, message);
 
         // 计算气泡尺寸
-        int bubbleWidth = qMin(textSize.width() + 2 * bubblePadding, maxBubbleWidth);
-        int bubbleHeight = textSize.height() + 2 * bubblePadding;
+        int bubbleWidth = qMin(size.width() + 2 * bubblePadding, maxBubbleWidth);
+        int bubbleHeight = size.height() + 2 * bubblePadding;
 
         // 计算气泡位置
         QRect bubbleRect;
@@ -978,12 +993,9 @@ void ChatMessageDelegate::onMediaLoaded(const QString& resourcePath, const QPixm
     if(ChatMessageListView* view = qobject_cast<ChatMessageListView*>(parent())) {
 
         view->viewport()->update();
-        QAbstractItemModel* model = view->model();
-        if (model) {
-            QModelIndex topLeft = model->index(0, 0);
-            QModelIndex bottomRight = model->index(model->rowCount() - 1, 0);
-            emit model->dataChanged(topLeft, bottomRight);
-        }
+        // 一批缩略图连续加载完成时，每帧只发一次整表 dataChanged
+        modelUpdates->setModel(view->model());
+        modelUpdates->markAllDirty();
     }
 }
 
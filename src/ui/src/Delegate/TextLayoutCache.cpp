@@ -0,0 +1,132 @@
+#include "TextLayoutCache.h"
+#include <QTextOption>
+#include <QTimer>
+#include <QtMath>
+
+TextLayoutCache::TextLayoutCache(QObject *parent)
+    : QObject(parent)
+    , m_cache(kMaxEntries)
+{
+    // 单线程按提交顺序排版，不与缩略图解码争抢线程
+    m_pool.setMaxThreadCount(1);
+}
+
+TextLayoutCache::~TextLayoutCache()
+{
+    m_pool.waitForDone();
+}
+
+void TextLayoutCache::setFont(const QFont &font)
+{
+    if (font == m_font) return;
+    m_font = font;
+    m_cache.clear();
+    m_queued.clear();
+    m_inFlight.clear();
+    ++m_generation;
+}
+
+TextLayoutCache::TextLayout TextLayoutCache::layoutFor(qint64 messageId, const QString &text, int maxWidth)
+{
+    const int width = bucketWidth(maxWidth);
+    if (width != m_width) {
+        // 宽度档位变化：已提交的重排作废，缓存中的结果降为临时结果
+        m_width = width;
+        m_queued.clear();
+        m_inFlight.clear();
+        ++m_generation;
+    }
+
+    if (messageId <= 0) return build(text, m_font, width);
+
+    if (const Entry *entry = m_cache.object(messageId); entry && entry->text == text) {
+        if (entry->width != width) schedule(messageId, text);
+        return entry->layout;
+    }
+
+    // 首次出现：同步排版
+    Entry *entry = new Entry;
+    entry->text = text;
+    entry->width = width;
+    entry->layout = build(text, m_font, width);
+    const TextLayout result = entry->layout;
+    m_cache.insert(messageId, entry);
+    return result;
+}
+
+int TextLayoutCache::bucketWidth(int maxWidth)
+{
+    return qMax(kWidthBucket, maxWidth / kWidthBucket * kWidthBucket);
+}
+
+TextLayoutCache::TextLayout TextLayoutCache::build(const QString &text, const QFont &font, int width)
+{
+    // 与 Qt::TextWordWrap 一致：按单词边界换行
+    QTextOption option(Qt::AlignLeft);
+    option.setWrapMode(QTextOption::WordWrap);
+
+    QSharedPointer<QTextLayout> layout(new QTextLayout(text, font));
+    layout->setTextOption(option);
+    layout->setCacheEnabled(true);
+
+    qreal height = 0;
+    qreal naturalWidth = 0;
+    layout->beginLayout();
+    for (QTextLine line = layout->createLine(); line.isValid(); line = layout->createLine()) {
+        line.setLineWidth(width);
+        line.setPosition(QPointF(0, height));
+        height += line.height();
+        naturalWidth = qMax(naturalWidth, line.naturalTextWidth());
+    }
+    layout->endLayout();
+
+    TextLayout result;
+    result.layout = layout;
+    result.size = text.isEmpty() ? QSize(0, 0) : QSize(qCeil(naturalWidth), qCeil(height));
+    return result;
+}
+
+void TextLayoutCache::schedule(qint64 messageId, const QString &text)
+{
+    if (m_inFlight.contains(messageId)) return;
+    m_queued.insert(messageId, text);
+
+    // 同一轮布局中的所有临时结果合并成一批提交
+    if (!m_flushScheduled) {
+        m_flushScheduled = true;
+        QTimer::singleShot(0, this, &TextLayoutCache::flushQueue);
+    }
+}
+
+void TextLayoutCache::flushQueue()
+{
+    m_flushScheduled = false;
+    if (m_queued.isEmpty()) return;
+
+    const QHash<qint64, QString> batch = m_queued;
+    m_queued.clear();
+    for (auto it = batch.cbegin(); it != batch.cend(); ++it) m_inFlight.insert(it.key());
+
+    const QFont font = m_font;
+    const int width = m_width;
+    const quint64 generation = m_generation;
+    m_pool.start([this, batch, font, width, generation]() {
+        QHash<qint64, TextLayout> results;
+        for (auto it = batch.cbegin(); it != batch.cend(); ++it)
+            results.insert(it.key(), build(it.value(), font, width));
+
+        // 回到界面线程合并；对象析构前会等待工作线程结束
+        QMetaObject::invokeMethod(this, [this, batch, results, width, generation]() {
+            if (generation != m_generation) return;
+            for (auto it = results.cbegin(); it != results.cend(); ++it) {
+                m_inFlight.remove(it.key());
+                Entry *entry = new Entry;
+                entry->text = batch.value(it.key());
+                entry->width = width;
+                entry->layout = it.value();
+                m_cache.insert(it.key(), entry);
+            }
+            emit layoutsReady();
+        }, Qt::QueuedConnection);
+    });
+}
@@ -16,6 +16,14 @@ ChatListView::ChatListView(QWidget *parent)
 
     setUniformItemSizes(true);
     setSelectionMode(QAbstractItemView::SingleSelection); // 单选
+
+    setMouseTracking(true);
+    m_hoverPrefetchTimer = new QTimer(this);
+    m_hoverPrefetchTimer->setSingleShot(true);
+    m_hoverPrefetchTimer->setInterval(kHoverPrefetchDelayMs);
+    connect(m_hoverPrefetchTimer, &QTimer::timeout, this, [this]() {
+        requestPrefetch(m_hoverIndex);
+    });
 }
 
 ChatListView::~ChatListView()
@@ -67,6 +75,7 @@ void ChatListView::createConversationContextMenu()
     m_markAsUnreadAction = new QAction("标为未读", this);
     m_toggleMuteAction = new QAction("消息免打扰", this);
     m_openInWindowAction = new QAction("独立窗口显示", this);
+    m_exportAction = new QAction("导出聊天记录", this);
     m_deleteAction = new QAction("删除", this);
 
     // 为删除项设置特殊类名
@@ -77,6 +86,7 @@ void ChatListView::createConversationContextMenu()
     m_conversationMenu->addAction(m_toggleMuteAction);
     m_conversationMenu->addSeparator();
     m_conversationMenu->addAction(m_openInWindowAction);
+    m_conversationMenu->addAction(m_exportAction);
     m_conversationMenu->addSeparator();
     m_conversationMenu->addAction(m_deleteAction);
 
@@ -94,6 +104,9 @@ void ChatListView::createConversationContextMenu()
     connect(m_openInWindowAction, &QAction::triggered, this, [this]() {
         emit conversationOpenInWindow(m_currentConversationId);
     });
+    connect(m_exportAction, &QAction::triggered, this, [this]() {
+        emit conversationExport(m_currentConversationId);
+    });
     connect(m_deleteAction, &QAction::triggered, this, [this]() {
         showDeleteConfirmationDialog();
     });
@@ -200,6 +213,44 @@ void ChatListView::contextMenuEvent(QContextMenuEvent *event)
 }
 
 
+void ChatListView::mouseMoveEvent(QMouseEvent *event)
+{
+    CustomListView::mouseMoveEvent(event);
+
+    const QModelIndex index = indexAt(event->pos());
+    if (index != m_hoverIndex) {
+        m_hoverIndex = index;
+        if (index.isValid()) m_hoverPrefetchTimer->start();
+        else m_hoverPrefetchTimer->stop();
+    }
+}
+
+void ChatListView::leaveEvent(QEvent *event)
+{
+    CustomListView::leaveEvent(event);
+    m_hoverPrefetchTimer->stop();
+    m_hoverIndex = QModelIndex();
+}
+
+void ChatListView::currentChanged(const QModelIndex &current, const QModelIndex &previous)
+{
+    CustomListView::currentChanged(current, previous);
+    if (!current.isValid()) return;
+
+    // 键盘上下切换时，相邻会话很可能是下一个被打开的
+    requestPrefetch(current.siblingAtRow(current.row() - 1));
+    requestPrefetch(current.siblingAtRow(current.row() + 1));
+}
+
+void ChatListView::requestPrefetch(const QModelIndex &index)
+{
+    if (!index.isValid()) return;
+
+    const qint64 conversationId = index.data(ConversationIdRole).toLongLong();
+    if (conversationId > 0) emit conversationPrefetchRequested(conversationId);
+}
+
+
 Conversation ChatListView::getConversationFromIndex(const QModelIndex &index) const
 {
     Conversation conversationInfo;
@@ -219,6 +270,8 @@ Conversation ChatListView::getConversationFromIndex(const QModelIndex &index) co
     conversationInfo.lastMessageTime = index.data(LastMessageTimeRole).toLongLong();
     conversationInfo.unreadCount = index.data(UnreadCountRole).toInt();
     conversationInfo.isTop = index.data(IsTopRole).toBool();
+    conversationInfo.unreadMentionCount = index.data(UnreadMentionCountRole).toInt();
+    conversationInfo.firstUnreadMentionId = index.data(FirstUnreadMentionIdRole).toLongLong();
 
     return conversationInfo;
 }
@@ -7,6 +7,12 @@
 #include "ClickClosePopup.h"
 #include <QVBoxLayout>
 #include <QLabel>
+#include <QPainter>
+
+namespace {
+constexpr int kTimelineWidth = 4;        // 时间轴宽度
+constexpr int kTimelineRightOffset = 12; // 与右侧滚动条保持间距
+}
 
 ChatMessageListView::ChatMessageListView(QWidget *parent)
     : CustomListView(parent)
@@ -15,6 +21,9 @@ ChatMessageListView::ChatMessageListView(QWidget *parent)
     setResizeMode(QListView::Adjust);
     setSelectionMode(QAbstractItemView::NoSelection);
     setUniformItemSizes(false);
+
+    connect(verticalScrollBar(), &QScrollBar::valueChanged, this, &ChatMessageListView::reportVisibleRows);
+    connect(verticalScrollBar(), &QScrollBar::rangeChanged, this, &ChatMessageListView::reportVisibleRows);
 }
 
 ChatMessageListView::~ChatMessageListView()
@@ -37,11 +46,84 @@ void ChatMessageListView::wheelEvent(QWheelEvent *event)
         if (scrollPos < 200) {
             emit loadmoreMsg(5);
         }
+    } else if (!angleDelta.isNull() && angleDelta.y() < 0) {
+
+        // 检查是否滚动到底部附近
+        QScrollBar *scrollBar = this->verticalScrollBar();
+        if (scrollBar->maximum() - scrollBar->value() < 200) {
+            emit loadNewerMsg(20);
+        }
     }
 
     event->accept();
 }
 
+void ChatMessageListView::setModel(QAbstractItemModel *model)
+{
+    for (const QMetaObject::Connection &connection : std::as_const(m_anchorConnections)) disconnect(connection);
+    m_anchorConnections.clear();
+    m_scrollAnchor = QPersistentModelIndex();
+    m_reportedFirst = m_reportedLast = -1;
+
+    CustomListView::setModel(model);
+    if (!model) return;
+
+    m_anchorConnections << connect(model, &QAbstractItemModel::rowsAboutToBeInserted, this,
+                                   [this](const QModelIndex &parent, int start, int end) {
+                                       captureScrollAnchor(parent, start, end, false);
+                                   });
+    m_anchorConnections << connect(model, &QAbstractItemModel::rowsAboutToBeRemoved, this,
+                                   [this](const QModelIndex &parent, int start, int end) {
+                                       captureScrollAnchor(parent, start, end, true);
+                                   });
+    m_anchorConnections << connect(model, &QAbstractItemModel::rowsInserted, this,
+                                   &ChatMessageListView::restoreScrollAnchor);
+    m_anchorConnections << connect(model, &QAbstractItemModel::rowsRemoved, this,
+                                   &ChatMessageListView::restoreScrollAnchor);
+}
+
+void ChatMessageListView::captureScrollAnchor(const QModelIndex &parent, int start, int end, bool removing)
+{
+    m_scrollAnchor = QPersistentModelIndex();
+    if (parent.isValid()) return;
+
+    const QModelIndex top = indexAt(QPoint(viewport()->width() / 2, 0));
+    if (!top.isValid()) return;
+    // 插入位置不晚于首个可见行，或删除的行全部在它之上，视口内容才会被推动
+    if (removing ? top.row() <= end : top.row() < start) return;
+
+    m_scrollAnchor = top;
+    m_scrollAnchorTop = visualRect(top).top();
+}
+
+void ChatMessageListView::restoreScrollAnchor()
+{
+    if (!m_scrollAnchor.isValid()) return;
+    const QPersistentModelIndex anchor = m_scrollAnchor;
+    m_scrollAnchor = QPersistentModelIndex();
+
+    // visualRect 会先完成延迟的布局，得到插入/删除后的位置
+    QScrollBar *scrollBar = verticalScrollBar();
+    scrollBar->setValue(scrollBar->value() + visualRect(anchor).top() - m_scrollAnchorTop);
+}
+
+void ChatMessageListView::reportVisibleRows()
+{
+    if (!model()) return;
+
+    const int x = viewport()->width() / 2;
+    const QModelIndex top = indexAt(QPoint(x, 0));
+    const QModelIndex bottom = indexAt(QPoint(x, viewport()->height() - 1));
+    const int first = top.isValid() ? top.row() : -1;
+    // 最后一条消息之下还有空白时取最后一行
+    const int last = top.isValid() ? (bottom.isValid() ? bottom.row() : model()->rowCount() - 1) : -1;
+    if (first == m_reportedFirst && last == m_reportedLast) return;
+
+    m_reportedFirst = first;
+    m_reportedLast = last;
+    emit visibleRowsChanged(first, last);
+}
+
 void ChatMessageListView::createMessageContextMenu()
 {
     m_messageMenu = new QMenu(this);
@@ -215,5 +297,61 @@ void ChatMessageListView::execMessageListMenu(const QPoint& globalPos, const Mes
     m_messageMenu->exec(globalPos);
 }
 
+void ChatMessageListView::setTimeline(const QList<MessageDaySummary> &summaries)
+{
+    m_timeline = summaries;
+    m_timelineTotal = 0;
+    m_timelineMaxCount = 0;
+    for (const MessageDaySummary &summary : summaries) {
+        m_timelineTotal += summary.messageCount;
+        m_timelineMaxCount = qMax(m_timelineMaxCount, summary.messageCount);
+    }
+    viewport()->update();
+}
+
+QRect ChatMessageListView::timelineRect() const
+{
+    return QRect(viewport()->width() - kTimelineRightOffset - kTimelineWidth, 0,
+                 kTimelineWidth, viewport()->height());
+}
+
+void ChatMessageListView::paintEvent(QPaintEvent *event)
+{
+    CustomListView::paintEvent(event);
+    if (m_timeline.isEmpty() || m_timelineTotal <= 0) return;
+
+    // 每天占据的高度与消息数成正比，颜色深浅表示当天密度
+    QPainter painter(viewport());
+    const QRect rect = timelineRect();
+    int accumulated = 0;
+    for (const MessageDaySummary &summary : std::as_const(m_timeline)) {
+        const int top = rect.top() + rect.height() * accumulated / m_timelineTotal;
+        accumulated += summary.messageCount;
+        const int bottom = rect.top() + rect.height() * accumulated / m_timelineTotal;
+
+        QColor color(76, 175, 80);
+        color.setAlpha(60 + 195 * summary.messageCount / qMax(1, m_timelineMaxCount));
+        painter.fillRect(QRect(rect.left(), top, rect.width(), qMax(1, bottom - top)), color);
+    }
+}
 
+void ChatMessageListView::mousePressEvent(QMouseEvent *event)
+{
+    if (!m_timeline.isEmpty() && m_timelineTotal > 0 && event->button() == Qt::LeftButton
+        && timelineRect().adjusted(-2, 0, 2, 0).contains(event->pos())) {
+        const QRect rect = timelineRect();
+        const int target = m_timelineTotal * (event->pos().y() - rect.top()) / qMax(1, rect.height());
+        int accumulated = 0;
+        for (const MessageDaySummary &summary : std::as_const(m_timeline)) {
+            accumulated += summary.messageCount;
+            if (accumulated > target) {
+                emit jumpToDateRequested(summary.date());
+                break;
+            }
+        }
+        event->accept();
+        return;
+    }
 
+    CustomListView::mousePressEvent(event);
+}
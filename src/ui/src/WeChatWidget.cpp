@@ -31,6 +31,7 @@
 #include <QFileDialog>
 #include "MessageTextEdit.h"
 #include <QMessageBox>
+#include <QProgressDialog>
 #include "ChatListView.h"
 #include "ChatMessageListView.h"
 #include "VoiceRecordDialog.h"
@@ -99,6 +100,80 @@ WeChatWidget::WeChatWidget(AppController * appController, QWidget *parent)
     connect(chatListView, &ChatListView::conversationDelete,
             appController->conversationController(), &ConversationController::handleDelete);
 
+    connect(chatListView, &ChatListView::conversationExport,
+            this, &WeChatWidget::exportConversation);
+
+    connect(messageController, &MessageController::exportProgress,
+            this, [this](qint64 exportedCount, qint64 totalCount) {
+                if (!exportProgressDialog) return;
+                // 进度条只支持 int，按千分比显示
+                exportProgressDialog->setValue(totalCount > 0 ? int(exportedCount * 1000 / totalCount) : 0);
+                exportProgressDialog->setLabelText(QString("正在导出聊天记录 %1 / %2").arg(exportedCount).arg(totalCount));
+            });
+
+    connect(messageController, &MessageController::exportFinished,
+            this, [this](bool ok, const QString &reason, qint64 exportedCount) {
+                bool cancelled = false;
+                if (exportProgressDialog) {
+                    cancelled = exportProgressDialog->wasCanceled();
+                    exportProgressDialog->close();
+                    exportProgressDialog->deleteLater();
+                }
+                if (ok) {
+                    QMessageBox::information(this, "导出聊天记录", QString("已导出 %1 条消息").arg(exportedCount));
+                } else if (!cancelled) {
+                    QMessageBox::warning(this, "导出聊天记录", QString("导出失败：%1").arg(reason));
+                }
+            });
+
+    connect(messageController, &MessageController::importProgress,
+            this, [this](qint64 importedCount, qint64 bytesRead, qint64 bytesTotal) {
+                if (!importProgressDialog) return;
+                importProgressDialog->setValue(bytesTotal > 0 ? int(bytesRead * 1000 / bytesTotal) : 0);
+                importProgressDialog->setLabelText(QString("正在导入聊天记录，已导入 %1 条").arg(importedCount));
+            });
+
+    connect(messageController, &MessageController::importFinished,
+            this, [this](bool ok, const QString &reason, qint64 importedCount, qint64 skippedCount) {
+                bool cancelled = false;
+                if (importProgressDialog) {
+                    cancelled = importProgressDialog->wasCanceled();
+                    importProgressDialog->close();
+                    importProgressDialog->deleteLater();
+                }
+                if (ok) {
+                    QMessageBox::information(this, "导入聊天记录",
+                                             QString("已导入 %1 条消息，跳过 %2 条").arg(importedCount).arg(skippedCount));
+                } else if (cancelled) {
+                    QMessageBox::information(this, "导入聊天记录", "导入已暂停，再次导入同一文件将从中断处继续");
+                } else {
+                    QMessageBox::warning(this, "导入聊天记录", QString("导入失败：%1").arg(reason));
+                }
+            });
+
+    // 上次导入中途退出：询问是否继续
+    connect(messageController, &MessageController::pendingImportsFound,
+            this, [this](const QStringList &archivePaths) {
+                const QString path = archivePaths.first();
+                if (QMessageBox::question(this, "导入聊天记录",
+                                          QString("上次导入“%1”未完成，是否继续？").arg(QFileInfo(path).fileName()))
+                    == QMessageBox::Yes) {
+                    importHistory(path);
+                }
+            });
+    messageController->checkPendingImports();
+
+    // 未读 @ 提及：会话列表显示 [有人@我]
+    connect(messageController, &MessageController::unreadMentionsLoaded,
+            this, [this](const QList<MentionSummary> &mentions) {
+                conversationController->chatListModel()->setUnreadMentions(mentions);
+            });
+
+    connect(chatListView, &ChatListView::conversationPrefetchRequested,
+            messageController, [this](qint64 conversationId) {
+                messageController->prefetchConversation(conversationId);
+            });
+
     // 会话列表选中项改变时触发
     connect(chatListView->selectionModel(), &QItemSelectionModel::selectionChanged,
         this, [this](const QItemSelection &selected, const QItemSelection &deselected){
@@ -113,12 +188,20 @@ WeChatWidget::WeChatWidget(AppController * appController, QWidget *parent)
                 ui->rightStackedWidgetPage0->show();
 
                 messageController->setCurrentConversation(currentConversation);
+                messageController->loadTimeline();
                 conversationController->setCurrentConversationId(currentConversation.conversationId);
-                QTimer::singleShot(100, this, [=]() {
-                    if (chatMessageListView != nullptr && !chatMessageListView->isHidden()) {
-                        chatMessageListView->scrollToBottom();
-                    }
-                });
+                if (currentConversation.firstUnreadMentionId > 0) {
+                    // 有未读 @ 提及：直接定位到最早一条提及，定位完成由 jumpedToMessage 滚动
+                    messageController->loadMessagesAround(currentConversation.firstUnreadMentionId);
+                    messageController->markMentionsRead(currentConversation.conversationId);
+                    conversationController->chatListModel()->clearUnreadMentions(currentConversation.conversationId);
+                } else {
+                    QTimer::singleShot(100, this, [=]() {
+                        if (chatMessageListView != nullptr && !chatMessageListView->isHidden()) {
+                            chatMessageListView->scrollToBottom();
+                        }
+                    });
+                }
 
                 // 标记已读
                 conversationController->clearUnreadCount(currentConversation.conversationId);
@@ -135,6 +218,9 @@ WeChatWidget::WeChatWidget(AppController * appController, QWidget *parent)
             return;
         }
 
+        // 会话列表整体重建后重新标记未读 @ 提及
+        messageController->loadUnreadMentions();
+
         if (currentConversation.isValid()) {
             ChatListModel *m_model = conversationController->chatListModel();
             QModelIndex index = m_model->getConversationIndex(currentConversation.conversationId);
@@ -190,12 +276,34 @@ WeChatWidget::WeChatWidget(AppController * appController, QWidget *parent)
 
     connect(chatMessageListView, &ChatMessageListView::loadmoreMsg,
             messageController,&MessageController::loadMoreMessages);
+    connect(chatMessageListView, &ChatMessageListView::loadNewerMsg,
+            messageController,&MessageController::loadNewerMessages);
+    connect(chatMessageListView, &ChatMessageListView::visibleRowsChanged,
+            messageController->messagesModel(), &ChatMessagesModel::setVisibleRange);
+
+    // 时间轴：按天消息密度与跳转到日期
+    connect(messageController, &MessageController::timelineLoaded,
+            chatMessageListView, &ChatMessageListView::setTimeline);
+    connect(chatMessageListView, &ChatMessageListView::jumpToDateRequested, messageController,
+            [this](const QDate &date){ messageController->jumpToDate(date); });
+    connect(messageController, &MessageController::jumpedToMessage, this, [this](qint64 messageId){
+        // 锚点窗口加载完成后定位到锚点消息
+        const int row = messageController->messagesModel()->findMessageIndexById(messageId);
+        if (row >= 0) {
+            chatMessageListView->scrollTo(messageController->messagesModel()->index(row, 0),
+                                          QAbstractItemView::PositionAtTop);
+        } else {
+            chatMessageListView->scrollToTop();
+        }
+    });
 
 
-    // 保存消息时刷新会话列表，（最后一条消息和时间。）
+    // 保存消息后滚动到底部；会话列表按写入的消息就地更新最后一条消息、时间并移动该行
     connect(messageController, &MessageController::messageSaved, this, [this](){
         chatMessageListView->scrollToBottom();
-        conversationController->loadConversations(0);
+    });
+    connect(messageController, &MessageController::messageInserted, this, [this](const Message &message){
+        conversationController->handleMessageInserted(message.conversationId, message.content, message.timestamp);
     });
 
     // 点击消息时信号处理
@@ -210,16 +318,27 @@ WeChatWidget::WeChatWidget(AppController * appController, QWidget *parent)
             mediaDialog = new MediaDialog();
              mediaDialog->setAttribute(Qt::WA_DeleteOnClose);
         }
-        disconnect(messageController, &MessageController::mediaItemsLoaded, this, nullptr); //避免重复连接
-        connect(messageController, &MessageController::mediaItemsLoaded, this,
-            [this,msgId](const QList<MediaItem>& items){
+        // 只加载以点击消息为中心的窗口，浏览到边缘时再向两侧扩展
+        disconnect(messageController, &MessageController::mediaWindowLoaded, this, nullptr); //避免重复连接
+        disconnect(messageController, &MessageController::mediaPageLoaded, this, nullptr);
+        disconnect(mediaDialog, &MediaDialog::moreMediaRequested, this, nullptr);
+        connect(messageController, &MessageController::mediaWindowLoaded, this,
+            [this](qint64 anchorMessageId, const QList<MediaItem>& items, bool hasOlder, bool hasNewer){
                 if (mediaDialog) {
-                    mediaDialog->setMediaItems(items);
-                    mediaDialog->selectMediaByMessageId(msgId);
+                    mediaDialog->setMediaWindow(items, hasOlder, hasNewer);
+                    mediaDialog->selectMediaByMessageId(anchorMessageId);
                 }
         });
+        connect(messageController, &MessageController::mediaPageLoaded, this,
+            [this](bool older, const QList<MediaItem>& items, bool hasMore){
+                if (mediaDialog) mediaDialog->extendMediaWindow(older, items, hasMore);
+        });
+        connect(mediaDialog, &MediaDialog::moreMediaRequested, this,
+            [this, conversationId](bool older, const MediaItem &edge){
+                messageController->loadMoreMedia(conversationId, edge, older);
+        });
 
-        messageController->getMediaItems(conversationId);
+        messageController->loadMediaWindow(conversationId, msgId);
         mediaDialog->show();
     });
 
@@ -731,6 +850,8 @@ void WeChatWidget::on_moreToolButton_clicked()
     if(!moreDialog){
         moreDialog = new MoreDialog();
         moreDialog->setAttribute(Qt::WA_DeleteOnClose);
+        connect(moreDialog, &MoreDialog::chatHistoryManageRequested,
+                this, [this]() { importHistory(); });
         QToolButton* btn = this->findChild<QToolButton*>("moreToolButton");
         QPoint buttonPos = btn->mapToGlobal(QPoint(0,0));
         int x = buttonPos.x() + btn->width();
@@ -851,6 +972,55 @@ void WeChatWidget::on_selectFileButton_clicked()
 }
 
 
+void WeChatWidget::exportConversation(qint64 conversationId)
+{
+    if (conversationId <= 0 || exportProgressDialog) return;
+
+    const QString outputPath = QFileDialog::getSaveFileName(
+        this,
+        "导出聊天记录",
+        QDir(QDir::homePath()).absoluteFilePath(QString("chat_%1.jsonl").arg(conversationId)),
+        "JSON Lines (*.jsonl)"
+        );
+    if (outputPath.isEmpty()) return;
+
+    const bool copyMedia = QMessageBox::question(this, "导出聊天记录", "是否同时导出图片、视频和文件？")
+                           == QMessageBox::Yes;
+
+    exportProgressDialog = new QProgressDialog("正在导出聊天记录", "取消", 0, 1000, this);
+    exportProgressDialog->setWindowModality(Qt::WindowModal);
+    exportProgressDialog->setMinimumDuration(500);
+    exportProgressDialog->setAutoClose(false);
+    exportProgressDialog->setAutoReset(false);
+    connect(exportProgressDialog, &QProgressDialog::canceled,
+            messageController, &MessageController::cancelExport);
+
+    messageController->exportConversation(conversationId, outputPath, copyMedia);
+}
+
+
+void WeChatWidget::importHistory(const QString &archivePath)
+{
+    if (importProgressDialog) return;
+
+    QString path = archivePath;
+    if (path.isEmpty()) {
+        path = QFileDialog::getOpenFileName(this, "导入聊天记录", QDir::homePath(), "JSON Lines (*.jsonl)");
+        if (path.isEmpty()) return;
+    }
+
+    importProgressDialog = new QProgressDialog("正在导入聊天记录", "暂停", 0, 1000, this);
+    importProgressDialog->setWindowModality(Qt::WindowModal);
+    importProgressDialog->setMinimumDuration(500);
+    importProgressDialog->setAutoClose(false);
+    importProgressDialog->setAutoReset(false);
+    connect(importProgressDialog, &QProgressDialog::canceled,
+            messageController, &MessageController::cancelImport);
+
+    messageController->importHistory(path);
+}
+
+
 void WeChatWidget::on_sendPushButton_clicked()
 {
     QList<FileItem> fileItems = ui->sendTextEdit->getFileItems();
@@ -910,7 +1080,7 @@ void WeChatWidget::on_recordVoiceButton_clicked()
 }
 
 
-bool WeChatWidget::on_switchtoMessageInterface(Contact contact)
+bool WeChatWidget::on_switchtoMessageInterface(const Contact &contact)
 {
     ui->rightStackedWidget->setCurrentIndex(0);
     ui->leftStackedWidget->setCurrentIndex(0);
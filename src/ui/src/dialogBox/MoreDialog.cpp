@@ -6,6 +6,11 @@ MoreDialog::MoreDialog(QWidget *parent)
     , ui(new Ui::MoreDialog)
 {
     ui->setupUi(this);
+
+    connect(ui->pushButton_2, &QPushButton::clicked, this, [this]() {
+        emit chatHistoryManageRequested();
+        close();
+    });
 }
 
 MoreDialog::~MoreDialog()
@@ -9,6 +9,9 @@
 #include "MediaCache.h"
 #include "MediaItem.h"
 #include "Message.h"
+#include "MessageDaySummary.h"
+#include "ConversationStats.h"
+#include "MentionSummary.h"
 #include "User.h"
 #include "Contact.h"
 #include "Conversation.h"
@@ -43,6 +46,12 @@ int main(int argc, char *argv[])
     qRegisterMetaType<Message>("Message");
     qRegisterMetaType<QList<Message>>("QList<Message>");
 
+    qRegisterMetaType<MessageDaySummary>("MessageDaySummary");
+    qRegisterMetaType<QList<MessageDaySummary>>("QList<MessageDaySummary>");
+    qRegisterMetaType<ConversationStats>("ConversationStats");
+    qRegisterMetaType<MentionSummary>("MentionSummary");
+    qRegisterMetaType<QList<MentionSummary>>("QList<MentionSummary>");
+
     qRegisterMetaType<MediaItem>("MediaItem");
     qRegisterMetaType<QList<MediaItem>>("QList<MediaItem>");
 
@@ -20,6 +20,10 @@
 #include "ThumbnailListView.h"
 #include "ThumbnailResourceManager.h"
 
+namespace {
+constexpr int kMediaPrefetchMargin = 8; // 距窗口边缘不足该行数时预取下一页
+}
+
 MediaDialog::MediaDialog(QWidget *parent)
     : QDialog(parent)
     , ui(new Ui::MediaDialog)
@@ -448,6 +452,11 @@ void MediaDialog::playNextMedia()
     if (currentIndex.isValid()) {
         nextRow = currentIndex.row() + 1;
         if (nextRow >= rowCount) {
+            // 窗口之后还有媒体时等待加载，不回绕
+            if (m_hasNewerMedia) {
+                requestMoreMediaIfNeeded(currentIndex.row());
+                return;
+            }
             nextRow = 0;
         }
     }
@@ -471,6 +480,10 @@ void MediaDialog::playPreviousMedia()
     if(currentIndex.isValid()){
         previousRow = currentIndex.row() - 1;
         if(previousRow < 0){
+            if (m_hasOlderMedia) {
+                requestMoreMediaIfNeeded(currentIndex.row());
+                return;
+            }
             previousRow = rowCount - 1;
         }
     }
@@ -502,6 +515,8 @@ void MediaDialog::on_thumbnailPreviewButton_clicked()
 void MediaDialog::onCurrentChanged(const QModelIndex &current, const QModelIndex &previous)
 {
     if(current.isValid()){
+        requestMoreMediaIfNeeded(current.row());
+
 
         QString thumbPath = current.data(ThumbnailPreviewModel::ThumbnailPathRole).toString();
         QString sourcePath = current.data(ThumbnailPreviewModel::SourceMediaPathRole).toString();
@@ -521,9 +536,46 @@ void MediaDialog::onCurrentChanged(const QModelIndex &current, const QModelIndex
 
 void MediaDialog::setMediaItems(const QList<MediaItem>& items)
 {
+    m_hasOlderMedia = m_hasNewerMedia = false;
+    m_loadingOlderMedia = m_loadingNewerMedia = false;
     thumbnailPreview_Model->setMediaItems(items);
 }
 
+void MediaDialog::setMediaWindow(const QList<MediaItem>& items, bool hasOlder, bool hasNewer)
+{
+    setMediaItems(items);
+    m_hasOlderMedia = hasOlder;
+    m_hasNewerMedia = hasNewer;
+}
+
+void MediaDialog::extendMediaWindow(bool older, const QList<MediaItem>& items, bool hasMore)
+{
+    if (older) {
+        m_loadingOlderMedia = false;
+        m_hasOlderMedia = hasMore;
+        thumbnailPreview_Model->prependMediaItems(items);
+    } else {
+        m_loadingNewerMedia = false;
+        m_hasNewerMedia = hasMore;
+        thumbnailPreview_Model->appendMediaItems(items);
+    }
+}
+
+void MediaDialog::requestMoreMediaIfNeeded(int row)
+{
+    const int rowCount = thumbnailPreview_Model->rowCount();
+    if (rowCount == 0) return;
+
+    if (m_hasOlderMedia && !m_loadingOlderMedia && row < kMediaPrefetchMargin) {
+        m_loadingOlderMedia = true;
+        emit moreMediaRequested(true, thumbnailPreview_Model->mediaItemAt(0));
+    }
+    if (m_hasNewerMedia && !m_loadingNewerMedia && row >= rowCount - kMediaPrefetchMargin) {
+        m_loadingNewerMedia = true;
+        emit moreMediaRequested(false, thumbnailPreview_Model->mediaItemAt(rowCount - 1));
+    }
+}
+
 void MediaDialog::selectMediaByMessageId(qint64 messageId)
 {
     if (!thumbnailPreview_Model) {
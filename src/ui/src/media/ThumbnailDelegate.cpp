@@ -7,6 +7,7 @@
 #include <QAbstractItemView>
 #include <QPainterPath>
 #include "MediaItem.h"
+#include "ModelUpdateScheduler.h"
 
 ThumbnailDelegate::ThumbnailDelegate(QObject *parent)
     : QStyledItemDelegate(parent),
@@ -16,6 +17,7 @@ ThumbnailDelegate::ThumbnailDelegate(QObject *parent)
     mediaManager = ThumbnailResourceManager::instance();
     connect(mediaManager, &ThumbnailResourceManager::mediaLoaded,
             this, &ThumbnailDelegate::onMediaLoaded);
+    modelUpdates = new ModelUpdateScheduler(nullptr, this);
 }
 
 void ThumbnailDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const
@@ -138,11 +140,8 @@ void ThumbnailDelegate::onMediaLoaded(const QString& resourcePath, const QPixmap
     if(QAbstractItemView* view = qobject_cast<QAbstractItemView*>(parent())) {
 
         view->viewport()->update();
-        QAbstractItemModel* model = view->model();
-        if (model) {
-            QModelIndex topLeft = model->index(0, 0);
-            QModelIndex bottomRight = model->index(model->rowCount() - 1, 0);
-            emit model->dataChanged(topLeft, bottomRight);
-        }
+        // 一批缩略图连续加载完成时，每帧只发一次整表 dataChanged
+        modelUpdates->setModel(view->model());
+        modelUpdates->markAllDirty();
     }
 }
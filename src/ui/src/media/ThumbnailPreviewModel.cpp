@@ -95,6 +95,29 @@ void ThumbnailPreviewModel::setMediaItems(const QList<MediaItem>& items)
     endResetModel();
 }
 
+void ThumbnailPreviewModel::prependMediaItems(const QList<MediaItem>& items)
+{
+    if (items.isEmpty()) return;
+    beginInsertRows(QModelIndex(), 0, items.count() - 1);
+    m_mediaItems = items + m_mediaItems;
+    endInsertRows();
+}
+
+void ThumbnailPreviewModel::appendMediaItems(const QList<MediaItem>& items)
+{
+    if (items.isEmpty()) return;
+    beginInsertRows(QModelIndex(), m_mediaItems.count(), m_mediaItems.count() + items.count() - 1);
+    m_mediaItems.append(items);
+    endInsertRows();
+}
+
+MediaItem ThumbnailPreviewModel::mediaItemAt(int row) const
+{
+    if (row < 0 || row >= m_mediaItems.count())
+        return MediaItem();
+    return m_mediaItems.at(row);
+}
+
 
 QHash<int, QByteArray> ThumbnailPreviewModel::roleNames() const
 {
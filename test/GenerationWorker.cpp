@@ -68,7 +68,7 @@ GenerationWorker::~GenerationWorker()
     delete m_contactTable;
 }
 
-void GenerationWorker::sendMsg(QVector<Message> messages){
+void GenerationWorker::sendMsg(const QVector<Message> &messages){
     if(m_id.isEmpty()||m_key.isEmpty()) return;
 
     doubao->setID(m_id);
@@ -24,7 +24,7 @@ public:
     // 初始化数据库连接
     bool initDatabase();
 
-    void sendMsg(QVector<Message> messages);
+    void sendMsg(const QVector<Message> &messages);
     QString buildPrompt(const QVector<Message> &messages);
 
 public slots:
@@ -53,7 +53,7 @@ signals:
     void errorOccurred(const QString& error);
 
     // 响应消息
-    void reaction(Message msg);
+    void reaction(const Message &msg);
 private:
     // 生成单个用户
     User generateSingleUser();